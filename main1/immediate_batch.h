@@ -0,0 +1,213 @@
+#pragma once
+// Capa de emulación del modo inmediato (glBegin/glVertex*/glColor*/glEnd) con agrupamiento.
+// En vez de enviar cada vértice al driver con una llamada, los vértices se acumulan en un
+// flujo del lado del cliente y las primitivas consecutivas compatibles se dibujan juntas con
+// una sola subida y un solo glDrawArrays por lote.
+//
+// Uso como reemplazo directo: definir IMM_BATCH antes de incluir este archivo. Las llamadas
+// glBegin/glVertex*/glColor*/glEnd se redirigen a la capa, y glClear, glFlush, glFinish y
+// glutSwapBuffers vacían primero los lotes pendientes. Cualquier otro cambio de estado
+// (glEnable, glLineWidth, matrices...) debe ir precedido de immFlush().
+//
+// Por defecto el lote se envía con arreglos de vértices del cliente (OpenGL 1.1, disponible
+// en cualquier plataforma). Con IMM_BATCH_VBO se sube a un VBO de streaming; requiere las
+// funciones de OpenGL 1.5 (por ejemplo GL_GLEXT_PROTOTYPES en Linux o GLEW en Windows).
+
+#include <GL/glut.h>
+#include <cstddef>
+#include <vector>
+
+struct ImmVertex {
+    float x, y, z;
+    float r, g, b, a;
+};
+
+struct ImmStats {
+    unsigned long vertices = 0;    // Vértices recibidos por glVertex*
+    unsigned long primitives = 0;  // Pares glBegin/glEnd
+    unsigned long draws = 0;       // Llamadas reales a glDrawArrays
+};
+
+class ImmBatcher {
+public:
+    void begin(GLenum mode) {
+        primitiveMode = mode;
+        primitiveStart = scratch.size();
+        ++stats.primitives;
+    }
+
+    void vertex(float x, float y, float z) {
+        scratch.push_back({ x, y, z, color[0], color[1], color[2], color[3] });
+        ++stats.vertices;
+    }
+
+    void setColor(float r, float g, float b, float a) {
+        color[0] = r;
+        color[1] = g;
+        color[2] = b;
+        color[3] = a;
+    }
+
+    // Convierte la primitiva recién terminada a su modo base (triángulos, líneas o puntos) y
+    // la agrega al lote; si el modo base cambia, el lote anterior se dibuja primero.
+    void end() {
+        GLenum base = baseMode(primitiveMode);
+        if (!batch.empty() && base != batchMode)
+            flush();
+        batchMode = base;
+
+        const ImmVertex* v = scratch.data() + primitiveStart;
+        size_t n = scratch.size() - primitiveStart;
+        switch (primitiveMode) {
+        case GL_TRIANGLES:
+            batch.insert(batch.end(), v, v + n - n % 3);
+            break;
+        case GL_LINES:
+            batch.insert(batch.end(), v, v + n - n % 2);
+            break;
+        case GL_POINTS:
+            batch.insert(batch.end(), v, v + n);
+            break;
+        case GL_TRIANGLE_STRIP:
+            for (size_t i = 2; i < n; ++i) {
+                // Alternar el orden para conservar la orientación de cada triángulo
+                bool odd = i % 2 == 1;
+                emitTriangle(v[odd ? i - 1 : i - 2], v[odd ? i - 2 : i - 1], v[i]);
+            }
+            break;
+        case GL_TRIANGLE_FAN:
+        case GL_POLYGON:
+            for (size_t i = 2; i < n; ++i)
+                emitTriangle(v[0], v[i - 1], v[i]);
+            break;
+        case GL_QUADS:
+            for (size_t i = 0; i + 3 < n; i += 4) {
+                emitTriangle(v[i], v[i + 1], v[i + 2]);
+                emitTriangle(v[i], v[i + 2], v[i + 3]);
+            }
+            break;
+        case GL_QUAD_STRIP:
+            for (size_t i = 0; i + 3 < n; i += 2) {
+                emitTriangle(v[i], v[i + 1], v[i + 3]);
+                emitTriangle(v[i], v[i + 3], v[i + 2]);
+            }
+            break;
+        case GL_LINE_STRIP:
+        case GL_LINE_LOOP:
+            for (size_t i = 1; i < n; ++i) {
+                batch.push_back(v[i - 1]);
+                batch.push_back(v[i]);
+            }
+            if (primitiveMode == GL_LINE_LOOP && n > 2) {
+                batch.push_back(v[n - 1]);
+                batch.push_back(v[0]);
+            }
+            break;
+        }
+        scratch.clear();
+    }
+
+    // Dibuja el lote pendiente con una sola llamada.
+    void flush() {
+        if (batch.empty())
+            return;
+        const GLsizei stride = sizeof(ImmVertex);
+#ifdef IMM_BATCH_VBO
+        if (!vbo)
+            glGenBuffers(1, &vbo);
+        glBindBuffer(GL_ARRAY_BUFFER, vbo);
+        size_t bytes = batch.size() * sizeof(ImmVertex);
+        if (bytes > vboCapacity) {
+            vboCapacity = bytes * 2;
+            glBufferData(GL_ARRAY_BUFFER, vboCapacity, nullptr, GL_STREAM_DRAW);
+        } else {
+            glBufferData(GL_ARRAY_BUFFER, vboCapacity, nullptr, GL_STREAM_DRAW); // Huérfano: evita esperar a la GPU
+        }
+        glBufferSubData(GL_ARRAY_BUFFER, 0, bytes, batch.data());
+        const char* base = nullptr;
+#else
+        const char* base = reinterpret_cast<const char*>(batch.data());
+#endif
+        glEnableClientState(GL_VERTEX_ARRAY);
+        glEnableClientState(GL_COLOR_ARRAY);
+        glVertexPointer(3, GL_FLOAT, stride, base + offsetof(ImmVertex, x));
+        glColorPointer(4, GL_FLOAT, stride, base + offsetof(ImmVertex, r));
+        glDrawArrays(batchMode, 0, static_cast<GLsizei>(batch.size()));
+        glDisableClientState(GL_COLOR_ARRAY);
+        glDisableClientState(GL_VERTEX_ARRAY);
+#ifdef IMM_BATCH_VBO
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+#endif
+        // Tras dibujar con un arreglo de colores el color actual queda indefinido
+        glColor4f(color[0], color[1], color[2], color[3]);
+        ++stats.draws;
+        batch.clear();
+    }
+
+    ImmStats stats;
+
+private:
+    static GLenum baseMode(GLenum mode) {
+        switch (mode) {
+        case GL_POINTS:
+            return GL_POINTS;
+        case GL_LINES:
+        case GL_LINE_STRIP:
+        case GL_LINE_LOOP:
+            return GL_LINES;
+        default:
+            return GL_TRIANGLES;
+        }
+    }
+
+    void emitTriangle(const ImmVertex& a, const ImmVertex& b, const ImmVertex& c) {
+        batch.push_back(a);
+        batch.push_back(b);
+        batch.push_back(c);
+    }
+
+    std::vector<ImmVertex> scratch; // Vértices de la primitiva en curso
+    std::vector<ImmVertex> batch;   // Vértices ya convertidos al modo base del lote
+    GLenum primitiveMode = GL_TRIANGLES;
+    GLenum batchMode = GL_TRIANGLES;
+    size_t primitiveStart = 0;
+    float color[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+#ifdef IMM_BATCH_VBO
+    GLuint vbo = 0;
+    size_t vboCapacity = 0;
+#endif
+};
+
+// Instancia global que usan las funciones de reemplazo.
+inline ImmBatcher immBatcher;
+
+inline void immBegin(GLenum mode) { immBatcher.begin(mode); }
+inline void immEnd() { immBatcher.end(); }
+inline void immFlush() { immBatcher.flush(); }
+inline void immVertex2f(float x, float y) { immBatcher.vertex(x, y, 0.0f); }
+inline void immVertex3f(float x, float y, float z) { immBatcher.vertex(x, y, z); }
+inline void immVertex2fv(const float* v) { immBatcher.vertex(v[0], v[1], 0.0f); }
+inline void immVertex3fv(const float* v) { immBatcher.vertex(v[0], v[1], v[2]); }
+inline void immColor3f(float r, float g, float b) { immBatcher.setColor(r, g, b, 1.0f); }
+inline void immColor4f(float r, float g, float b, float a) { immBatcher.setColor(r, g, b, a); }
+inline void immColor3fv(const float* c) { immBatcher.setColor(c[0], c[1], c[2], 1.0f); }
+inline void immColor3ub(GLubyte r, GLubyte g, GLubyte b) { immBatcher.setColor(r / 255.0f, g / 255.0f, b / 255.0f, 1.0f); }
+
+// Macros de reemplazo. Son macros con argumentos, así que escribir el nombre entre paréntesis,
+// por ejemplo (glBegin)(GL_TRIANGLES), sigue llamando a la función nativa.
+#ifdef IMM_BATCH
+#define glBegin(mode) immBegin(mode)
+#define glEnd() immEnd()
+#define glVertex2f(x, y) immVertex2f(x, y)
+#define glVertex3f(x, y, z) immVertex3f(x, y, z)
+#define glVertex2fv(v) immVertex2fv(v)
+#define glVertex3fv(v) immVertex3fv(v)
+#define glColor3f(r, g, b) immColor3f(r, g, b)
+#define glColor4f(r, g, b, a) immColor4f(r, g, b, a)
+#define glColor3fv(c) immColor3fv(c)
+#define glColor3ub(r, g, b) immColor3ub(r, g, b)
+#define glClear(mask) (immFlush(), (glClear)(mask))
+#define glFlush() (immFlush(), (glFlush)())
+#define glFinish() (immFlush(), (glFinish)())
+#define glutSwapBuffers() (immFlush(), (glutSwapBuffers)())
+#endif
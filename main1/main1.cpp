@@ -1,4 +1,9 @@
 #include <GL/glut.h>  // Incluye la biblioteca GLUT para gestionar ventanas y dibujar gráficos en OpenGL.
+#define IMM_BATCH        // Redirige glBegin/glVertex/glEnd a la capa de agrupamiento.
+#include "immediate_batch.h" // Emulación del modo inmediato que agrupa los vértices en lotes.
+#include <chrono>        // Reloj para medir el benchmark.
+#include <cstdio>        // printf para el informe del benchmark.
+#include <cstring>       // strcmp para leer los argumentos.
 
 // Función de callback que se encarga de renderizar la escena.
 void d() {
@@ -20,6 +25,67 @@ void d() {
     glFlush();
 }
 
+// Dibuja una cuadrícula de triángulos pequeños al estilo de las herramientas heredadas: un par
+// glBegin/glEnd y un color por triángulo. Los nombres entre paréntesis evitan las macros de la
+// capa de agrupamiento y llaman directamente al modo inmediato nativo.
+void drawGridNative(int side) {
+    float cell = 2.0f / side;
+    for (int j = 0; j < side; ++j) {
+        for (int i = 0; i < side; ++i) {
+            float x = -1.0f + i * cell, y = -1.0f + j * cell;
+            (glBegin)(GL_TRIANGLES);
+            (glColor3f)(i / (float)side, j / (float)side, 0.5f);
+            (glVertex2f)(x, y);
+            (glVertex2f)(x + cell, y);
+            (glVertex2f)(x + cell * 0.5f, y + cell);
+            (glEnd)();
+        }
+    }
+}
+
+// El mismo dibujo, pero pasando por la capa de agrupamiento.
+void drawGridBatched(int side) {
+    float cell = 2.0f / side;
+    for (int j = 0; j < side; ++j) {
+        for (int i = 0; i < side; ++i) {
+            float x = -1.0f + i * cell, y = -1.0f + j * cell;
+            glBegin(GL_TRIANGLES);
+            glColor3f(i / (float)side, j / (float)side, 0.5f);
+            glVertex2f(x, y);
+            glVertex2f(x + cell, y);
+            glVertex2f(x + cell * 0.5f, y + cell);
+            glEnd();
+        }
+    }
+}
+
+// Compara los vértices por segundo del modo inmediato nativo contra la capa de agrupamiento.
+void runImmediateBenchmark(int side, int frames) {
+    const char* names[2] = { "nativo", "agrupado" };
+    double verticesPerSecond[2];
+    for (int mode = 0; mode < 2; ++mode) {
+        ImmStats before = immBatcher.stats;
+        auto start = std::chrono::steady_clock::now();
+        for (int f = 0; f < frames; ++f) {
+            glClear(GL_COLOR_BUFFER_BIT);
+            if (mode == 0)
+                drawGridNative(side);
+            else
+                drawGridBatched(side);
+            glFinish(); // Incluye el trabajo de la GPU en la medición
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        verticesPerSecond[mode] = 3.0 * side * side * frames / seconds;
+        std::printf("Modo inmediato %s: %.2f Mvértices/s (%.2f ms por fotograma",
+                    names[mode], verticesPerSecond[mode] / 1e6, seconds * 1000.0 / frames);
+        if (mode == 1)
+            std::printf(", %lu llamadas de dibujo por fotograma", (immBatcher.stats.draws - before.draws) / frames);
+        std::printf(")\n");
+    }
+    std::printf("Aceleración: %.2fx con %d triángulos por fotograma (%s)\n",
+                verticesPerSecond[1] / verticesPerSecond[0], side * side, (const char*)glGetString(GL_RENDERER));
+}
+
 // Función principal del programa.
 int main(int argc, char** argv) {
     // Inicializa GLUT y procesa cualquier argumento que pueda ser necesario.
@@ -34,6 +100,12 @@ int main(int argc, char** argv) {
     // Crea una ventana con el título "Triángulo Simple".
     glutCreateWindow("Triangulo Simple");
 
+    // Con --bench se mide la capa de agrupamiento contra el modo inmediato nativo y se sale.
+    if (argc > 1 && !std::strcmp(argv[1], "--bench")) {
+        runImmediateBenchmark(200, 50);
+        return 0;
+    }
+
     // Establece la función de display (renderizado), que se llama cada vez que es necesario redibujar.
     glutDisplayFunc(d);
 
@@ -175,6 +175,9 @@ int main() {
     }
 
     // Limpiar y terminar
+    glDeleteVertexArrays(1, &VAO);
+    glDeleteBuffers(1, &VBO);
+    glDeleteProgram(shaderProgram);
     glfwTerminate();
     return 0;
 }
\ No newline at end of file
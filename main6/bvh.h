@@ -0,0 +1,616 @@
+#pragma once
+// Jerarquía de volúmenes envolventes (BVH) para consultas de rayos: selección con el ratón,
+// líneas de visión y sombras del horneado de iluminación.
+//  - Construcción con SAH por bins (16 bins por eje); los subárboles grandes se construyen en
+//    hilos separados.
+//  - Reajuste (refit) de abajo hacia arriba para objetos que se mueven sin reconstruir.
+//  - Consultas por paquetes de 4 u 8 rayos en formato SoA: cada nodo y cada triángulo se
+//    prueban contra 4 rayos a la vez con SSE (con una versión escalar si no está disponible).
+
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <thread>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#include <emmintrin.h>
+#define BVH_SSE 1
+#endif
+
+struct Aabb {
+    glm::vec3 min = glm::vec3(std::numeric_limits<float>::max());
+    glm::vec3 max = glm::vec3(-std::numeric_limits<float>::max());
+
+    void grow(const glm::vec3& p) {
+        min = glm::min(min, p);
+        max = glm::max(max, p);
+    }
+    void grow(const Aabb& b) {
+        min = glm::min(min, b.min);
+        max = glm::max(max, b.max);
+    }
+    glm::vec3 center() const { return (min + max) * 0.5f; }
+    float area() const {
+        glm::vec3 e = max - min;
+        return e.x < 0.0f ? 0.0f : 2.0f * (e.x * e.y + e.y * e.z + e.z * e.x);
+    }
+};
+
+// Nodo de 32 bytes. Si count > 0 es una hoja con las primitivas [first, first + count) de
+// primitiveOrder(); si no, sus hijos son los nodos first y first + 1.
+struct BvhNode {
+    glm::vec3 boundsMin;
+    uint32_t first;
+    glm::vec3 boundsMax;
+    uint32_t count;
+};
+
+// BVH sobre cajas arbitrarias (triángulos u objetos completos de la escena).
+class Bvh {
+public:
+    static const int kBins = 16;
+    static const uint32_t kMaxLeafSize = 8;
+    // Un corte SAH puede dejar pocas primitivas de un lado en cada nivel (triángulos muy
+    // agrupados o en progresión geométrica). Desde kMedianSplitDepth se corta por la mediana y en
+    // kMaxDepth se fuerza una hoja, así las pilas de recorrido de tamaño fijo siempre alcanzan.
+    static const unsigned kMedianSplitDepth = 32;
+    static const unsigned kMaxDepth = 48;
+
+    // threads = 0 usa todos los núcleos disponibles.
+    void build(const std::vector<Aabb>& primitiveBounds, unsigned threads = 0) {
+        size_t count = primitiveBounds.size();
+        order.resize(count);
+        centroids.resize(count);
+        for (size_t i = 0; i < count; ++i) {
+            order[i] = static_cast<uint32_t>(i);
+            centroids[i] = primitiveBounds[i].center();
+        }
+        nodes.assign(std::max<size_t>(1, 2 * count), BvhNode());
+        nodeCount = 1;
+        if (threads == 0)
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        spawnDepth = 0;
+        while ((1u << spawnDepth) < threads)
+            ++spawnDepth;
+
+        bounds = &primitiveBounds;
+        if (count == 0) {
+            nodes[0] = { glm::vec3(0.0f), 0, glm::vec3(0.0f), 0 };
+        } else {
+            buildNode(0, 0, static_cast<uint32_t>(count), 0);
+        }
+        nodes.resize(nodeCount);
+        nodes.shrink_to_fit();
+        centroids.clear();
+        centroids.shrink_to_fit();
+        bounds = nullptr;
+    }
+
+    // Recalcula las cajas con la misma topología. Los hijos siempre tienen índices mayores que
+    // su padre, así que basta un recorrido en orden inverso.
+    void refit(const std::vector<Aabb>& primitiveBounds) {
+        for (size_t n = nodes.size(); n-- > 0;) {
+            BvhNode& node = nodes[n];
+            Aabb box;
+            if (node.count > 0) {
+                for (uint32_t i = 0; i < node.count; ++i)
+                    box.grow(primitiveBounds[order[node.first + i]]);
+            } else {
+                box.grow(Aabb{ nodes[node.first].boundsMin, nodes[node.first].boundsMax });
+                box.grow(Aabb{ nodes[node.first + 1].boundsMin, nodes[node.first + 1].boundsMax });
+            }
+            node.boundsMin = box.min;
+            node.boundsMax = box.max;
+        }
+    }
+
+    const std::vector<BvhNode>& nodeArray() const { return nodes; }
+    const std::vector<uint32_t>& primitiveOrder() const { return order; }
+
+    // Recorre de más cercano a más lejano las hojas cuyo volumen cruza el rayo y llama a
+    // leaf(first, count) en cada una. leaf puede reducir tmax para podar el resto del recorrido.
+    template <typename LeafFn>
+    void traverseRay(const glm::vec3& origin, const glm::vec3& direction, float& tmax, LeafFn&& leaf) const {
+        glm::vec3 inv(1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z);
+        struct Pending {
+            uint32_t node;
+            float tnear;
+        };
+        Pending stack[kMaxDepth + 2]; // Profundidad acotada en buildNode
+        int top = 0;
+        uint32_t current = 0;
+        if (slabDistance(nodes[0], origin, inv, tmax) == kMiss)
+            return;
+        for (;;) {
+            const BvhNode& node = nodes[current];
+            if (node.count > 0) {
+                leaf(node.first, node.count);
+            } else {
+                // Probar ambos hijos: bajar por el más cercano y apilar el otro con su distancia
+                float nearA = slabDistance(nodes[node.first], origin, inv, tmax);
+                float nearB = slabDistance(nodes[node.first + 1], origin, inv, tmax);
+                uint32_t a = node.first, b = node.first + 1;
+                if (nearB < nearA) {
+                    std::swap(nearA, nearB);
+                    std::swap(a, b);
+                }
+                if (nearA != kMiss) {
+                    if (nearB != kMiss)
+                        stack[top++] = { b, nearB };
+                    current = a;
+                    continue;
+                }
+            }
+            // Siguiente pendiente que siga estando antes del impacto más cercano
+            while (top > 0 && stack[top - 1].tnear > tmax)
+                --top;
+            if (top == 0)
+                return;
+            current = stack[--top].node;
+        }
+    }
+
+protected:
+    static constexpr float kMiss = std::numeric_limits<float>::infinity();
+
+    // Distancias a los dos planos de la caja en un eje. Con la dirección nula en ese eje y el
+    // origen justo sobre un plano, 0 * inf da NaN: el rayo corre por el plano, así que toda la
+    // recta queda dentro de la franja.
+    static void slabAxis(float lo, float hi, float o, float inv, float& t0, float& t1) {
+        t0 = (lo - o) * inv;
+        t1 = (hi - o) * inv;
+        if (std::isnan(t0) || std::isnan(t1)) {
+            t0 = -kMiss;
+            t1 = kMiss;
+        }
+    }
+
+#ifdef BVH_SSE
+    // slabAxis en 4 carriles
+    static void slabAxis4(__m128& t0, __m128& t1) {
+        __m128 parallel = _mm_cmpunord_ps(t0, t1);
+        t0 = _mm_or_ps(_mm_andnot_ps(parallel, t0), _mm_and_ps(parallel, _mm_set1_ps(-kMiss)));
+        t1 = _mm_or_ps(_mm_andnot_ps(parallel, t1), _mm_and_ps(parallel, _mm_set1_ps(kMiss)));
+    }
+#endif
+
+    // Distancia de entrada del rayo a la caja del nodo, o kMiss si no la cruza antes de tmax.
+    static float slabDistance(const BvhNode& node, const glm::vec3& o, const glm::vec3& inv, float tmax) {
+        float tx0, tx1, ty0, ty1, tz0, tz1;
+        slabAxis(node.boundsMin.x, node.boundsMax.x, o.x, inv.x, tx0, tx1);
+        slabAxis(node.boundsMin.y, node.boundsMax.y, o.y, inv.y, ty0, ty1);
+        slabAxis(node.boundsMin.z, node.boundsMax.z, o.z, inv.z, tz0, tz1);
+        float tnear = std::max(std::max(std::min(tx0, tx1), std::min(ty0, ty1)), std::max(std::min(tz0, tz1), 0.0f));
+        float tfar = std::min(std::min(std::max(tx0, tx1), std::max(ty0, ty1)), std::min(std::max(tz0, tz1), tmax));
+        return tnear <= tfar ? tnear : kMiss;
+    }
+
+    std::vector<BvhNode> nodes;
+    std::vector<uint32_t> order;
+
+private:
+    struct Bin {
+        Aabb box;
+        uint32_t count = 0;
+    };
+
+    void buildNode(uint32_t nodeIndex, uint32_t begin, uint32_t end, unsigned depth) {
+        const std::vector<Aabb>& prims = *bounds;
+        Aabb box, centroidBox;
+        for (uint32_t i = begin; i < end; ++i) {
+            box.grow(prims[order[i]]);
+            centroidBox.grow(centroids[order[i]]);
+        }
+        BvhNode& node = nodes[nodeIndex];
+        node.boundsMin = box.min;
+        node.boundsMax = box.max;
+        uint32_t count = end - begin;
+        if (depth >= kMaxDepth) {
+            node.first = begin;
+            node.count = count;
+            return;
+        }
+        bool medianSplit = depth >= kMedianSplitDepth;
+
+        int splitAxis = -1;
+        float splitPos = 0.0f;
+        float splitCost = std::numeric_limits<float>::max();
+        if (count > 1 && !medianSplit) {
+            for (int axis = 0; axis < 3; ++axis) {
+                float lo = centroidBox.min[axis], hi = centroidBox.max[axis];
+                if (hi - lo < 1e-12f)
+                    continue;
+                Bin bins[kBins];
+                float scale = kBins / (hi - lo);
+                for (uint32_t i = begin; i < end; ++i) {
+                    int b = std::min(kBins - 1, static_cast<int>((centroids[order[i]][axis] - lo) * scale));
+                    bins[b].box.grow(prims[order[i]]);
+                    ++bins[b].count;
+                }
+                // Barrido desde ambos lados para evaluar las kBins - 1 posiciones de corte
+                float leftArea[kBins - 1];
+                uint32_t leftCount[kBins - 1];
+                Aabb accum;
+                uint32_t running = 0;
+                for (int b = 0; b < kBins - 1; ++b) {
+                    accum.grow(bins[b].box);
+                    running += bins[b].count;
+                    leftArea[b] = accum.area();
+                    leftCount[b] = running;
+                }
+                accum = Aabb();
+                running = 0;
+                for (int b = kBins - 1; b > 0; --b) {
+                    accum.grow(bins[b].box);
+                    running += bins[b].count;
+                    float cost = leftArea[b - 1] * leftCount[b - 1] + accum.area() * running;
+                    if (leftCount[b - 1] > 0 && running > 0 && cost < splitCost) {
+                        splitCost = cost;
+                        splitAxis = axis;
+                        splitPos = lo + b / scale;
+                    }
+                }
+            }
+        }
+
+        // Costo SAH de la hoja frente al del corte (recorrido = 1, intersección = 1)
+        float leafCost = static_cast<float>(count);
+        float parentArea = std::max(box.area(), 1e-20f);
+        bool makeLeaf = splitAxis < 0 || (count <= kMaxLeafSize && 1.0f + splitCost / parentArea >= leafCost);
+        if (makeLeaf && count <= kMaxLeafSize) {
+            node.first = begin;
+            node.count = count;
+            return;
+        }
+
+        uint32_t mid;
+        if (medianSplit) {
+            // Mitad y mitad sobre el eje más largo de los centroides
+            glm::vec3 extent = centroidBox.max - centroidBox.min;
+            int axis = extent.x >= extent.y && extent.x >= extent.z ? 0 : (extent.y >= extent.z ? 1 : 2);
+            mid = begin + count / 2;
+            std::nth_element(order.begin() + begin, order.begin() + mid, order.begin() + end,
+                             [&](uint32_t a, uint32_t b) { return centroids[a][axis] < centroids[b][axis]; });
+        } else if (splitAxis >= 0) {
+            auto middle = std::partition(order.begin() + begin, order.begin() + end,
+                                         [&](uint32_t p) { return centroids[p][splitAxis] < splitPos; });
+            mid = static_cast<uint32_t>(middle - order.begin());
+        } else {
+            mid = begin; // Todos los centroides coinciden
+        }
+        if (mid == begin || mid == end)
+            mid = begin + count / 2; // Corte degenerado: dividir por la mitad
+
+        uint32_t left = nodeCount.fetch_add(2);
+        node.first = left;
+        node.count = 0;
+
+        // Los subárboles grandes de los primeros niveles se construyen en paralelo
+        if (depth < spawnDepth && count > 4096) {
+            std::thread worker(&Bvh::buildNode, this, left, begin, mid, depth + 1);
+            buildNode(left + 1, mid, end, depth + 1);
+            worker.join();
+        } else {
+            buildNode(left, begin, mid, depth + 1);
+            buildNode(left + 1, mid, end, depth + 1);
+        }
+    }
+
+    std::vector<glm::vec3> centroids;
+    const std::vector<Aabb>* bounds = nullptr;
+    std::atomic<uint32_t> nodeCount{ 0 };
+    unsigned spawnDepth = 0;
+};
+
+struct RayHit {
+    float t;
+    uint32_t triangle; // Índice del triángulo original o kNoHit
+    float u, v;        // Coordenadas baricéntricas
+};
+
+const uint32_t kNoHit = 0xFFFFFFFFu;
+
+// Paquete de N rayos en formato SoA (N múltiplo de 4: cada grupo de 4 carriles es un registro).
+template <int N>
+struct alignas(16) RayPacket {
+    static_assert(N % 4 == 0, "los paquetes se procesan en grupos de 4 rayos");
+    alignas(16) float ox[N], oy[N], oz[N];
+    alignas(16) float dx[N], dy[N], dz[N];
+    alignas(16) float tmax[N];
+    alignas(16) uint32_t triangle[N];
+    alignas(16) float u[N], v[N];
+
+    void set(int lane, const glm::vec3& origin, const glm::vec3& direction, float maxDistance) {
+        ox[lane] = origin.x; oy[lane] = origin.y; oz[lane] = origin.z;
+        dx[lane] = direction.x; dy[lane] = direction.y; dz[lane] = direction.z;
+        tmax[lane] = maxDistance;
+        triangle[lane] = kNoHit;
+    }
+};
+
+// BVH de triángulos. Los triángulos se guardan reordenados según las hojas para que cada
+// hoja lea memoria contigua.
+class TriangleBvh : public Bvh {
+public:
+    // positions tiene 3 vértices por triángulo.
+    void build(const std::vector<glm::vec3>& positions, unsigned threads = 0) {
+        std::vector<Aabb> boxes = triangleBounds(positions);
+        Bvh::build(boxes, threads);
+        storeTriangles(positions);
+    }
+
+    // Reajusta las cajas tras mover vértices (misma cantidad de triángulos).
+    void refit(const std::vector<glm::vec3>& positions) {
+        Bvh::refit(triangleBounds(positions));
+        storeTriangles(positions);
+    }
+
+    size_t triangleCount() const { return v0.size(); }
+
+    // Rayo individual: devuelve el impacto más cercano antes de tmax.
+    bool intersect(const glm::vec3& origin, const glm::vec3& direction, float tmax, RayHit& hit) const {
+        hit = { tmax, kNoHit, 0.0f, 0.0f };
+        traverseRay(origin, direction, hit.t, [&](uint32_t first, uint32_t count) {
+            for (uint32_t i = first; i < first + count; ++i) {
+                float t, u, v;
+                if (intersectTriangle(i, origin, direction, t, u, v) && t < hit.t)
+                    hit = { t, order[i], u, v };
+            }
+        });
+        return hit.triangle != kNoHit;
+    }
+
+    // ¿Hay algo entre from y to? (línea de visión / rayo de sombra)
+    bool occluded(const glm::vec3& from, const glm::vec3& to) const {
+        glm::vec3 d = to - from;
+        float tmax = 1.0f;
+        bool blocked = false;
+        traverseRay(from, d, tmax, [&](uint32_t first, uint32_t count) {
+            for (uint32_t i = first; i < first + count && !blocked; ++i) {
+                float t, u, v;
+                if (intersectTriangle(i, from, d, t, u, v) && t < 1.0f - 1e-4f) {
+                    blocked = true;
+                    tmax = -1.0f; // Termina el recorrido
+                }
+            }
+        });
+        return blocked;
+    }
+
+    // Paquete de N rayos: cada nodo se prueba contra los N rayos a la vez. Con anyHit el
+    // carril se desactiva en cuanto encuentra una intersección (consultas de segmento).
+    template <int N>
+    void intersectPacket(RayPacket<N>& p, bool anyHit = false) const {
+        alignas(16) float inv[3][N];
+        for (int l = 0; l < N; ++l) {
+            inv[0][l] = 1.0f / p.dx[l];
+            inv[1][l] = 1.0f / p.dy[l];
+            inv[2][l] = 1.0f / p.dz[l];
+        }
+
+        // Los nodos pendientes guardan la menor distancia de entrada del paquete para recorrer
+        // de adelante hacia atrás y descartarlos si todos los rayos ya impactaron antes.
+        struct Pending {
+            uint32_t node;
+            float tnear;
+        };
+        Pending stack[kMaxDepth + 2]; // Profundidad acotada en buildNode
+        int top = 0;
+        stack[top++] = { 0, 0.0f };
+        while (top > 0) {
+            Pending pending = stack[--top];
+            float farthest = -1.0f;
+            for (int l = 0; l < N; ++l)
+                farthest = std::max(farthest, p.tmax[l]);
+            if (pending.tnear > farthest)
+                continue;
+            const BvhNode& node = nodes[pending.node];
+            if (node.count == 0) {
+                float nearA, nearB;
+                testBoxPacket(nodes[node.first], p, inv, nearA);
+                testBoxPacket(nodes[node.first + 1], p, inv, nearB);
+                uint32_t a = node.first, b = node.first + 1;
+                if (nearB < nearA) {
+                    std::swap(nearA, nearB);
+                    std::swap(a, b);
+                }
+                if (nearB != kMiss)
+                    stack[top++] = { b, nearB };
+                if (nearA != kMiss)
+                    stack[top++] = { a, nearA };
+                continue;
+            }
+            float nearest;
+            unsigned active = testBoxPacket(node, p, inv, nearest);
+            for (uint32_t i = node.first; i < node.first + node.count; ++i)
+                for (int g = 0; g < N; g += 4)
+                    if ((active >> g) & 0xF)
+                        intersectTriangle4(i, p, g, (active >> g) & 0xF, anyHit);
+        }
+    }
+
+    // Consulta por lotes: agrupa los rayos en paquetes de 8 (el último se rellena).
+    void intersectRays(const glm::vec3* origins, const glm::vec3* directions, float tmax, RayHit* hits, size_t count) const {
+        const int N = 8;
+        for (size_t base = 0; base < count; base += N) {
+            RayPacket<N> packet;
+            for (int l = 0; l < N; ++l) {
+                size_t r = std::min(base + l, count - 1);
+                packet.set(l, origins[r], directions[r], tmax);
+            }
+            intersectPacket(packet);
+            for (int l = 0; l < N && base + l < count; ++l)
+                hits[base + l] = { packet.tmax[l], packet.triangle[l], packet.u[l], packet.v[l] };
+        }
+    }
+
+    // Segmentos from[i] -> to[i] en paquetes de 8; blocked[i] = 1 si algo los interrumpe.
+    void segmentsOccluded(const glm::vec3* from, const glm::vec3* to, uint8_t* blocked, size_t count) const {
+        const int N = 8;
+        for (size_t base = 0; base < count; base += N) {
+            RayPacket<N> packet;
+            for (int l = 0; l < N; ++l) {
+                size_t r = std::min(base + l, count - 1);
+                packet.set(l, from[r], to[r] - from[r], 1.0f - 1e-4f);
+            }
+            intersectPacket(packet, true);
+            for (int l = 0; l < N && base + l < count; ++l)
+                blocked[base + l] = packet.triangle[l] != kNoHit;
+        }
+    }
+
+private:
+    static std::vector<Aabb> triangleBounds(const std::vector<glm::vec3>& positions) {
+        std::vector<Aabb> boxes(positions.size() / 3);
+        for (size_t t = 0; t < boxes.size(); ++t) {
+            boxes[t].grow(positions[3 * t]);
+            boxes[t].grow(positions[3 * t + 1]);
+            boxes[t].grow(positions[3 * t + 2]);
+        }
+        return boxes;
+    }
+
+    void storeTriangles(const std::vector<glm::vec3>& positions) {
+        size_t count = order.size();
+        v0.resize(count);
+        edge1.resize(count);
+        edge2.resize(count);
+        for (size_t i = 0; i < count; ++i) {
+            const glm::vec3* tri = &positions[3 * order[i]];
+            v0[i] = tri[0];
+            edge1[i] = tri[1] - tri[0];
+            edge2[i] = tri[2] - tri[0];
+        }
+    }
+
+    bool intersectTriangle(uint32_t i, const glm::vec3& o, const glm::vec3& d, float& t, float& u, float& v) const {
+        glm::vec3 pvec = glm::cross(d, edge2[i]);
+        float det = glm::dot(edge1[i], pvec);
+        if (std::fabs(det) < 1e-12f)
+            return false;
+        float invDet = 1.0f / det;
+        glm::vec3 s = o - v0[i];
+        u = glm::dot(s, pvec) * invDet;
+        if (u < 0.0f || u > 1.0f)
+            return false;
+        glm::vec3 q = glm::cross(s, edge1[i]);
+        v = glm::dot(d, q) * invDet;
+        if (v < 0.0f || u + v > 1.0f)
+            return false;
+        t = glm::dot(edge2[i], q) * invDet;
+        return t > 1e-6f;
+    }
+
+    // Prueba la caja contra los N rayos. Devuelve un bit por carril que la cruza y en nearest
+    // la menor distancia de entrada (kMiss si ninguno).
+    template <int N>
+    static unsigned testBoxPacket(const BvhNode& node, const RayPacket<N>& p, const float (*inv)[N], float& nearest) {
+        unsigned bits = 0;
+        nearest = kMiss;
+        for (int g = 0; g < N; g += 4) {
+#ifdef BVH_SSE
+            __m128 tx0 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.boundsMin.x), _mm_load_ps(p.ox + g)), _mm_load_ps(inv[0] + g));
+            __m128 tx1 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.boundsMax.x), _mm_load_ps(p.ox + g)), _mm_load_ps(inv[0] + g));
+            __m128 ty0 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.boundsMin.y), _mm_load_ps(p.oy + g)), _mm_load_ps(inv[1] + g));
+            __m128 ty1 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.boundsMax.y), _mm_load_ps(p.oy + g)), _mm_load_ps(inv[1] + g));
+            __m128 tz0 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.boundsMin.z), _mm_load_ps(p.oz + g)), _mm_load_ps(inv[2] + g));
+            __m128 tz1 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.boundsMax.z), _mm_load_ps(p.oz + g)), _mm_load_ps(inv[2] + g));
+            slabAxis4(tx0, tx1);
+            slabAxis4(ty0, ty1);
+            slabAxis4(tz0, tz1);
+            __m128 tnear = _mm_max_ps(_mm_max_ps(_mm_min_ps(tx0, tx1), _mm_min_ps(ty0, ty1)),
+                                      _mm_max_ps(_mm_min_ps(tz0, tz1), _mm_setzero_ps()));
+            __m128 tfar = _mm_min_ps(_mm_min_ps(_mm_max_ps(tx0, tx1), _mm_max_ps(ty0, ty1)),
+                                     _mm_min_ps(_mm_max_ps(tz0, tz1), _mm_load_ps(p.tmax + g)));
+            __m128 hit = _mm_cmple_ps(tnear, tfar);
+            unsigned laneBits = static_cast<unsigned>(_mm_movemask_ps(hit));
+            if (laneBits) {
+                alignas(16) float laneNear[4];
+                _mm_store_ps(laneNear, _mm_or_ps(_mm_and_ps(hit, tnear), _mm_andnot_ps(hit, _mm_set1_ps(kMiss))));
+                nearest = std::min(std::min(nearest, std::min(laneNear[0], laneNear[1])), std::min(laneNear[2], laneNear[3]));
+                bits |= laneBits << g;
+            }
+#else
+            for (int l = g; l < g + 4; ++l) {
+                glm::vec3 o(p.ox[l], p.oy[l], p.oz[l]);
+                glm::vec3 i(inv[0][l], inv[1][l], inv[2][l]);
+                float tnear = slabDistance(node, o, i, p.tmax[l]);
+                if (tnear != kMiss) {
+                    nearest = std::min(nearest, tnear);
+                    bits |= 1u << l;
+                }
+            }
+#endif
+        }
+        return bits;
+    }
+
+    // Möller-Trumbore del triángulo i contra los carriles [g, g + 4) indicados en laneBits.
+    template <int N>
+    void intersectTriangle4(uint32_t i, RayPacket<N>& p, int g, unsigned laneBits, bool anyHit) const {
+#ifdef BVH_SSE
+        const glm::vec3& a = v0[i];
+        const glm::vec3& e1 = edge1[i];
+        const glm::vec3& e2 = edge2[i];
+        __m128 dx = _mm_load_ps(p.dx + g), dy = _mm_load_ps(p.dy + g), dz = _mm_load_ps(p.dz + g);
+        __m128 e1x = _mm_set1_ps(e1.x), e1y = _mm_set1_ps(e1.y), e1z = _mm_set1_ps(e1.z);
+        __m128 e2x = _mm_set1_ps(e2.x), e2y = _mm_set1_ps(e2.y), e2z = _mm_set1_ps(e2.z);
+        __m128 px = _mm_sub_ps(_mm_mul_ps(dy, e2z), _mm_mul_ps(dz, e2y));
+        __m128 py = _mm_sub_ps(_mm_mul_ps(dz, e2x), _mm_mul_ps(dx, e2z));
+        __m128 pz = _mm_sub_ps(_mm_mul_ps(dx, e2y), _mm_mul_ps(dy, e2x));
+        __m128 det = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e1x, px), _mm_mul_ps(e1y, py)), _mm_mul_ps(e1z, pz));
+        __m128 invDet = _mm_div_ps(_mm_set1_ps(1.0f), det);
+        __m128 sx = _mm_sub_ps(_mm_load_ps(p.ox + g), _mm_set1_ps(a.x));
+        __m128 sy = _mm_sub_ps(_mm_load_ps(p.oy + g), _mm_set1_ps(a.y));
+        __m128 sz = _mm_sub_ps(_mm_load_ps(p.oz + g), _mm_set1_ps(a.z));
+        __m128 u = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(sx, px), _mm_mul_ps(sy, py)), _mm_mul_ps(sz, pz)), invDet);
+        __m128 qx = _mm_sub_ps(_mm_mul_ps(sy, e1z), _mm_mul_ps(sz, e1y));
+        __m128 qy = _mm_sub_ps(_mm_mul_ps(sz, e1x), _mm_mul_ps(sx, e1z));
+        __m128 qz = _mm_sub_ps(_mm_mul_ps(sx, e1y), _mm_mul_ps(sy, e1x));
+        __m128 v = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, qx), _mm_mul_ps(dy, qy)), _mm_mul_ps(dz, qz)), invDet);
+        __m128 t = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(e2x, qx), _mm_mul_ps(e2y, qy)), _mm_mul_ps(e2z, qz)), invDet);
+        __m128 tmax = _mm_load_ps(p.tmax + g);
+
+        __m128 absDet = _mm_andnot_ps(_mm_set1_ps(-0.0f), det);
+        __m128 hit = _mm_cmpgt_ps(absDet, _mm_set1_ps(1e-12f));
+        hit = _mm_and_ps(hit, _mm_cmpge_ps(u, _mm_setzero_ps()));
+        hit = _mm_and_ps(hit, _mm_cmpge_ps(v, _mm_setzero_ps()));
+        hit = _mm_and_ps(hit, _mm_cmple_ps(_mm_add_ps(u, v), _mm_set1_ps(1.0f)));
+        hit = _mm_and_ps(hit, _mm_cmpgt_ps(t, _mm_set1_ps(1e-6f)));
+        hit = _mm_and_ps(hit, _mm_cmplt_ps(t, tmax));
+        unsigned hitBits = static_cast<unsigned>(_mm_movemask_ps(hit)) & laneBits;
+        if (!hitBits)
+            return;
+        // Rehacer la máscara solo con los carriles activos
+        __m128i laneMask = _mm_set_epi32(hitBits & 8 ? -1 : 0, hitBits & 4 ? -1 : 0, hitBits & 2 ? -1 : 0, hitBits & 1 ? -1 : 0);
+        hit = _mm_castsi128_ps(laneMask);
+        __m128 newT = anyHit ? _mm_set1_ps(-1.0f) : t;
+        _mm_store_ps(p.tmax + g, _mm_or_ps(_mm_and_ps(hit, newT), _mm_andnot_ps(hit, tmax)));
+        _mm_store_ps(p.u + g, _mm_or_ps(_mm_and_ps(hit, u), _mm_andnot_ps(hit, _mm_load_ps(p.u + g))));
+        _mm_store_ps(p.v + g, _mm_or_ps(_mm_and_ps(hit, v), _mm_andnot_ps(hit, _mm_load_ps(p.v + g))));
+        __m128i oldTriangle = _mm_load_si128(reinterpret_cast<const __m128i*>(p.triangle + g));
+        __m128i triangle = _mm_set1_epi32(static_cast<int>(order[i]));
+        _mm_store_si128(reinterpret_cast<__m128i*>(p.triangle + g),
+                        _mm_or_si128(_mm_and_si128(laneMask, triangle), _mm_andnot_si128(laneMask, oldTriangle)));
+#else
+        for (int l = g; l < g + 4; ++l) {
+            if (!((laneBits >> (l - g)) & 1))
+                continue;
+            glm::vec3 o(p.ox[l], p.oy[l], p.oz[l]), d(p.dx[l], p.dy[l], p.dz[l]);
+            float t, u, v;
+            if (intersectTriangle(i, o, d, t, u, v) && t < p.tmax[l]) {
+                p.tmax[l] = anyHit ? -1.0f : t;
+                p.triangle[l] = order[i];
+                p.u[l] = u;
+                p.v[l] = v;
+            }
+        }
+#endif
+    }
+
+    std::vector<glm::vec3> v0, edge1, edge2; // En el orden de las hojas
+};
@@ -0,0 +1,158 @@
+#pragma once
+// Buffers de comandos de dibujo independientes de la API gráfica.
+//  - DrawCommand: formato fijo de 16 bytes (enlazar programa, enlazar VAO, enlazar un rango del
+//    bloque de uniforms, dibujar). Solo guarda identificadores y números: grabar no toca OpenGL,
+//    así que cualquier hilo puede hacerlo.
+//  - CommandBuffer: vista sobre memoria que entrega el llamador (normalmente la arena del
+//    fotograma). Cada hilo graba en su propio buffer y descarta los enlaces repetidos.
+//  - RecordingPool: hilos persistentes que reparten los tramos de la escena. Crear hilos en cada
+//    fotograma costaría más que la grabación misma.
+// La traducción a llamadas reales la hace el hilo del contexto, recorriendo los buffers en orden.
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+enum class DrawCommandType : uint32_t { BindProgram, BindVertexArray, SetUniformRange, Draw };
+
+struct DrawCommand {
+    DrawCommandType type;
+    // BindProgram: programa | BindVertexArray: VAO | SetUniformRange: punto de enlace,
+    // desplazamiento y bytes | Draw: primer vértice y cantidad de vértices
+    uint32_t args[3];
+};
+
+class CommandBuffer {
+public:
+    // Empieza a grabar sobre storage. capacity debe cubrir el peor caso del tramo: el buffer no
+    // crece porque la memoria es de otro.
+    void begin(DrawCommand* storage, size_t capacity) {
+        commands = storage;
+        limit = capacity;
+        count = 0;
+        program = vao = kUnbound;
+    }
+
+    void bindProgram(uint32_t id) {
+        if (id != program) {
+            program = id;
+            push(DrawCommandType::BindProgram, id);
+        }
+    }
+
+    void bindVertexArray(uint32_t id) {
+        if (id != vao) {
+            vao = id;
+            push(DrawCommandType::BindVertexArray, id);
+        }
+    }
+
+    void setUniformRange(uint32_t binding, uint32_t offset, uint32_t size) {
+        push(DrawCommandType::SetUniformRange, binding, offset, size);
+    }
+
+    void draw(uint32_t first, uint32_t vertexCount) { push(DrawCommandType::Draw, first, vertexCount); }
+
+    const DrawCommand* data() const { return commands; }
+    size_t size() const { return count; }
+
+    // Comandos que puede necesitar un tramo de n dibujos en el peor caso.
+    static size_t worstCase(size_t draws) { return 1 + 3 * draws; }
+
+private:
+    static const uint32_t kUnbound = 0xFFFFFFFFu;
+
+    void push(DrawCommandType type, uint32_t a, uint32_t b = 0, uint32_t c = 0) {
+        if (count < limit)
+            commands[count++] = { type, { a, b, c } };
+    }
+
+    DrawCommand* commands = nullptr;
+    size_t limit = 0, count = 0;
+    uint32_t program = kUnbound, vao = kUnbound;
+};
+
+class RecordingPool {
+public:
+    // threads cuenta también al hilo que llama a run(), que siempre participa.
+    explicit RecordingPool(unsigned threads) {
+        for (unsigned t = 1; t < threads; ++t)
+            workers.emplace_back([this] { workerLoop(); });
+    }
+
+    RecordingPool(const RecordingPool&) = delete;
+    RecordingPool& operator=(const RecordingPool&) = delete;
+
+    ~RecordingPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (std::thread& worker : workers)
+            worker.join();
+    }
+
+    unsigned threadCount() const { return static_cast<unsigned>(workers.size()) + 1; }
+
+    // Ejecuta job(tramo) para cada tramo en [0, slices) y regresa cuando todos terminaron. Los
+    // tramos se toman de un contador atómico, así que los hilos rápidos se llevan más.
+    void run(unsigned slices, const std::function<void(unsigned)>& job) {
+        if (workers.empty() || slices <= 1) {
+            for (unsigned s = 0; s < slices; ++s)
+                job(s);
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            currentJob = &job;
+            sliceCount = slices;
+            nextSlice.store(0, std::memory_order_relaxed);
+            busyWorkers = static_cast<unsigned>(workers.size());
+            ++generation;
+        }
+        wake.notify_all();
+        drain();
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [this] { return busyWorkers == 0; });
+        currentJob = nullptr;
+    }
+
+private:
+    void drain() {
+        for (unsigned s = nextSlice.fetch_add(1); s < sliceCount; s = nextSlice.fetch_add(1))
+            (*currentJob)(s);
+    }
+
+    void workerLoop() {
+        uint64_t seen = 0;
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [&] { return stopping || generation != seen; });
+                if (stopping)
+                    return;
+                seen = generation;
+            }
+            drain();
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--busyWorkers == 0)
+                done.notify_one();
+        }
+    }
+
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake, done;
+    const std::function<void(unsigned)>* currentJob = nullptr;
+    unsigned sliceCount = 0;
+    std::atomic<unsigned> nextSlice{ 0 };
+    unsigned busyWorkers = 0;
+    uint64_t generation = 0;
+    bool stopping = false;
+};
@@ -0,0 +1,5 @@
+#version 330 core
+
+// Pre-pase de profundidad: solo se escribe el buffer de profundidad (color enmascarado)
+void main() {
+}
@@ -0,0 +1,20 @@
+#version 330 core
+
+layout(location = 0) in vec3 aPos; // Posición del vértice
+
+// Datos por objeto: el mismo rango del buffer de uniforms que usa el pase de iluminación
+layout(std140) uniform ObjectBlock {
+    mat4 model;
+    mat4 normalMatrix;
+};
+
+uniform mat4 view;
+uniform mat4 projection;
+
+// La profundidad debe coincidir bit a bit con la del pase de iluminación (GL_EQUAL): misma
+// expresión y gl_Position invariante en ambos shaders
+invariant gl_Position;
+
+void main() {
+    gl_Position = projection * view * model * vec4(aPos, 1.0);
+}
@@ -0,0 +1,250 @@
+#pragma once
+// Memoria por fotograma y contabilidad de recursos de OpenGL.
+//  - FrameArena: asignador lineal para datos temporales de un fotograma (listas de dibujo,
+//    resultados de culling...). Asignar es mover un puntero; se reinicia al inicio de cada
+//    iteración del bucle, así que nunca hay que liberar nada individualmente.
+//  - GlResourceTracker: registra cada buffer, VAO, programa, textura y framebuffer creado con
+//    su tamaño en bytes, informa la memoria de GPU viva por categoría y detecta fugas al salir.
+
+#include <GL/glew.h>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <new>
+#include <string>
+#include <utility>
+#include <vector>
+
+class FrameArena {
+public:
+    explicit FrameArena(size_t capacity) : capacity(capacity), storage(new uint8_t[capacity]) {}
+
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    // Reserva size bytes alineados. Si el bloque principal se llena, el resto del fotograma se
+    // atiende con bloques de desbordamiento y en el siguiente reinicio el bloque crece.
+    void* allocate(size_t size, size_t alignment = alignof(std::max_align_t)) {
+        size_t aligned = (offset + alignment - 1) & ~(alignment - 1);
+        if (aligned + size <= capacity) {
+            offset = aligned + size;
+            used = std::max(used, offset);
+            return storage.get() + aligned;
+        }
+        overflowBytes += size + alignment;
+        overflow.emplace_back(new uint8_t[size + alignment]);
+        uintptr_t raw = reinterpret_cast<uintptr_t>(overflow.back().get());
+        return reinterpret_cast<void*>((raw + alignment - 1) & ~(uintptr_t)(alignment - 1));
+    }
+
+    // Arreglo de n elementos construidos por defecto. Solo para tipos triviales: la arena no
+    // llama destructores.
+    template <typename T>
+    T* allocateArray(size_t n) {
+        T* items = static_cast<T*>(allocate(sizeof(T) * n, alignof(T)));
+        for (size_t i = 0; i < n; ++i)
+            new (items + i) T();
+        return items;
+    }
+
+    // Inicio de fotograma: todo lo asignado en el fotograma anterior deja de ser válido.
+    void reset() {
+        highWater = std::max(highWater, used + overflowBytes);
+        if (!overflow.empty()) {
+            size_t grown = (used + overflowBytes) * 3 / 2;
+            std::cerr << "FrameArena: desbordamiento de " << overflowBytes << " bytes, el bloque crece a "
+                      << grown << " bytes" << std::endl;
+            capacity = grown;
+            storage.reset(new uint8_t[capacity]);
+            overflow.clear();
+            overflowBytes = 0;
+        }
+        offset = 0;
+        used = 0;
+    }
+
+    size_t capacityBytes() const { return capacity; }
+    size_t highWaterBytes() const { return std::max(highWater, used + overflowBytes); }
+
+private:
+    size_t capacity;
+    std::unique_ptr<uint8_t[]> storage;
+    size_t offset = 0;
+    size_t used = 0;
+    size_t highWater = 0;
+    std::vector<std::unique_ptr<uint8_t[]>> overflow;
+    size_t overflowBytes = 0;
+};
+
+enum class GlResourceKind { Buffer, VertexArray, Program, Texture, Renderbuffer, Framebuffer, Count };
+
+inline const char* glResourceKindName(GlResourceKind kind) {
+    switch (kind) {
+    case GlResourceKind::Buffer: return "buffers";
+    case GlResourceKind::VertexArray: return "VAOs";
+    case GlResourceKind::Program: return "programas";
+    case GlResourceKind::Texture: return "texturas";
+    case GlResourceKind::Renderbuffer: return "renderbuffers";
+    case GlResourceKind::Framebuffer: return "framebuffers";
+    default: return "?";
+    }
+}
+
+class GlResourceTracker {
+public:
+    void track(GlResourceKind kind, unsigned int id, size_t bytes, const std::string& label) {
+        Entry& entry = live[key(kind, id)];
+        entry.bytes = bytes;
+        entry.label = label;
+    }
+
+    // Actualiza el tamaño tras un glBufferData/glTexImage* sobre un objeto ya registrado.
+    void resize(GlResourceKind kind, unsigned int id, size_t bytes) {
+        auto it = live.find(key(kind, id));
+        if (it != live.end())
+            it->second.bytes = bytes;
+    }
+
+    void release(GlResourceKind kind, unsigned int id) {
+        if (id != 0 && live.erase(key(kind, id)) == 0)
+            std::cerr << "GlResourceTracker: se liberó un objeto no registrado (" << glResourceKindName(kind)
+                      << " " << id << ")" << std::endl;
+    }
+
+    size_t liveBytes(GlResourceKind kind) const {
+        size_t total = 0;
+        for (const auto& item : live)
+            if (item.first.first == kind)
+                total += item.second.bytes;
+        return total;
+    }
+
+    void report(std::ostream& out) const {
+        size_t total = 0;
+        out << "Memoria de GPU registrada:" << std::endl;
+        for (int k = 0; k < static_cast<int>(GlResourceKind::Count); ++k) {
+            GlResourceKind kind = static_cast<GlResourceKind>(k);
+            size_t count = 0, bytes = 0;
+            for (const auto& item : live) {
+                if (item.first.first == kind) {
+                    ++count;
+                    bytes += item.second.bytes;
+                }
+            }
+            if (count)
+                out << "  " << glResourceKindName(kind) << ": " << count << " objetos, " << bytes / 1024.0 << " KB" << std::endl;
+            total += bytes;
+        }
+        out << "  total: " << total / (1024.0 * 1024.0) << " MB" << std::endl;
+    }
+
+    // Informa los objetos que siguen vivos; se llama justo antes de destruir el contexto.
+    size_t reportLeaks(std::ostream& out) const {
+        for (const auto& item : live)
+            out << "Fuga de OpenGL: " << glResourceKindName(item.first.first) << " " << item.first.second
+                << " (" << item.second.label << ", " << item.second.bytes << " bytes)" << std::endl;
+        return live.size();
+    }
+
+private:
+    struct Entry {
+        size_t bytes;
+        std::string label;
+    };
+    static std::pair<GlResourceKind, unsigned int> key(GlResourceKind kind, unsigned int id) { return { kind, id }; }
+
+    std::map<std::pair<GlResourceKind, unsigned int>, Entry> live;
+};
+
+// Registro global de los recursos de OpenGL de la aplicación.
+inline GlResourceTracker glResources;
+
+// Envolturas de las llamadas de creación/destrucción que usa la escena. Cada una llama a
+// OpenGL y mantiene actualizado el registro.
+inline unsigned int trackedGenBuffer(const char* label) {
+    unsigned int id;
+    glGenBuffers(1, &id);
+    glResources.track(GlResourceKind::Buffer, id, 0, label);
+    return id;
+}
+
+inline void trackedBufferData(GLenum target, unsigned int id, GLsizeiptr size, const void* data, GLenum usage) {
+    glBindBuffer(target, id);
+    glBufferData(target, size, data, usage);
+    glResources.resize(GlResourceKind::Buffer, id, static_cast<size_t>(size));
+}
+
+inline void trackedDeleteBuffer(unsigned int& id) {
+    glResources.release(GlResourceKind::Buffer, id);
+    glDeleteBuffers(1, &id);
+    id = 0;
+}
+
+inline unsigned int trackedGenVertexArray(const char* label) {
+    unsigned int id;
+    glGenVertexArrays(1, &id);
+    glResources.track(GlResourceKind::VertexArray, id, 0, label);
+    return id;
+}
+
+inline void trackedDeleteVertexArray(unsigned int& id) {
+    glResources.release(GlResourceKind::VertexArray, id);
+    glDeleteVertexArrays(1, &id);
+    id = 0;
+}
+
+// Un programa enlazado ocupa el tamaño de su binario (si el driver lo expone).
+inline void trackProgram(unsigned int program, const char* label) {
+    GLint binaryLength = 0;
+    if (GLEW_ARB_get_program_binary)
+        glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &binaryLength);
+    glResources.track(GlResourceKind::Program, program, static_cast<size_t>(binaryLength), label);
+}
+
+inline void trackedDeleteProgram(unsigned int& program) {
+    glResources.release(GlResourceKind::Program, program);
+    glDeleteProgram(program);
+    program = 0;
+}
+
+inline unsigned int trackedGenTexture(const char* label) {
+    unsigned int id;
+    glGenTextures(1, &id);
+    glResources.track(GlResourceKind::Texture, id, 0, label);
+    return id;
+}
+
+inline void trackedDeleteTexture(unsigned int& id) {
+    glResources.release(GlResourceKind::Texture, id);
+    glDeleteTextures(1, &id);
+    id = 0;
+}
+
+inline unsigned int trackedGenRenderbuffer(const char* label) {
+    unsigned int id;
+    glGenRenderbuffers(1, &id);
+    glResources.track(GlResourceKind::Renderbuffer, id, 0, label);
+    return id;
+}
+
+inline void trackedDeleteRenderbuffer(unsigned int& id) {
+    glResources.release(GlResourceKind::Renderbuffer, id);
+    glDeleteRenderbuffers(1, &id);
+    id = 0;
+}
+
+inline unsigned int trackedGenFramebuffer(const char* label) {
+    unsigned int id;
+    glGenFramebuffers(1, &id);
+    glResources.track(GlResourceKind::Framebuffer, id, 0, label);
+    return id;
+}
+
+inline void trackedDeleteFramebuffer(unsigned int& id) {
+    glResources.release(GlResourceKind::Framebuffer, id);
+    glDeleteFramebuffers(1, &id);
+    id = 0;
+}
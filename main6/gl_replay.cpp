@@ -0,0 +1,846 @@
+// Reproductor de trazas de OpenGL grabadas con `OpenGLTrianglesWithMovCamara --capture`.
+// Vuelve a emitir las llamadas lo más rápido posible en una ventana oculta del mismo tamaño,
+// mide el costo de cada llamada y de cada fotograma, y puede repetir un fotograma N veces para
+// separar el costo del driver del costo de la aplicación.
+//
+// Uso: GLReplay traza.gltr [--loop fotograma N] [--visible]
+// Compilación: g++ gl_replay.cpp -o GLReplay -lglew32 -lglfw3 -lopengl32
+//              (en Linux: -lGLEW -lglfw -lGL)
+
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+#define GL_TRACE_DISABLE // El reproductor emite las llamadas reales
+#include "gl_trace.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <unordered_map>
+#include <vector>
+
+using ReplayClock = std::chrono::steady_clock;
+
+// Registro ya localizado dentro de la traza.
+struct TraceRecord {
+    GlOp op;
+    uint32_t offset; // Inicio de los argumentos
+    uint32_t size;
+};
+
+// Fotograma de la traza: rango de registros [begin, end] desde FrameBegin hasta FrameEnd.
+struct TraceFrame {
+    size_t begin, end;
+    bool presented;
+    double appSeconds;
+};
+
+// Lee los argumentos de un registro en el mismo orden en que se escribieron.
+class ArgReader {
+public:
+    explicit ArgReader(const uint8_t* data) : cursor(data) {}
+
+    template <typename T>
+    T get() {
+        T value;
+        std::memcpy(&value, cursor, sizeof(T));
+        cursor += sizeof(T);
+        return value;
+    }
+
+    TraceBytes bytes() {
+        uint32_t size = get<uint32_t>();
+        TraceBytes block = { cursor, size };
+        cursor += size;
+        return block;
+    }
+
+private:
+    const uint8_t* cursor;
+};
+
+class TraceFile {
+public:
+    bool load(const char* path) {
+        std::ifstream in(path, std::ios::binary);
+        if (!in) {
+            std::cerr << "No se pudo abrir la traza " << path << std::endl;
+            return false;
+        }
+        data.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        if (data.size() < sizeof(header)) {
+            std::cerr << "Traza truncada: " << path << std::endl;
+            return false;
+        }
+        std::memcpy(&header, data.data(), sizeof(header));
+        if (std::memcmp(header.magic, "GLTR", 4) != 0 || header.version != kGlTraceVersion) {
+            std::cerr << "Formato de traza no reconocido: " << path << std::endl;
+            return false;
+        }
+
+        size_t cursor = sizeof(header);
+        while (cursor + kGlTraceRecordHeader <= data.size()) {
+            uint16_t op;
+            uint32_t size;
+            std::memcpy(&op, data.data() + cursor, sizeof(op));
+            std::memcpy(&size, data.data() + cursor + sizeof(op), sizeof(size));
+            cursor += kGlTraceRecordHeader;
+            if (op >= static_cast<uint16_t>(GlOp::Count) || cursor + size > data.size()) {
+                std::cerr << "Registro inválido en la posición " << cursor << std::endl;
+                return false;
+            }
+            TraceRecord record = { static_cast<GlOp>(op), static_cast<uint32_t>(cursor), size };
+            if (record.op == GlOp::FrameBegin) {
+                frames.push_back({ records.size(), 0, false, 0.0 });
+            } else if (record.op == GlOp::FrameEnd && !frames.empty()) {
+                ArgReader args(data.data() + cursor);
+                frames.back().end = records.size();
+                frames.back().presented = args.get<uint8_t>() != 0;
+                frames.back().appSeconds = args.get<double>();
+            }
+            records.push_back(record);
+            cursor += size;
+        }
+        // Un fotograma sin FrameEnd (captura interrumpida) no se reproduce
+        if (!frames.empty() && frames.back().end == 0)
+            frames.pop_back();
+        setupEnd = frames.empty() ? records.size() : frames.front().begin;
+        return true;
+    }
+
+    const uint8_t* args(const TraceRecord& record) const { return data.data() + record.offset; }
+
+    GlTraceHeader header = {};
+    std::vector<TraceRecord> records;
+    std::vector<TraceFrame> frames;
+    size_t setupEnd = 0; // Registros de preparación: [0, setupEnd)
+
+private:
+    std::vector<uint8_t> data;
+};
+
+// Emite los registros traduciendo los nombres de objetos capturados a los de este contexto.
+class TraceReplayer {
+public:
+    TraceReplayer(const TraceFile& trace, GLFWwindow* window) : trace(trace), window(window) {}
+
+    void execute(const TraceRecord& record) {
+        ArgReader a(trace.args(record));
+        switch (record.op) {
+        case GlOp::FrameBegin:
+            break;
+        case GlOp::FrameEnd:
+            if (a.get<uint8_t>())
+                glfwSwapBuffers(window);
+            break;
+        case GlOp::Clear:
+            glClear(a.get<GLbitfield>());
+            break;
+        case GlOp::ClearColor: {
+            GLfloat r = a.get<GLfloat>(), g = a.get<GLfloat>(), b = a.get<GLfloat>(), alpha = a.get<GLfloat>();
+            glClearColor(r, g, b, alpha);
+            break;
+        }
+        case GlOp::Enable:
+            glEnable(a.get<GLenum>());
+            break;
+        case GlOp::Disable:
+            glDisable(a.get<GLenum>());
+            break;
+        case GlOp::Viewport: {
+            GLint x = a.get<GLint>(), y = a.get<GLint>();
+            GLsizei w = a.get<GLsizei>(), h = a.get<GLsizei>();
+            glViewport(x, y, w, h);
+            break;
+        }
+        case GlOp::ViewportIndexedf: {
+            GLuint index = a.get<GLuint>();
+            GLfloat x = a.get<GLfloat>(), y = a.get<GLfloat>(), w = a.get<GLfloat>(), h = a.get<GLfloat>();
+            glViewportIndexedf(index, x, y, w, h);
+            break;
+        }
+        case GlOp::PixelStorei: {
+            GLenum pname = a.get<GLenum>();
+            glPixelStorei(pname, a.get<GLint>());
+            break;
+        }
+        case GlOp::GetIntegerv:
+            glGetIntegerv(a.get<GLenum>(), scratchInts);
+            break;
+        case GlOp::GenBuffers:
+            generate(a, buffers, glGenBuffers);
+            break;
+        case GlOp::DeleteBuffers:
+            release(a, buffers, glDeleteBuffers);
+            break;
+        case GlOp::BindBuffer: {
+            GLenum target = a.get<GLenum>();
+            glBindBuffer(target, lookup(buffers, a.get<GLuint>()));
+            break;
+        }
+        case GlOp::BufferData: {
+            GLenum target = a.get<GLenum>();
+            GLsizeiptr size = static_cast<GLsizeiptr>(a.get<uint64_t>());
+            GLenum usage = a.get<GLenum>();
+            TraceBytes data = a.bytes();
+            glBufferData(target, size, data.size ? data.data : nullptr, usage);
+            break;
+        }
+        case GlOp::MapBufferRange: {
+            GLenum target = a.get<GLenum>();
+            GLintptr offset = static_cast<GLintptr>(a.get<uint64_t>());
+            GLsizeiptr length = static_cast<GLsizeiptr>(a.get<uint64_t>());
+            glMapBufferRange(target, offset, length, a.get<GLbitfield>());
+            break;
+        }
+        case GlOp::UnmapBuffer:
+            glUnmapBuffer(a.get<GLenum>());
+            break;
+        case GlOp::GenVertexArrays:
+            generate(a, vertexArrays, glGenVertexArrays);
+            break;
+        case GlOp::DeleteVertexArrays:
+            release(a, vertexArrays, glDeleteVertexArrays);
+            break;
+        case GlOp::BindVertexArray:
+            glBindVertexArray(lookup(vertexArrays, a.get<GLuint>()));
+            break;
+        case GlOp::VertexAttribPointer: {
+            GLuint index = a.get<GLuint>();
+            GLint size = a.get<GLint>();
+            GLenum type = a.get<GLenum>();
+            GLboolean normalized = a.get<GLboolean>();
+            GLsizei stride = a.get<GLsizei>();
+            uintptr_t offset = static_cast<uintptr_t>(a.get<uint64_t>());
+            glVertexAttribPointer(index, size, type, normalized, stride, reinterpret_cast<const void*>(offset));
+            break;
+        }
+        case GlOp::EnableVertexAttribArray:
+            glEnableVertexAttribArray(a.get<GLuint>());
+            break;
+        case GlOp::CreateShader: {
+            GLenum type = a.get<GLenum>();
+            shaders[a.get<GLuint>()] = glCreateShader(type);
+            break;
+        }
+        case GlOp::ShaderSource: {
+            GLuint shader = lookup(shaders, a.get<GLuint>());
+            TraceBytes source = a.bytes();
+            const GLchar* text = static_cast<const GLchar*>(source.data);
+            GLint length = static_cast<GLint>(source.size);
+            glShaderSource(shader, 1, &text, &length);
+            break;
+        }
+        case GlOp::CompileShader:
+            glCompileShader(lookup(shaders, a.get<GLuint>()));
+            break;
+        case GlOp::GetShaderiv: {
+            GLuint shader = lookup(shaders, a.get<GLuint>());
+            glGetShaderiv(shader, a.get<GLenum>(), scratchInts);
+            break;
+        }
+        case GlOp::GetShaderInfoLog: {
+            GLuint shader = lookup(shaders, a.get<GLuint>());
+            GLsizei bufSize = std::min<GLsizei>(a.get<GLsizei>(), sizeof(scratchLog));
+            glGetShaderInfoLog(shader, bufSize, nullptr, scratchLog);
+            break;
+        }
+        case GlOp::DeleteShader: {
+            GLuint captured = a.get<GLuint>();
+            glDeleteShader(lookup(shaders, captured));
+            shaders.erase(captured);
+            break;
+        }
+        case GlOp::CreateProgram:
+            programs[a.get<GLuint>()] = glCreateProgram();
+            break;
+        case GlOp::AttachShader: {
+            GLuint program = lookup(programs, a.get<GLuint>());
+            glAttachShader(program, lookup(shaders, a.get<GLuint>()));
+            break;
+        }
+        case GlOp::LinkProgram:
+            glLinkProgram(lookup(programs, a.get<GLuint>()));
+            break;
+        case GlOp::GetProgramiv: {
+            GLuint program = lookup(programs, a.get<GLuint>());
+            glGetProgramiv(program, a.get<GLenum>(), scratchInts);
+            break;
+        }
+        case GlOp::GetProgramInfoLog: {
+            GLuint program = lookup(programs, a.get<GLuint>());
+            GLsizei bufSize = std::min<GLsizei>(a.get<GLsizei>(), sizeof(scratchLog));
+            glGetProgramInfoLog(program, bufSize, nullptr, scratchLog);
+            break;
+        }
+        case GlOp::DeleteProgram: {
+            GLuint captured = a.get<GLuint>();
+            glDeleteProgram(lookup(programs, captured));
+            programs.erase(captured);
+            break;
+        }
+        case GlOp::UseProgram:
+            currentProgram = a.get<GLuint>();
+            glUseProgram(lookup(programs, currentProgram));
+            break;
+        case GlOp::GetUniformLocation: {
+            GLuint captured = a.get<GLuint>();
+            GLint capturedLocation = a.get<GLint>();
+            TraceBytes name = a.bytes();
+            std::string uniform(static_cast<const char*>(name.data), name.size);
+            GLint location = glGetUniformLocation(lookup(programs, captured), uniform.c_str());
+            locations[locationKey(captured, capturedLocation)] = location;
+            break;
+        }
+        case GlOp::Uniform1i: {
+            GLint location = uniform(a.get<GLint>());
+            glUniform1i(location, a.get<GLint>());
+            break;
+        }
+        case GlOp::Uniform1f: {
+            GLint location = uniform(a.get<GLint>());
+            glUniform1f(location, a.get<GLfloat>());
+            break;
+        }
+        case GlOp::Uniform3fv: {
+            GLint location = uniform(a.get<GLint>());
+            TraceBytes value = a.bytes();
+            glUniform3fv(location, static_cast<GLsizei>(value.size / (3 * sizeof(GLfloat))),
+                         static_cast<const GLfloat*>(value.data));
+            break;
+        }
+        case GlOp::UniformMatrix4fv: {
+            GLint location = uniform(a.get<GLint>());
+            GLboolean transpose = a.get<GLboolean>();
+            TraceBytes value = a.bytes();
+            glUniformMatrix4fv(location, static_cast<GLsizei>(value.size / (16 * sizeof(GLfloat))), transpose,
+                               static_cast<const GLfloat*>(value.data));
+            break;
+        }
+        case GlOp::GenTextures:
+            generate(a, textures, glGenTextures);
+            break;
+        case GlOp::DeleteTextures:
+            release(a, textures, glDeleteTextures);
+            break;
+        case GlOp::ActiveTexture:
+            glActiveTexture(a.get<GLenum>());
+            break;
+        case GlOp::BindTexture: {
+            GLenum target = a.get<GLenum>();
+            glBindTexture(target, lookup(textures, a.get<GLuint>()));
+            break;
+        }
+        case GlOp::TexParameteri: {
+            GLenum target = a.get<GLenum>();
+            GLenum pname = a.get<GLenum>();
+            glTexParameteri(target, pname, a.get<GLint>());
+            break;
+        }
+        case GlOp::TexImage2D: {
+            GLenum target = a.get<GLenum>();
+            GLint level = a.get<GLint>(), internalFormat = a.get<GLint>();
+            GLsizei w = a.get<GLsizei>(), h = a.get<GLsizei>();
+            GLint border = a.get<GLint>();
+            GLenum format = a.get<GLenum>(), type = a.get<GLenum>();
+            bool fromBuffer = a.get<uint8_t>() != 0;
+            uintptr_t offset = static_cast<uintptr_t>(a.get<uint64_t>());
+            TraceBytes pixels = a.bytes();
+            const void* data = fromBuffer ? reinterpret_cast<const void*>(offset) : pixels.size ? pixels.data : nullptr;
+            glTexImage2D(target, level, internalFormat, w, h, border, format, type, data);
+            break;
+        }
+        case GlOp::TexSubImage2D: {
+            GLenum target = a.get<GLenum>();
+            GLint level = a.get<GLint>(), x = a.get<GLint>(), y = a.get<GLint>();
+            GLsizei w = a.get<GLsizei>(), h = a.get<GLsizei>();
+            GLenum format = a.get<GLenum>(), type = a.get<GLenum>();
+            bool fromBuffer = a.get<uint8_t>() != 0;
+            uintptr_t offset = static_cast<uintptr_t>(a.get<uint64_t>());
+            TraceBytes pixels = a.bytes();
+            const void* data = fromBuffer ? reinterpret_cast<const void*>(offset) : pixels.data;
+            glTexSubImage2D(target, level, x, y, w, h, format, type, data);
+            break;
+        }
+        case GlOp::TexImage3D: {
+            GLenum target = a.get<GLenum>();
+            GLint level = a.get<GLint>(), internalFormat = a.get<GLint>();
+            GLsizei w = a.get<GLsizei>(), h = a.get<GLsizei>(), depth = a.get<GLsizei>();
+            GLint border = a.get<GLint>();
+            GLenum format = a.get<GLenum>(), type = a.get<GLenum>();
+            bool fromBuffer = a.get<uint8_t>() != 0;
+            uintptr_t offset = static_cast<uintptr_t>(a.get<uint64_t>());
+            TraceBytes pixels = a.bytes();
+            const void* data = fromBuffer ? reinterpret_cast<const void*>(offset) : pixels.size ? pixels.data : nullptr;
+            glTexImage3D(target, level, internalFormat, w, h, depth, border, format, type, data);
+            break;
+        }
+        case GlOp::GenRenderbuffers:
+            generate(a, renderbuffers, glGenRenderbuffers);
+            break;
+        case GlOp::DeleteRenderbuffers:
+            release(a, renderbuffers, glDeleteRenderbuffers);
+            break;
+        case GlOp::BindRenderbuffer: {
+            GLenum target = a.get<GLenum>();
+            glBindRenderbuffer(target, lookup(renderbuffers, a.get<GLuint>()));
+            break;
+        }
+        case GlOp::RenderbufferStorage: {
+            GLenum target = a.get<GLenum>(), internalFormat = a.get<GLenum>();
+            GLsizei w = a.get<GLsizei>(), h = a.get<GLsizei>();
+            glRenderbufferStorage(target, internalFormat, w, h);
+            break;
+        }
+        case GlOp::RenderbufferStorageMultisample: {
+            GLenum target = a.get<GLenum>();
+            GLsizei samples = a.get<GLsizei>();
+            GLenum internalFormat = a.get<GLenum>();
+            GLsizei w = a.get<GLsizei>(), h = a.get<GLsizei>();
+            glRenderbufferStorageMultisample(target, samples, internalFormat, w, h);
+            break;
+        }
+        case GlOp::GenFramebuffers:
+            generate(a, framebuffers, glGenFramebuffers);
+            break;
+        case GlOp::DeleteFramebuffers:
+            release(a, framebuffers, glDeleteFramebuffers);
+            break;
+        case GlOp::BindFramebuffer: {
+            GLenum target = a.get<GLenum>();
+            glBindFramebuffer(target, lookup(framebuffers, a.get<GLuint>()));
+            break;
+        }
+        case GlOp::FramebufferRenderbuffer: {
+            GLenum target = a.get<GLenum>(), attachment = a.get<GLenum>(), rbTarget = a.get<GLenum>();
+            glFramebufferRenderbuffer(target, attachment, rbTarget, lookup(renderbuffers, a.get<GLuint>()));
+            break;
+        }
+        case GlOp::FramebufferTexture: {
+            GLenum target = a.get<GLenum>(), attachment = a.get<GLenum>();
+            GLuint texture = lookup(textures, a.get<GLuint>());
+            glFramebufferTexture(target, attachment, texture, a.get<GLint>());
+            break;
+        }
+        case GlOp::FramebufferTextureLayer: {
+            GLenum target = a.get<GLenum>(), attachment = a.get<GLenum>();
+            GLuint texture = lookup(textures, a.get<GLuint>());
+            GLint level = a.get<GLint>();
+            glFramebufferTextureLayer(target, attachment, texture, level, a.get<GLint>());
+            break;
+        }
+        case GlOp::CheckFramebufferStatus:
+            glCheckFramebufferStatus(a.get<GLenum>());
+            break;
+        case GlOp::BlitFramebuffer: {
+            GLint v[8];
+            for (GLint& value : v)
+                value = a.get<GLint>();
+            GLbitfield mask = a.get<GLbitfield>();
+            glBlitFramebuffer(v[0], v[1], v[2], v[3], v[4], v[5], v[6], v[7], mask, a.get<GLenum>());
+            break;
+        }
+        case GlOp::ReadPixels: {
+            GLint x = a.get<GLint>(), y = a.get<GLint>();
+            GLsizei w = a.get<GLsizei>(), h = a.get<GLsizei>();
+            GLenum format = a.get<GLenum>(), type = a.get<GLenum>();
+            bool toBuffer = a.get<uint8_t>() != 0;
+            uintptr_t offset = static_cast<uintptr_t>(a.get<uint64_t>());
+            void* data = reinterpret_cast<void*>(offset);
+            if (!toBuffer) {
+                // Sin PBO: leer a memoria propia con el tamaño más holgado posible
+                scratchPixels.resize(glImageBytes(w, h, GL_RGBA, GL_FLOAT, 8));
+                data = scratchPixels.data();
+            }
+            glReadPixels(x, y, w, h, format, type, data);
+            break;
+        }
+        case GlOp::FenceSync: {
+            GLenum condition = a.get<GLenum>();
+            GLbitfield flags = a.get<GLbitfield>();
+            uint64_t captured = a.get<uint64_t>();
+            // Al repetir un fotograma el mismo fence se crea otra vez: liberar el anterior
+            auto previous = syncs.find(captured);
+            if (previous != syncs.end())
+                glDeleteSync(previous->second);
+            syncs[captured] = glFenceSync(condition, flags);
+            break;
+        }
+        case GlOp::ClientWaitSync: {
+            auto sync = syncs.find(a.get<uint64_t>());
+            GLbitfield flags = a.get<GLbitfield>();
+            GLuint64 timeout = a.get<uint64_t>();
+            if (sync != syncs.end())
+                glClientWaitSync(sync->second, flags, timeout);
+            break;
+        }
+        case GlOp::DeleteSync: {
+            auto sync = syncs.find(a.get<uint64_t>());
+            if (sync != syncs.end()) {
+                glDeleteSync(sync->second);
+                syncs.erase(sync);
+            }
+            break;
+        }
+        case GlOp::GenQueries:
+            generate(a, queries, glGenQueries);
+            break;
+        case GlOp::DeleteQueries:
+            release(a, queries, glDeleteQueries);
+            break;
+        case GlOp::BeginQuery: {
+            GLenum target = a.get<GLenum>();
+            glBeginQuery(target, lookup(queries, a.get<GLuint>()));
+            break;
+        }
+        case GlOp::EndQuery:
+            glEndQuery(a.get<GLenum>());
+            break;
+        case GlOp::GetQueryObjectui64v: {
+            GLuint query = lookup(queries, a.get<GLuint>());
+            GLuint64 result;
+            glGetQueryObjectui64v(query, a.get<GLenum>(), &result);
+            break;
+        }
+        case GlOp::DrawArrays: {
+            GLenum mode = a.get<GLenum>();
+            GLint first = a.get<GLint>();
+            glDrawArrays(mode, first, a.get<GLsizei>());
+            break;
+        }
+        case GlOp::BindBufferRange: {
+            GLenum target = a.get<GLenum>();
+            GLuint index = a.get<GLuint>();
+            GLuint buffer = lookup(buffers, a.get<GLuint>());
+            GLintptr offset = static_cast<GLintptr>(a.get<uint64_t>());
+            glBindBufferRange(target, index, buffer, offset, static_cast<GLsizeiptr>(a.get<uint64_t>()));
+            break;
+        }
+        case GlOp::BufferSubData: {
+            GLenum target = a.get<GLenum>();
+            GLintptr offset = static_cast<GLintptr>(a.get<uint64_t>());
+            TraceBytes data = a.bytes();
+            glBufferSubData(target, offset, static_cast<GLsizeiptr>(data.size), data.data);
+            break;
+        }
+        case GlOp::GetUniformBlockIndex: {
+            GLuint captured = a.get<GLuint>();
+            GLuint capturedIndex = a.get<GLuint>();
+            TraceBytes name = a.bytes();
+            std::string block(static_cast<const char*>(name.data), name.size);
+            blockIndices[locationKey(captured, static_cast<GLint>(capturedIndex))] =
+                glGetUniformBlockIndex(lookup(programs, captured), block.c_str());
+            break;
+        }
+        case GlOp::UniformBlockBinding: {
+            GLuint captured = a.get<GLuint>();
+            auto blockIndex = blockIndices.find(locationKey(captured, static_cast<GLint>(a.get<GLuint>())));
+            GLuint binding = a.get<GLuint>();
+            if (blockIndex != blockIndices.end())
+                glUniformBlockBinding(lookup(programs, captured), blockIndex->second, binding);
+            break;
+        }
+        case GlOp::ColorMask: {
+            GLboolean r = a.get<GLboolean>(), g = a.get<GLboolean>(), b = a.get<GLboolean>(), alpha = a.get<GLboolean>();
+            glColorMask(r, g, b, alpha);
+            break;
+        }
+        case GlOp::DepthMask:
+            glDepthMask(a.get<GLboolean>());
+            break;
+        case GlOp::DepthFunc:
+            glDepthFunc(a.get<GLenum>());
+            break;
+        case GlOp::StencilFunc: {
+            GLenum func = a.get<GLenum>();
+            GLint ref = a.get<GLint>();
+            glStencilFunc(func, ref, a.get<GLuint>());
+            break;
+        }
+        case GlOp::StencilOp: {
+            GLenum stencilFail = a.get<GLenum>(), depthFail = a.get<GLenum>();
+            glStencilOp(stencilFail, depthFail, a.get<GLenum>());
+            break;
+        }
+        case GlOp::BindBufferBase: {
+            GLenum target = a.get<GLenum>();
+            GLuint index = a.get<GLuint>();
+            glBindBufferBase(target, index, lookup(buffers, a.get<GLuint>()));
+            break;
+        }
+        case GlOp::VertexAttribDivisor: {
+            GLuint index = a.get<GLuint>();
+            glVertexAttribDivisor(index, a.get<GLuint>());
+            break;
+        }
+        case GlOp::DrawArraysInstanced: {
+            GLenum mode = a.get<GLenum>();
+            GLint first = a.get<GLint>();
+            GLsizei count = a.get<GLsizei>();
+            glDrawArraysInstanced(mode, first, count, a.get<GLsizei>());
+            break;
+        }
+        case GlOp::TransformFeedbackVaryings: {
+            GLuint program = lookup(programs, a.get<GLuint>());
+            GLenum bufferMode = a.get<GLenum>();
+            TraceBytes names = a.bytes();
+            std::vector<const GLchar*> varyings;
+            const GLchar* text = static_cast<const GLchar*>(names.data);
+            for (size_t offset = 0; offset < names.size; offset += std::strlen(text + offset) + 1)
+                varyings.push_back(text + offset);
+            glTransformFeedbackVaryings(program, static_cast<GLsizei>(varyings.size()), varyings.data(), bufferMode);
+            break;
+        }
+        case GlOp::BeginTransformFeedback:
+            glBeginTransformFeedback(a.get<GLenum>());
+            break;
+        case GlOp::EndTransformFeedback:
+            glEndTransformFeedback();
+            break;
+        case GlOp::DispatchCompute: {
+            GLuint x = a.get<GLuint>(), y = a.get<GLuint>();
+            glDispatchCompute(x, y, a.get<GLuint>());
+            break;
+        }
+        case GlOp::MemoryBarrier:
+            glMemoryBarrier(a.get<GLbitfield>());
+            break;
+        case GlOp::Count:
+            break;
+        }
+    }
+
+private:
+    using NameMap = std::unordered_map<GLuint, GLuint>;
+
+    // El nombre 0 (objeto por defecto) no se traduce.
+    static GLuint lookup(const NameMap& names, GLuint captured) {
+        if (captured == 0)
+            return 0;
+        auto found = names.find(captured);
+        return found != names.end() ? found->second : 0;
+    }
+
+    template <typename GenFn>
+    void generate(ArgReader& a, NameMap& names, GenFn gen) {
+        TraceBytes block = a.bytes();
+        GLsizei n = static_cast<GLsizei>(block.size / sizeof(GLuint));
+        const GLuint* captured = static_cast<const GLuint*>(block.data);
+        scratchNames.resize(n);
+        gen(n, scratchNames.data());
+        for (GLsizei i = 0; i < n; ++i) {
+            GLuint name;
+            std::memcpy(&name, captured + i, sizeof(name));
+            names[name] = scratchNames[i];
+        }
+    }
+
+    template <typename DeleteFn>
+    void release(ArgReader& a, NameMap& names, DeleteFn del) {
+        TraceBytes block = a.bytes();
+        GLsizei n = static_cast<GLsizei>(block.size / sizeof(GLuint));
+        scratchNames.resize(n);
+        for (GLsizei i = 0; i < n; ++i) {
+            GLuint name;
+            std::memcpy(&name, static_cast<const GLuint*>(block.data) + i, sizeof(name));
+            scratchNames[i] = lookup(names, name);
+            names.erase(name);
+        }
+        del(n, scratchNames.data());
+    }
+
+    static uint64_t locationKey(GLuint program, GLint location) {
+        return (static_cast<uint64_t>(program) << 32) | static_cast<uint32_t>(location);
+    }
+
+    // Ubicación de un uniform del programa en uso; -1 se pasa tal cual (el driver lo ignora).
+    GLint uniform(GLint captured) const {
+        if (captured < 0)
+            return captured;
+        auto found = locations.find(locationKey(currentProgram, captured));
+        return found != locations.end() ? found->second : captured;
+    }
+
+    const TraceFile& trace;
+    GLFWwindow* window;
+    NameMap buffers, vertexArrays, textures, renderbuffers, framebuffers, queries, shaders, programs;
+    std::unordered_map<uint64_t, GLsync> syncs;
+    std::unordered_map<uint64_t, GLint> locations;
+    std::unordered_map<uint64_t, GLuint> blockIndices;
+    GLuint currentProgram = 0;
+    std::vector<GLuint> scratchNames;
+    std::vector<uint8_t> scratchPixels;
+    GLint scratchInts[16];
+    GLchar scratchLog[4096];
+};
+
+// Costo acumulado de un tipo de llamada.
+struct CallCost {
+    size_t calls = 0;
+    double seconds = 0.0;
+};
+
+// Costo aproximado de leer el reloj dos veces, que se descuenta de cada llamada medida.
+double timerOverheadSeconds() {
+    const int samples = 100000;
+    auto start = ReplayClock::now();
+    volatile long long sink = 0;
+    for (int i = 0; i < samples; ++i) {
+        auto a = ReplayClock::now();
+        auto b = ReplayClock::now();
+        sink = sink + (b - a).count();
+    }
+    return std::chrono::duration<double>(ReplayClock::now() - start).count() / samples / 2.0;
+}
+
+// Reproduce la preparación y todos los fotogramas una vez, midiendo cada llamada.
+void replaySequential(const TraceFile& trace, TraceReplayer& replayer) {
+    double overhead = timerOverheadSeconds();
+    std::vector<CallCost> costs(static_cast<size_t>(GlOp::Count));
+    auto timed = [&](const TraceRecord& record) {
+        auto start = ReplayClock::now();
+        replayer.execute(record);
+        double seconds = std::chrono::duration<double>(ReplayClock::now() - start).count() - overhead;
+        CallCost& cost = costs[static_cast<size_t>(record.op)];
+        ++cost.calls;
+        cost.seconds += std::max(0.0, seconds);
+        return seconds;
+    };
+
+    auto setupStart = ReplayClock::now();
+    for (size_t r = 0; r < trace.setupEnd; ++r)
+        timed(trace.records[r]);
+    glFinish();
+    double setupSeconds = std::chrono::duration<double>(ReplayClock::now() - setupStart).count();
+    std::cout << "Preparación: " << trace.setupEnd << " llamadas, " << setupSeconds * 1e3 << " ms" << std::endl;
+
+    std::cout << "Fotogramas (emisión = llamadas de OpenGL en la CPU, total = hasta que la GPU termina):" << std::endl;
+    for (size_t f = 0; f < trace.frames.size(); ++f) {
+        const TraceFrame& frame = trace.frames[f];
+        // Lo que haya entre fotogramas (lecturas pendientes, etc.) se emite antes del siguiente
+        size_t from = f == 0 ? frame.begin : trace.frames[f - 1].end + 1;
+        for (size_t r = from; r < frame.begin; ++r)
+            timed(trace.records[r]);
+        auto start = ReplayClock::now();
+        double issue = 0.0;
+        for (size_t r = frame.begin; r <= frame.end; ++r)
+            issue += timed(trace.records[r]);
+        glFinish();
+        double total = std::chrono::duration<double>(ReplayClock::now() - start).count();
+        std::cout << "  " << f << ": " << frame.end - frame.begin - 1 << " llamadas, emisión " << issue * 1e3
+                  << " ms, total " << total * 1e3 << " ms (aplicación al capturar: " << frame.appSeconds * 1e3
+                  << " ms)" << std::endl;
+    }
+
+    std::vector<size_t> order;
+    for (size_t op = 0; op < costs.size(); ++op)
+        if (costs[op].calls > 0 && static_cast<GlOp>(op) != GlOp::FrameBegin)
+            order.push_back(op);
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return costs[a].seconds > costs[b].seconds; });
+    std::cout << "Costo por llamada (descontando " << overhead * 1e9 << " ns de medición):" << std::endl;
+    for (size_t op : order) {
+        const char* name = static_cast<GlOp>(op) == GlOp::FrameEnd ? "glfwSwapBuffers" : glOpName(static_cast<GlOp>(op));
+        std::cout << "  " << (static_cast<GlOp>(op) == GlOp::FrameEnd ? "" : "gl") << name << ": " << costs[op].calls
+                  << " llamadas, " << costs[op].seconds * 1e3 << " ms, " << costs[op].seconds / costs[op].calls * 1e6
+                  << " us por llamada" << std::endl;
+    }
+}
+
+// Repite un fotograma N veces sin medir llamada por llamada: el tiempo de emisión es el costo
+// del driver para ese flujo de llamadas, sin nada del trabajo de la aplicación.
+void replayLoop(const TraceFile& trace, TraceReplayer& replayer, size_t frameIndex, int iterations) {
+    const TraceFrame& frame = trace.frames[frameIndex];
+    std::vector<double> issue(iterations), total(iterations);
+    for (int i = 0; i < iterations; ++i) {
+        auto start = ReplayClock::now();
+        for (size_t r = frame.begin; r <= frame.end; ++r)
+            replayer.execute(trace.records[r]);
+        auto issued = ReplayClock::now();
+        glFinish();
+        issue[i] = std::chrono::duration<double>(issued - start).count();
+        total[i] = std::chrono::duration<double>(ReplayClock::now() - start).count();
+    }
+
+    auto summarize = [](std::vector<double> values) {
+        std::sort(values.begin(), values.end());
+        double sum = 0.0;
+        for (double v : values)
+            sum += v;
+        std::cout << "promedio " << sum / values.size() * 1e3 << " ms, mínimo " << values.front() * 1e3
+                  << " ms, mediana " << values[values.size() / 2] * 1e3 << " ms";
+    };
+    size_t calls = frame.end - frame.begin - 1;
+    std::cout << "Fotograma " << frameIndex << " repetido " << iterations << " veces (" << calls << " llamadas"
+              << (frame.presented ? ", con presentación" : "") << ")" << std::endl;
+    std::cout << "  emisión: ";
+    summarize(issue);
+    std::cout << std::endl << "  total:   ";
+    summarize(total);
+    std::cout << std::endl;
+    std::sort(issue.begin(), issue.end());
+    double driver = issue[issue.size() / 2];
+    std::cout << "  costo del driver por llamada: " << driver / std::max<size_t>(calls, 1) * 1e6 << " us" << std::endl;
+    std::cout << "  la aplicación tardó " << frame.appSeconds * 1e3 << " ms en ese fotograma al capturar: "
+              << std::max(0.0, frame.appSeconds - driver) * 1e3 << " ms fueron trabajo propio y captura" << std::endl;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cerr << "Uso: " << argv[0] << " traza.gltr [--loop fotograma N] [--visible]" << std::endl;
+        return -1;
+    }
+    int loopFrame = -1, loopCount = 0;
+    bool visible = false;
+    for (int i = 2; i < argc; ++i) {
+        if (!std::strcmp(argv[i], "--loop") && i + 2 < argc) {
+            loopFrame = std::atoi(argv[++i]);
+            loopCount = std::max(1, std::atoi(argv[++i]));
+        } else if (!std::strcmp(argv[i], "--visible")) {
+            visible = true;
+        } else {
+            std::cerr << "Argumento desconocido: " << argv[i] << std::endl;
+            return -1;
+        }
+    }
+
+    TraceFile trace;
+    if (!trace.load(argv[1]))
+        return -1;
+    std::cout << "Traza " << argv[1] << ": " << trace.records.size() << " registros, " << trace.frames.size()
+              << " fotogramas, ventana de " << trace.header.width << "x" << trace.header.height << std::endl;
+    if (loopFrame >= static_cast<int>(trace.frames.size())) {
+        std::cerr << "La traza no tiene el fotograma " << loopFrame << std::endl;
+        return -1;
+    }
+
+    if (!glfwInit()) {
+        std::cerr << "No se pudo inicializar GLFW" << std::endl;
+        return -1;
+    }
+    // La misma ventana que al capturar, para que el framebuffer por defecto sea equivalente
+    glfwWindowHint(GLFW_SAMPLES, trace.header.samples);
+    glfwWindowHint(GLFW_VISIBLE, visible ? GLFW_TRUE : GLFW_FALSE);
+    GLFWwindow* window = glfwCreateWindow(trace.header.width, trace.header.height, "Reproducción de traza", NULL, NULL);
+    if (!window) {
+        std::cerr << "No se pudo crear la ventana GLFW" << std::endl;
+        glfwTerminate();
+        return -1;
+    }
+    glfwMakeContextCurrent(window);
+    if (glewInit() != GLEW_OK) {
+        std::cerr << "No se pudo inicializar GLEW" << std::endl;
+        glfwTerminate();
+        return -1;
+    }
+    glfwSwapInterval(0); // Lo más rápido posible
+
+    TraceReplayer replayer(trace, window);
+    replaySequential(trace, replayer);
+    if (loopFrame >= 0)
+        replayLoop(trace, replayer, static_cast<size_t>(loopFrame), loopCount);
+
+    glfwTerminate();
+    return 0;
+}
@@ -0,0 +1,949 @@
+#pragma once
+// Captura del flujo de llamadas de OpenGL para analizar el rendimiento fuera de la aplicación.
+// Cada llamada que usa main6 pasa por un envoltorio delgado: la llamada real se emite siempre y,
+// solo mientras hay una captura activa, se serializa junto con sus datos (contenido de buffers
+// y texturas, código de los shaders) en una traza binaria compacta. gl_replay.cpp vuelve a
+// emitir la traza en otro proceso.
+//
+// Incluir después de glew.h y antes de cualquier código que llame a OpenGL: al final del
+// archivo los nombres gl* se redirigen a los envoltorios. Con GL_TRACE_DISABLE definido no se
+// redirige nada (así lo incluye el reproductor, que necesita las funciones reales).
+//
+// Formato: cabecera "GLTR" + versión + tamaño y muestras de la ventana + número de
+// fotogramas, seguida de registros { u16 operación, u32 bytes de argumentos, argumentos }.
+// Los objetos se guardan con el nombre que les dio el driver al capturar; el reproductor
+// traduce cada nombre al que obtiene él. Las llamadas entre FrameBegin y FrameEnd forman un
+// fotograma; las anteriores al primero son la preparación (creación de recursos).
+
+#include <GL/glew.h>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#define GL_TRACE_OPS(X)                                                                          \
+    X(FrameBegin) X(FrameEnd)                                                                     \
+    X(Clear) X(ClearColor) X(Enable) X(Disable) X(Viewport) X(PixelStorei) X(GetIntegerv)         \
+    X(GenBuffers) X(DeleteBuffers) X(BindBuffer) X(BufferData) X(MapBufferRange) X(UnmapBuffer)   \
+    X(GenVertexArrays) X(DeleteVertexArrays) X(BindVertexArray) X(VertexAttribPointer)            \
+    X(EnableVertexAttribArray)                                                                    \
+    X(CreateShader) X(ShaderSource) X(CompileShader) X(GetShaderiv) X(GetShaderInfoLog)           \
+    X(DeleteShader) X(CreateProgram) X(AttachShader) X(LinkProgram) X(GetProgramiv)               \
+    X(GetProgramInfoLog) X(DeleteProgram) X(UseProgram)                                           \
+    X(GetUniformLocation) X(Uniform1i) X(Uniform1f) X(Uniform3fv) X(UniformMatrix4fv)             \
+    X(GenTextures) X(DeleteTextures) X(ActiveTexture) X(BindTexture) X(TexParameteri)             \
+    X(TexImage2D)                                                                                 \
+    X(GenRenderbuffers) X(DeleteRenderbuffers) X(BindRenderbuffer) X(RenderbufferStorage)         \
+    X(RenderbufferStorageMultisample)                                                             \
+    X(GenFramebuffers) X(DeleteFramebuffers) X(BindFramebuffer) X(FramebufferRenderbuffer)        \
+    X(CheckFramebufferStatus) X(BlitFramebuffer)                                                  \
+    X(ReadPixels) X(FenceSync) X(ClientWaitSync) X(DeleteSync)                                    \
+    X(GenQueries) X(DeleteQueries) X(BeginQuery) X(EndQuery) X(GetQueryObjectui64v)               \
+    X(DrawArrays)                                                                                 \
+    X(BindBufferRange) X(BufferSubData) X(GetUniformBlockIndex) X(UniformBlockBinding)          \
+    X(ColorMask) X(DepthMask) X(DepthFunc) X(StencilFunc) X(StencilOp)                           \
+    X(BindBufferBase) X(VertexAttribDivisor) X(DrawArraysInstanced) X(TransformFeedbackVaryings)  \
+    X(BeginTransformFeedback) X(EndTransformFeedback) X(DispatchCompute) X(MemoryBarrier)         \
+    X(TexSubImage2D) X(TexImage3D) X(FramebufferTexture) X(FramebufferTextureLayer)              \
+    X(ViewportIndexedf)
+
+enum class GlOp : uint16_t {
+#define GL_TRACE_ENUM(name) name,
+    GL_TRACE_OPS(GL_TRACE_ENUM)
+#undef GL_TRACE_ENUM
+    Count
+};
+
+inline const char* glOpName(GlOp op) {
+    static const char* names[] = {
+#define GL_TRACE_NAME(name) #name,
+        GL_TRACE_OPS(GL_TRACE_NAME)
+#undef GL_TRACE_NAME
+    };
+    return op < GlOp::Count ? names[static_cast<int>(op)] : "?";
+}
+
+const uint32_t kGlTraceVersion = 1;
+const size_t kGlTraceRecordHeader = sizeof(uint16_t) + sizeof(uint32_t);
+
+struct GlTraceHeader {
+    char magic[4];
+    uint32_t version;
+    int32_t width, height, samples; // Ventana de la aplicación al capturar
+    uint32_t frames;
+};
+
+// Bloque de bytes de longitud variable dentro de un registro (u32 longitud + datos).
+struct TraceBytes {
+    const void* data;
+    size_t size;
+};
+
+// Bytes por píxel de las combinaciones de formato y tipo que usan los ejemplos.
+inline size_t glPixelBytes(GLenum format, GLenum type) {
+    size_t channels = 4;
+    switch (format) {
+    case GL_RED:
+    case GL_DEPTH_COMPONENT:
+        channels = 1;
+        break;
+    case GL_RG:
+        channels = 2;
+        break;
+    case GL_RGB:
+    case GL_BGR:
+        channels = 3;
+        break;
+    }
+    switch (type) {
+    case GL_FLOAT:
+    case GL_UNSIGNED_INT:
+        return channels * 4;
+    case GL_HALF_FLOAT:
+    case GL_UNSIGNED_SHORT:
+        return channels * 2;
+    default:
+        return channels;
+    }
+}
+
+// Bytes de una imagen de w x h con la alineación de filas indicada.
+inline size_t glImageBytes(int w, int h, GLenum format, GLenum type, int alignment) {
+    if (w <= 0 || h <= 0)
+        return 0;
+    size_t row = static_cast<size_t>(w) * glPixelBytes(format, type);
+    size_t stride = (row + alignment - 1) / alignment * alignment;
+    return stride * (h - 1) + row;
+}
+
+class GlTraceWriter {
+public:
+    // Empieza a grabar; la traza se escribe al completar maxFrames fotogramas o en finish().
+    void start(const std::string& file, int width, int height, int samples, int maxFrames) {
+        path = file;
+        header = { { 'G', 'L', 'T', 'R' }, kGlTraceVersion, width, height, samples, 0 };
+        frameLimit = maxFrames;
+        bytes.clear();
+        calls = 0;
+        active = true;
+    }
+
+    bool recording() const { return active; }
+
+    template <typename... Args>
+    void record(GlOp op, const Args&... args) {
+        size_t start = bytes.size();
+        put(static_cast<uint16_t>(op));
+        put(uint32_t(0));
+        (put(args), ...);
+        uint32_t payload = static_cast<uint32_t>(bytes.size() - start - kGlTraceRecordHeader);
+        std::memcpy(bytes.data() + start + sizeof(uint16_t), &payload, sizeof(payload));
+        ++calls;
+    }
+
+    // Delimitan un fotograma de la aplicación. presented indica si terminó con un
+    // glfwSwapBuffers; el reproductor también presenta ese fotograma.
+    void beginFrame() {
+        if (!active)
+            return;
+        record(GlOp::FrameBegin);
+        frameStart = std::chrono::steady_clock::now();
+    }
+
+    void endFrame(bool presented) {
+        if (!active)
+            return;
+        // Tiempo de CPU que la aplicación dedicó al fotograma (incluye el costo de la captura)
+        double appSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - frameStart).count();
+        record(GlOp::FrameEnd, static_cast<uint8_t>(presented), appSeconds);
+        if (++header.frames >= static_cast<uint32_t>(frameLimit))
+            finish();
+    }
+
+    // Escribe la traza y deja de grabar. Sin efecto si no había captura activa.
+    bool finish() {
+        if (!active)
+            return false;
+        active = false;
+        FILE* file = std::fopen(path.c_str(), "wb");
+        bool ok = file && std::fwrite(&header, sizeof(header), 1, file) == 1 &&
+                  std::fwrite(bytes.data(), 1, bytes.size(), file) == bytes.size();
+        if (file)
+            std::fclose(file);
+        if (!ok) {
+            std::cerr << "No se pudo escribir la traza " << path << std::endl;
+            return false;
+        }
+        std::cout << "Traza de OpenGL: " << header.frames << " fotogramas, " << calls << " llamadas, "
+                  << bytes.size() / 1024.0 << " KB en " << path << std::endl;
+        bytes = std::vector<uint8_t>();
+        return true;
+    }
+
+    // Estado de desempaquetado y empaquetado necesario para saber cuántos bytes guardar.
+    unsigned int packBuffer = 0, unpackBuffer = 0;
+    int unpackAlignment = 4;
+
+private:
+    template <typename T>
+    void put(const T& value) {
+        static_assert(std::is_trivially_copyable<T>::value, "solo tipos triviales en la traza");
+        const uint8_t* raw = reinterpret_cast<const uint8_t*>(&value);
+        bytes.insert(bytes.end(), raw, raw + sizeof(T));
+    }
+
+    void put(const TraceBytes& block) {
+        put(static_cast<uint32_t>(block.size));
+        const uint8_t* raw = static_cast<const uint8_t*>(block.data);
+        if (block.size)
+            bytes.insert(bytes.end(), raw, raw + block.size);
+    }
+
+    std::string path;
+    GlTraceHeader header = {};
+    int frameLimit = 0;
+    bool active = false;
+    std::vector<uint8_t> bytes;
+    size_t calls = 0;
+    std::chrono::steady_clock::time_point frameStart;
+};
+
+inline GlTraceWriter glTrace;
+
+inline uint64_t glTraceHandle(const void* pointer) { return static_cast<uint64_t>(reinterpret_cast<uintptr_t>(pointer)); }
+
+// Envoltorios: emiten la llamada real y, si hay captura, la registran con su resultado.
+inline void traceClear(GLbitfield mask) {
+    glClear(mask);
+    if (glTrace.recording())
+        glTrace.record(GlOp::Clear, mask);
+}
+
+inline void traceClearColor(GLfloat r, GLfloat g, GLfloat b, GLfloat a) {
+    glClearColor(r, g, b, a);
+    if (glTrace.recording())
+        glTrace.record(GlOp::ClearColor, r, g, b, a);
+}
+
+inline void traceEnable(GLenum cap) {
+    glEnable(cap);
+    if (glTrace.recording())
+        glTrace.record(GlOp::Enable, cap);
+}
+
+inline void traceDisable(GLenum cap) {
+    glDisable(cap);
+    if (glTrace.recording())
+        glTrace.record(GlOp::Disable, cap);
+}
+
+inline void traceViewport(GLint x, GLint y, GLsizei w, GLsizei h) {
+    glViewport(x, y, w, h);
+    if (glTrace.recording())
+        glTrace.record(GlOp::Viewport, x, y, w, h);
+}
+
+inline void traceViewportIndexedf(GLuint index, GLfloat x, GLfloat y, GLfloat w, GLfloat h) {
+    glViewportIndexedf(index, x, y, w, h);
+    if (glTrace.recording())
+        glTrace.record(GlOp::ViewportIndexedf, index, x, y, w, h);
+}
+
+inline void tracePixelStorei(GLenum pname, GLint param) {
+    glPixelStorei(pname, param);
+    if (pname == GL_UNPACK_ALIGNMENT)
+        glTrace.unpackAlignment = param;
+    if (glTrace.recording())
+        glTrace.record(GlOp::PixelStorei, pname, param);
+}
+
+inline void traceGetIntegerv(GLenum pname, GLint* data) {
+    glGetIntegerv(pname, data);
+    if (glTrace.recording())
+        glTrace.record(GlOp::GetIntegerv, pname);
+}
+
+// glGen*/glDelete* comparten formato: n seguido de los nombres.
+inline void traceNames(GlOp op, GLsizei n, const GLuint* names) {
+    if (glTrace.recording())
+        glTrace.record(op, TraceBytes{ names, sizeof(GLuint) * n });
+}
+
+inline void traceGenBuffers(GLsizei n, GLuint* names) {
+    glGenBuffers(n, names);
+    traceNames(GlOp::GenBuffers, n, names);
+}
+
+inline void traceDeleteBuffers(GLsizei n, const GLuint* names) {
+    glDeleteBuffers(n, names);
+    traceNames(GlOp::DeleteBuffers, n, names);
+}
+
+inline void traceBindBuffer(GLenum target, GLuint buffer) {
+    glBindBuffer(target, buffer);
+    if (target == GL_PIXEL_PACK_BUFFER)
+        glTrace.packBuffer = buffer;
+    else if (target == GL_PIXEL_UNPACK_BUFFER)
+        glTrace.unpackBuffer = buffer;
+    if (glTrace.recording())
+        glTrace.record(GlOp::BindBuffer, target, buffer);
+}
+
+inline void traceBufferData(GLenum target, GLsizeiptr size, const void* data, GLenum usage) {
+    glBufferData(target, size, data, usage);
+    if (glTrace.recording())
+        glTrace.record(GlOp::BufferData, target, static_cast<uint64_t>(size), usage,
+                       TraceBytes{ data, data ? static_cast<size_t>(size) : 0 });
+}
+
+// Lo que la aplicación escriba o lea a través del puntero mapeado no se captura; los ejemplos
+// solo mapean para leer.
+inline void* traceMapBufferRange(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access) {
+    void* data = glMapBufferRange(target, offset, length, access);
+    if (glTrace.recording())
+        glTrace.record(GlOp::MapBufferRange, target, static_cast<uint64_t>(offset), static_cast<uint64_t>(length), access);
+    return data;
+}
+
+inline GLboolean traceUnmapBuffer(GLenum target) {
+    GLboolean ok = glUnmapBuffer(target);
+    if (glTrace.recording())
+        glTrace.record(GlOp::UnmapBuffer, target);
+    return ok;
+}
+
+inline void traceGenVertexArrays(GLsizei n, GLuint* names) {
+    glGenVertexArrays(n, names);
+    traceNames(GlOp::GenVertexArrays, n, names);
+}
+
+inline void traceDeleteVertexArrays(GLsizei n, const GLuint* names) {
+    glDeleteVertexArrays(n, names);
+    traceNames(GlOp::DeleteVertexArrays, n, names);
+}
+
+inline void traceBindVertexArray(GLuint vao) {
+    glBindVertexArray(vao);
+    if (glTrace.recording())
+        glTrace.record(GlOp::BindVertexArray, vao);
+}
+
+// El puntero es un desplazamiento dentro del VBO enlazado.
+inline void traceVertexAttribPointer(GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride,
+                                     const void* pointer) {
+    glVertexAttribPointer(index, size, type, normalized, stride, pointer);
+    if (glTrace.recording())
+        glTrace.record(GlOp::VertexAttribPointer, index, size, type, normalized, stride, glTraceHandle(pointer));
+}
+
+inline void traceEnableVertexAttribArray(GLuint index) {
+    glEnableVertexAttribArray(index);
+    if (glTrace.recording())
+        glTrace.record(GlOp::EnableVertexAttribArray, index);
+}
+
+inline GLuint traceCreateShader(GLenum type) {
+    GLuint shader = glCreateShader(type);
+    if (glTrace.recording())
+        glTrace.record(GlOp::CreateShader, type, shader);
+    return shader;
+}
+
+// Las cadenas se concatenan en un solo bloque.
+inline void traceShaderSource(GLuint shader, GLsizei count, const GLchar* const* strings, const GLint* lengths) {
+    glShaderSource(shader, count, strings, lengths);
+    if (!glTrace.recording())
+        return;
+    std::string source;
+    for (GLsizei i = 0; i < count; ++i)
+        source.append(strings[i], lengths && lengths[i] >= 0 ? static_cast<size_t>(lengths[i]) : std::strlen(strings[i]));
+    glTrace.record(GlOp::ShaderSource, shader, TraceBytes{ source.data(), source.size() });
+}
+
+inline void traceCompileShader(GLuint shader) {
+    glCompileShader(shader);
+    if (glTrace.recording())
+        glTrace.record(GlOp::CompileShader, shader);
+}
+
+inline void traceGetShaderiv(GLuint shader, GLenum pname, GLint* params) {
+    glGetShaderiv(shader, pname, params);
+    if (glTrace.recording())
+        glTrace.record(GlOp::GetShaderiv, shader, pname);
+}
+
+inline void traceGetShaderInfoLog(GLuint shader, GLsizei bufSize, GLsizei* length, GLchar* log) {
+    glGetShaderInfoLog(shader, bufSize, length, log);
+    if (glTrace.recording())
+        glTrace.record(GlOp::GetShaderInfoLog, shader, bufSize);
+}
+
+inline void traceDeleteShader(GLuint shader) {
+    glDeleteShader(shader);
+    if (glTrace.recording())
+        glTrace.record(GlOp::DeleteShader, shader);
+}
+
+inline GLuint traceCreateProgram() {
+    GLuint program = glCreateProgram();
+    if (glTrace.recording())
+        glTrace.record(GlOp::CreateProgram, program);
+    return program;
+}
+
+inline void traceAttachShader(GLuint program, GLuint shader) {
+    glAttachShader(program, shader);
+    if (glTrace.recording())
+        glTrace.record(GlOp::AttachShader, program, shader);
+}
+
+inline void traceLinkProgram(GLuint program) {
+    glLinkProgram(program);
+    if (glTrace.recording())
+        glTrace.record(GlOp::LinkProgram, program);
+}
+
+inline void traceGetProgramiv(GLuint program, GLenum pname, GLint* params) {
+    glGetProgramiv(program, pname, params);
+    if (glTrace.recording())
+        glTrace.record(GlOp::GetProgramiv, program, pname);
+}
+
+inline void traceGetProgramInfoLog(GLuint program, GLsizei bufSize, GLsizei* length, GLchar* log) {
+    glGetProgramInfoLog(program, bufSize, length, log);
+    if (glTrace.recording())
+        glTrace.record(GlOp::GetProgramInfoLog, program, bufSize);
+}
+
+inline void traceDeleteProgram(GLuint program) {
+    glDeleteProgram(program);
+    if (glTrace.recording())
+        glTrace.record(GlOp::DeleteProgram, program);
+}
+
+inline void traceUseProgram(GLuint program) {
+    glUseProgram(program);
+    if (glTrace.recording())
+        glTrace.record(GlOp::UseProgram, program);
+}
+
+// Se guarda la ubicación obtenida para traducir las llamadas glUniform* posteriores.
+inline GLint traceGetUniformLocation(GLuint program, const GLchar* name) {
+    GLint location = glGetUniformLocation(program, name);
+    if (glTrace.recording())
+        glTrace.record(GlOp::GetUniformLocation, program, location, TraceBytes{ name, std::strlen(name) });
+    return location;
+}
+
+inline void traceUniform1i(GLint location, GLint value) {
+    glUniform1i(location, value);
+    if (glTrace.recording())
+        glTrace.record(GlOp::Uniform1i, location, value);
+}
+
+inline void traceUniform1f(GLint location, GLfloat value) {
+    glUniform1f(location, value);
+    if (glTrace.recording())
+        glTrace.record(GlOp::Uniform1f, location, value);
+}
+
+inline void traceUniform3fv(GLint location, GLsizei count, const GLfloat* value) {
+    glUniform3fv(location, count, value);
+    if (glTrace.recording())
+        glTrace.record(GlOp::Uniform3fv, location, TraceBytes{ value, sizeof(GLfloat) * 3 * count });
+}
+
+inline void traceUniformMatrix4fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat* value) {
+    glUniformMatrix4fv(location, count, transpose, value);
+    if (glTrace.recording())
+        glTrace.record(GlOp::UniformMatrix4fv, location, transpose, TraceBytes{ value, sizeof(GLfloat) * 16 * count });
+}
+
+inline void traceGenTextures(GLsizei n, GLuint* names) {
+    glGenTextures(n, names);
+    traceNames(GlOp::GenTextures, n, names);
+}
+
+inline void traceDeleteTextures(GLsizei n, const GLuint* names) {
+    glDeleteTextures(n, names);
+    traceNames(GlOp::DeleteTextures, n, names);
+}
+
+inline void traceActiveTexture(GLenum unit) {
+    glActiveTexture(unit);
+    if (glTrace.recording())
+        glTrace.record(GlOp::ActiveTexture, unit);
+}
+
+inline void traceBindTexture(GLenum target, GLuint texture) {
+    glBindTexture(target, texture);
+    if (glTrace.recording())
+        glTrace.record(GlOp::BindTexture, target, texture);
+}
+
+inline void traceTexParameteri(GLenum target, GLenum pname, GLint param) {
+    glTexParameteri(target, pname, param);
+    if (glTrace.recording())
+        glTrace.record(GlOp::TexParameteri, target, pname, param);
+}
+
+// Con un PBO de desempaquetado enlazado, data es un desplazamiento y no se copian píxeles.
+inline void traceTexImage2D(GLenum target, GLint level, GLint internalFormat, GLsizei w, GLsizei h, GLint border,
+                            GLenum format, GLenum type, const void* data) {
+    glTexImage2D(target, level, internalFormat, w, h, border, format, type, data);
+    if (!glTrace.recording())
+        return;
+    bool fromBuffer = glTrace.unpackBuffer != 0;
+    size_t size = data && !fromBuffer ? glImageBytes(w, h, format, type, glTrace.unpackAlignment) : 0;
+    glTrace.record(GlOp::TexImage2D, target, level, internalFormat, w, h, border, format, type,
+                   static_cast<uint8_t>(fromBuffer), glTraceHandle(fromBuffer ? data : nullptr), TraceBytes{ data, size });
+}
+
+inline void traceTexSubImage2D(GLenum target, GLint level, GLint x, GLint y, GLsizei w, GLsizei h, GLenum format,
+                               GLenum type, const void* data) {
+    glTexSubImage2D(target, level, x, y, w, h, format, type, data);
+    if (!glTrace.recording())
+        return;
+    bool fromBuffer = glTrace.unpackBuffer != 0;
+    size_t size = data && !fromBuffer ? glImageBytes(w, h, format, type, glTrace.unpackAlignment) : 0;
+    glTrace.record(GlOp::TexSubImage2D, target, level, x, y, w, h, format, type, static_cast<uint8_t>(fromBuffer),
+                   glTraceHandle(fromBuffer ? data : nullptr), TraceBytes{ data, size });
+}
+
+inline void traceTexImage3D(GLenum target, GLint level, GLint internalFormat, GLsizei w, GLsizei h, GLsizei depth,
+                            GLint border, GLenum format, GLenum type, const void* data) {
+    glTexImage3D(target, level, internalFormat, w, h, depth, border, format, type, data);
+    if (!glTrace.recording())
+        return;
+    bool fromBuffer = glTrace.unpackBuffer != 0;
+    size_t size = data && !fromBuffer ? glImageBytes(w, h * depth, format, type, glTrace.unpackAlignment) : 0;
+    glTrace.record(GlOp::TexImage3D, target, level, internalFormat, w, h, depth, border, format, type,
+                   static_cast<uint8_t>(fromBuffer), glTraceHandle(fromBuffer ? data : nullptr), TraceBytes{ data, size });
+}
+
+inline void traceGenRenderbuffers(GLsizei n, GLuint* names) {
+    glGenRenderbuffers(n, names);
+    traceNames(GlOp::GenRenderbuffers, n, names);
+}
+
+inline void traceDeleteRenderbuffers(GLsizei n, const GLuint* names) {
+    glDeleteRenderbuffers(n, names);
+    traceNames(GlOp::DeleteRenderbuffers, n, names);
+}
+
+inline void traceBindRenderbuffer(GLenum target, GLuint renderbuffer) {
+    glBindRenderbuffer(target, renderbuffer);
+    if (glTrace.recording())
+        glTrace.record(GlOp::BindRenderbuffer, target, renderbuffer);
+}
+
+inline void traceRenderbufferStorage(GLenum target, GLenum internalFormat, GLsizei w, GLsizei h) {
+    glRenderbufferStorage(target, internalFormat, w, h);
+    if (glTrace.recording())
+        glTrace.record(GlOp::RenderbufferStorage, target, internalFormat, w, h);
+}
+
+inline void traceRenderbufferStorageMultisample(GLenum target, GLsizei samples, GLenum internalFormat, GLsizei w, GLsizei h) {
+    glRenderbufferStorageMultisample(target, samples, internalFormat, w, h);
+    if (glTrace.recording())
+        glTrace.record(GlOp::RenderbufferStorageMultisample, target, samples, internalFormat, w, h);
+}
+
+inline void traceGenFramebuffers(GLsizei n, GLuint* names) {
+    glGenFramebuffers(n, names);
+    traceNames(GlOp::GenFramebuffers, n, names);
+}
+
+inline void traceDeleteFramebuffers(GLsizei n, const GLuint* names) {
+    glDeleteFramebuffers(n, names);
+    traceNames(GlOp::DeleteFramebuffers, n, names);
+}
+
+inline void traceBindFramebuffer(GLenum target, GLuint framebuffer) {
+    glBindFramebuffer(target, framebuffer);
+    if (glTrace.recording())
+        glTrace.record(GlOp::BindFramebuffer, target, framebuffer);
+}
+
+inline void traceFramebufferRenderbuffer(GLenum target, GLenum attachment, GLenum rbTarget, GLuint renderbuffer) {
+    glFramebufferRenderbuffer(target, attachment, rbTarget, renderbuffer);
+    if (glTrace.recording())
+        glTrace.record(GlOp::FramebufferRenderbuffer, target, attachment, rbTarget, renderbuffer);
+}
+
+inline void traceFramebufferTexture(GLenum target, GLenum attachment, GLuint texture, GLint level) {
+    glFramebufferTexture(target, attachment, texture, level);
+    if (glTrace.recording())
+        glTrace.record(GlOp::FramebufferTexture, target, attachment, texture, level);
+}
+
+inline void traceFramebufferTextureLayer(GLenum target, GLenum attachment, GLuint texture, GLint level, GLint layer) {
+    glFramebufferTextureLayer(target, attachment, texture, level, layer);
+    if (glTrace.recording())
+        glTrace.record(GlOp::FramebufferTextureLayer, target, attachment, texture, level, layer);
+}
+
+inline GLenum traceCheckFramebufferStatus(GLenum target) {
+    GLenum status = glCheckFramebufferStatus(target);
+    if (glTrace.recording())
+        glTrace.record(GlOp::CheckFramebufferStatus, target);
+    return status;
+}
+
+inline void traceBlitFramebuffer(GLint srcX0, GLint srcY0, GLint srcX1, GLint srcY1, GLint dstX0, GLint dstY0,
+                                 GLint dstX1, GLint dstY1, GLbitfield mask, GLenum filter) {
+    glBlitFramebuffer(srcX0, srcY0, srcX1, srcY1, dstX0, dstY0, dstX1, dstY1, mask, filter);
+    if (glTrace.recording())
+        glTrace.record(GlOp::BlitFramebuffer, srcX0, srcY0, srcX1, srcY1, dstX0, dstY0, dstX1, dstY1, mask, filter);
+}
+
+// Con un PBO de empaquetado enlazado, data es un desplazamiento; si no, el reproductor lee a
+// memoria propia.
+inline void traceReadPixels(GLint x, GLint y, GLsizei w, GLsizei h, GLenum format, GLenum type, void* data) {
+    glReadPixels(x, y, w, h, format, type, data);
+    if (glTrace.recording())
+        glTrace.record(GlOp::ReadPixels, x, y, w, h, format, type, static_cast<uint8_t>(glTrace.packBuffer != 0),
+                       glTraceHandle(glTrace.packBuffer ? data : nullptr));
+}
+
+inline GLsync traceFenceSync(GLenum condition, GLbitfield flags) {
+    GLsync sync = glFenceSync(condition, flags);
+    if (glTrace.recording())
+        glTrace.record(GlOp::FenceSync, condition, flags, glTraceHandle(sync));
+    return sync;
+}
+
+inline GLenum traceClientWaitSync(GLsync sync, GLbitfield flags, GLuint64 timeout) {
+    GLenum status = glClientWaitSync(sync, flags, timeout);
+    if (glTrace.recording())
+        glTrace.record(GlOp::ClientWaitSync, glTraceHandle(sync), flags, static_cast<uint64_t>(timeout));
+    return status;
+}
+
+inline void traceDeleteSync(GLsync sync) {
+    glDeleteSync(sync);
+    if (glTrace.recording())
+        glTrace.record(GlOp::DeleteSync, glTraceHandle(sync));
+}
+
+inline void traceGenQueries(GLsizei n, GLuint* names) {
+    glGenQueries(n, names);
+    traceNames(GlOp::GenQueries, n, names);
+}
+
+inline void traceDeleteQueries(GLsizei n, const GLuint* names) {
+    glDeleteQueries(n, names);
+    traceNames(GlOp::DeleteQueries, n, names);
+}
+
+inline void traceBeginQuery(GLenum target, GLuint query) {
+    glBeginQuery(target, query);
+    if (glTrace.recording())
+        glTrace.record(GlOp::BeginQuery, target, query);
+}
+
+inline void traceEndQuery(GLenum target) {
+    glEndQuery(target);
+    if (glTrace.recording())
+        glTrace.record(GlOp::EndQuery, target);
+}
+
+inline void traceGetQueryObjectui64v(GLuint query, GLenum pname, GLuint64* params) {
+    glGetQueryObjectui64v(query, pname, params);
+    if (glTrace.recording())
+        glTrace.record(GlOp::GetQueryObjectui64v, query, pname);
+}
+
+inline void traceDrawArrays(GLenum mode, GLint first, GLsizei count) {
+    glDrawArrays(mode, first, count);
+    if (glTrace.recording())
+        glTrace.record(GlOp::DrawArrays, mode, first, count);
+}
+
+inline void traceBindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size) {
+    glBindBufferRange(target, index, buffer, offset, size);
+    if (glTrace.recording())
+        glTrace.record(GlOp::BindBufferRange, target, index, buffer, static_cast<uint64_t>(offset), static_cast<uint64_t>(size));
+}
+
+inline void traceBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void* data) {
+    glBufferSubData(target, offset, size, data);
+    if (glTrace.recording())
+        glTrace.record(GlOp::BufferSubData, target, static_cast<uint64_t>(offset), TraceBytes{ data, static_cast<size_t>(size) });
+}
+
+// Como con las ubicaciones de uniforms, se guarda el índice obtenido para traducirlo después.
+inline GLuint traceGetUniformBlockIndex(GLuint program, const GLchar* name) {
+    GLuint index = glGetUniformBlockIndex(program, name);
+    if (glTrace.recording())
+        glTrace.record(GlOp::GetUniformBlockIndex, program, index, TraceBytes{ name, std::strlen(name) });
+    return index;
+}
+
+inline void traceUniformBlockBinding(GLuint program, GLuint blockIndex, GLuint binding) {
+    glUniformBlockBinding(program, blockIndex, binding);
+    if (glTrace.recording())
+        glTrace.record(GlOp::UniformBlockBinding, program, blockIndex, binding);
+}
+
+inline void traceColorMask(GLboolean r, GLboolean g, GLboolean b, GLboolean a) {
+    glColorMask(r, g, b, a);
+    if (glTrace.recording())
+        glTrace.record(GlOp::ColorMask, r, g, b, a);
+}
+
+inline void traceDepthMask(GLboolean flag) {
+    glDepthMask(flag);
+    if (glTrace.recording())
+        glTrace.record(GlOp::DepthMask, flag);
+}
+
+inline void traceDepthFunc(GLenum func) {
+    glDepthFunc(func);
+    if (glTrace.recording())
+        glTrace.record(GlOp::DepthFunc, func);
+}
+
+inline void traceStencilFunc(GLenum func, GLint ref, GLuint mask) {
+    glStencilFunc(func, ref, mask);
+    if (glTrace.recording())
+        glTrace.record(GlOp::StencilFunc, func, ref, mask);
+}
+
+inline void traceStencilOp(GLenum stencilFail, GLenum depthFail, GLenum depthPass) {
+    glStencilOp(stencilFail, depthFail, depthPass);
+    if (glTrace.recording())
+        glTrace.record(GlOp::StencilOp, stencilFail, depthFail, depthPass);
+}
+
+inline void traceBindBufferBase(GLenum target, GLuint index, GLuint buffer) {
+    glBindBufferBase(target, index, buffer);
+    if (glTrace.recording())
+        glTrace.record(GlOp::BindBufferBase, target, index, buffer);
+}
+
+inline void traceVertexAttribDivisor(GLuint index, GLuint divisor) {
+    glVertexAttribDivisor(index, divisor);
+    if (glTrace.recording())
+        glTrace.record(GlOp::VertexAttribDivisor, index, divisor);
+}
+
+inline void traceDrawArraysInstanced(GLenum mode, GLint first, GLsizei count, GLsizei instances) {
+    glDrawArraysInstanced(mode, first, count, instances);
+    if (glTrace.recording())
+        glTrace.record(GlOp::DrawArraysInstanced, mode, first, count, instances);
+}
+
+// Los nombres se guardan juntos, cada uno terminado en '\0'.
+inline void traceTransformFeedbackVaryings(GLuint program, GLsizei count, const GLchar* const* varyings, GLenum bufferMode) {
+    glTransformFeedbackVaryings(program, count, varyings, bufferMode);
+    if (!glTrace.recording())
+        return;
+    std::string names;
+    for (GLsizei i = 0; i < count; ++i)
+        names.append(varyings[i], std::strlen(varyings[i]) + 1);
+    glTrace.record(GlOp::TransformFeedbackVaryings, program, bufferMode, TraceBytes{ names.data(), names.size() });
+}
+
+inline void traceBeginTransformFeedback(GLenum mode) {
+    glBeginTransformFeedback(mode);
+    if (glTrace.recording())
+        glTrace.record(GlOp::BeginTransformFeedback, mode);
+}
+
+inline void traceEndTransformFeedback() {
+    glEndTransformFeedback();
+    if (glTrace.recording())
+        glTrace.record(GlOp::EndTransformFeedback);
+}
+
+inline void traceDispatchCompute(GLuint x, GLuint y, GLuint z) {
+    glDispatchCompute(x, y, z);
+    if (glTrace.recording())
+        glTrace.record(GlOp::DispatchCompute, x, y, z);
+}
+
+inline void traceMemoryBarrier(GLbitfield barriers) {
+    glMemoryBarrier(barriers);
+    if (glTrace.recording())
+        glTrace.record(GlOp::MemoryBarrier, barriers);
+}
+
+// Redirección: con GLEW los nombres gl* suelen ser macros sobre punteros a función, así que
+// primero se anulan. Los envoltorios de arriba ya quedaron compilados con la función real.
+#ifndef GL_TRACE_DISABLE
+#undef glClear
+#define glClear traceClear
+#undef glClearColor
+#define glClearColor traceClearColor
+#undef glEnable
+#define glEnable traceEnable
+#undef glDisable
+#define glDisable traceDisable
+#undef glViewport
+#define glViewport traceViewport
+#undef glViewportIndexedf
+#define glViewportIndexedf traceViewportIndexedf
+#undef glPixelStorei
+#define glPixelStorei tracePixelStorei
+#undef glGetIntegerv
+#define glGetIntegerv traceGetIntegerv
+#undef glGenBuffers
+#define glGenBuffers traceGenBuffers
+#undef glDeleteBuffers
+#define glDeleteBuffers traceDeleteBuffers
+#undef glBindBuffer
+#define glBindBuffer traceBindBuffer
+#undef glBufferData
+#define glBufferData traceBufferData
+#undef glMapBufferRange
+#define glMapBufferRange traceMapBufferRange
+#undef glUnmapBuffer
+#define glUnmapBuffer traceUnmapBuffer
+#undef glGenVertexArrays
+#define glGenVertexArrays traceGenVertexArrays
+#undef glDeleteVertexArrays
+#define glDeleteVertexArrays traceDeleteVertexArrays
+#undef glBindVertexArray
+#define glBindVertexArray traceBindVertexArray
+#undef glVertexAttribPointer
+#define glVertexAttribPointer traceVertexAttribPointer
+#undef glEnableVertexAttribArray
+#define glEnableVertexAttribArray traceEnableVertexAttribArray
+#undef glCreateShader
+#define glCreateShader traceCreateShader
+#undef glShaderSource
+#define glShaderSource traceShaderSource
+#undef glCompileShader
+#define glCompileShader traceCompileShader
+#undef glGetShaderiv
+#define glGetShaderiv traceGetShaderiv
+#undef glGetShaderInfoLog
+#define glGetShaderInfoLog traceGetShaderInfoLog
+#undef glDeleteShader
+#define glDeleteShader traceDeleteShader
+#undef glCreateProgram
+#define glCreateProgram traceCreateProgram
+#undef glAttachShader
+#define glAttachShader traceAttachShader
+#undef glLinkProgram
+#define glLinkProgram traceLinkProgram
+#undef glGetProgramiv
+#define glGetProgramiv traceGetProgramiv
+#undef glGetProgramInfoLog
+#define glGetProgramInfoLog traceGetProgramInfoLog
+#undef glDeleteProgram
+#define glDeleteProgram traceDeleteProgram
+#undef glUseProgram
+#define glUseProgram traceUseProgram
+#undef glGetUniformLocation
+#define glGetUniformLocation traceGetUniformLocation
+#undef glUniform1i
+#define glUniform1i traceUniform1i
+#undef glUniform1f
+#define glUniform1f traceUniform1f
+#undef glUniform3fv
+#define glUniform3fv traceUniform3fv
+#undef glUniformMatrix4fv
+#define glUniformMatrix4fv traceUniformMatrix4fv
+#undef glGenTextures
+#define glGenTextures traceGenTextures
+#undef glDeleteTextures
+#define glDeleteTextures traceDeleteTextures
+#undef glActiveTexture
+#define glActiveTexture traceActiveTexture
+#undef glBindTexture
+#define glBindTexture traceBindTexture
+#undef glTexParameteri
+#define glTexParameteri traceTexParameteri
+#undef glTexImage2D
+#define glTexImage2D traceTexImage2D
+#undef glTexSubImage2D
+#define glTexSubImage2D traceTexSubImage2D
+#undef glTexImage3D
+#define glTexImage3D traceTexImage3D
+#undef glGenRenderbuffers
+#define glGenRenderbuffers traceGenRenderbuffers
+#undef glDeleteRenderbuffers
+#define glDeleteRenderbuffers traceDeleteRenderbuffers
+#undef glBindRenderbuffer
+#define glBindRenderbuffer traceBindRenderbuffer
+#undef glRenderbufferStorage
+#define glRenderbufferStorage traceRenderbufferStorage
+#undef glRenderbufferStorageMultisample
+#define glRenderbufferStorageMultisample traceRenderbufferStorageMultisample
+#undef glGenFramebuffers
+#define glGenFramebuffers traceGenFramebuffers
+#undef glDeleteFramebuffers
+#define glDeleteFramebuffers traceDeleteFramebuffers
+#undef glBindFramebuffer
+#define glBindFramebuffer traceBindFramebuffer
+#undef glFramebufferRenderbuffer
+#define glFramebufferRenderbuffer traceFramebufferRenderbuffer
+#undef glFramebufferTexture
+#define glFramebufferTexture traceFramebufferTexture
+#undef glFramebufferTextureLayer
+#define glFramebufferTextureLayer traceFramebufferTextureLayer
+#undef glCheckFramebufferStatus
+#define glCheckFramebufferStatus traceCheckFramebufferStatus
+#undef glBlitFramebuffer
+#define glBlitFramebuffer traceBlitFramebuffer
+#undef glReadPixels
+#define glReadPixels traceReadPixels
+#undef glFenceSync
+#define glFenceSync traceFenceSync
+#undef glClientWaitSync
+#define glClientWaitSync traceClientWaitSync
+#undef glDeleteSync
+#define glDeleteSync traceDeleteSync
+#undef glGenQueries
+#define glGenQueries traceGenQueries
+#undef glDeleteQueries
+#define glDeleteQueries traceDeleteQueries
+#undef glBeginQuery
+#define glBeginQuery traceBeginQuery
+#undef glEndQuery
+#define glEndQuery traceEndQuery
+#undef glGetQueryObjectui64v
+#define glGetQueryObjectui64v traceGetQueryObjectui64v
+#undef glDrawArrays
+#define glDrawArrays traceDrawArrays
+#undef glBindBufferRange
+#define glBindBufferRange traceBindBufferRange
+#undef glBufferSubData
+#define glBufferSubData traceBufferSubData
+#undef glGetUniformBlockIndex
+#define glGetUniformBlockIndex traceGetUniformBlockIndex
+#undef glUniformBlockBinding
+#define glUniformBlockBinding traceUniformBlockBinding
+#undef glColorMask
+#define glColorMask traceColorMask
+#undef glDepthMask
+#define glDepthMask traceDepthMask
+#undef glDepthFunc
+#define glDepthFunc traceDepthFunc
+#undef glStencilFunc
+#define glStencilFunc traceStencilFunc
+#undef glStencilOp
+#define glStencilOp traceStencilOp
+#undef glBindBufferBase
+#define glBindBufferBase traceBindBufferBase
+#undef glVertexAttribDivisor
+#define glVertexAttribDivisor traceVertexAttribDivisor
+#undef glDrawArraysInstanced
+#define glDrawArraysInstanced traceDrawArraysInstanced
+#undef glTransformFeedbackVaryings
+#define glTransformFeedbackVaryings traceTransformFeedbackVaryings
+#undef glBeginTransformFeedback
+#define glBeginTransformFeedback traceBeginTransformFeedback
+#undef glEndTransformFeedback
+#define glEndTransformFeedback traceEndTransformFeedback
+#undef glDispatchCompute
+#define glDispatchCompute traceDispatchCompute
+#undef glMemoryBarrier
+#define glMemoryBarrier traceMemoryBarrier
+#endif
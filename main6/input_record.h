@@ -0,0 +1,219 @@
+#pragma once
+// Grabación y reproducción determinista de la entrada (teclas y cursor).
+// Los eventos se aplican siempre al inicio de un paso fijo de simulación y se guardan con el
+// número de ese paso ("tick"), así la reproducción vuelve a aplicar exactamente los mismos
+// eventos en los mismos pasos y la cámara queda idéntica bit a bit entre ejecuciones.
+//
+// Formato binario (little endian):
+//   "IREC" | versión (u8) | duración del paso en microsegundos (u32)
+//   eventos: delta de tick (varint) | tipo (u8) | datos
+//     KeyDown/KeyUp: código de tecla GLFW (varint)
+//     CursorMove:    dx, dy en 1/64 de píxel respecto al evento anterior (varint zigzag)
+//     End:           marca el último tick grabado
+
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <vector>
+
+enum class InputEventType : uint8_t { KeyDown = 0, KeyUp = 1, CursorMove = 2, End = 0xFF };
+
+struct InputEvent {
+    uint32_t tick;
+    InputEventType type;
+    int key;         // Para KeyDown/KeyUp
+    double x, y;     // Para CursorMove, ya cuantizados
+};
+
+// Precisión con la que se guardan las posiciones del cursor.
+const double kCursorQuantum = 64.0;
+
+inline double quantizeCursor(double value) {
+    return std::llround(value * kCursorQuantum) / kCursorQuantum;
+}
+
+namespace inputlog {
+
+inline void writeVarint(std::vector<uint8_t>& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+inline void writeSigned(std::vector<uint8_t>& out, int64_t value) {
+    writeVarint(out, (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63));
+}
+
+inline bool readVarint(const std::vector<uint8_t>& in, size_t& pos, uint64_t& value) {
+    value = 0;
+    for (int shift = 0; pos < in.size() && shift < 64; shift += 7) {
+        uint8_t byte = in[pos++];
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80))
+            return true;
+    }
+    return false;
+}
+
+inline bool readSigned(const std::vector<uint8_t>& in, size_t& pos, int64_t& value) {
+    uint64_t raw;
+    if (!readVarint(in, pos, raw))
+        return false;
+    value = static_cast<int64_t>(raw >> 1) ^ -static_cast<int64_t>(raw & 1);
+    return true;
+}
+
+} // namespace inputlog
+
+// Acumula los eventos que llegan por los callbacks de GLFW y los entrega, ya cuantizados,
+// al inicio del siguiente paso de simulación. Al terminar escribe el registro completo.
+class InputRecorder {
+public:
+    explicit InputRecorder(uint32_t stepMicros) : stepMicros(stepMicros) {}
+
+    void keyEvent(int key, bool down) {
+        pending.push_back({ 0, down ? InputEventType::KeyDown : InputEventType::KeyUp, key, 0.0, 0.0 });
+    }
+
+    void cursorEvent(double x, double y) {
+        pending.push_back({ 0, InputEventType::CursorMove, 0, quantizeCursor(x), quantizeCursor(y) });
+    }
+
+    // Sella los eventos pendientes con el tick actual, los guarda y los devuelve para aplicarlos.
+    const std::vector<InputEvent>& beginTick(uint32_t tick) {
+        current.swap(pending);
+        pending.clear();
+        for (InputEvent& event : current) {
+            event.tick = tick;
+            encode(event);
+        }
+        lastTick = tick;
+        return current;
+    }
+
+    bool save(const char* filepath) {
+        InputEvent end = { lastTick, InputEventType::End, 0, 0.0, 0.0 };
+        encode(end);
+
+        std::ofstream file(filepath, std::ios::binary);
+        if (!file) {
+            std::cerr << "No se pudo escribir el registro de entrada: " << filepath << std::endl;
+            return false;
+        }
+        uint8_t header[9] = { 'I', 'R', 'E', 'C', 1,
+                              static_cast<uint8_t>(stepMicros), static_cast<uint8_t>(stepMicros >> 8),
+                              static_cast<uint8_t>(stepMicros >> 16), static_cast<uint8_t>(stepMicros >> 24) };
+        file.write(reinterpret_cast<const char*>(header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(data.data()), data.size());
+        std::cout << "Registro de entrada: " << eventCount << " eventos en " << lastTick + 1 << " pasos, "
+                  << sizeof(header) + data.size() << " bytes -> " << filepath << std::endl;
+        return true;
+    }
+
+private:
+    void encode(const InputEvent& event) {
+        inputlog::writeVarint(data, event.tick - encodedTick);
+        encodedTick = event.tick;
+        data.push_back(static_cast<uint8_t>(event.type));
+        if (event.type == InputEventType::KeyDown || event.type == InputEventType::KeyUp) {
+            inputlog::writeVarint(data, static_cast<uint64_t>(event.key));
+        } else if (event.type == InputEventType::CursorMove) {
+            int64_t qx = std::llround(event.x * kCursorQuantum);
+            int64_t qy = std::llround(event.y * kCursorQuantum);
+            inputlog::writeSigned(data, qx - lastQx);
+            inputlog::writeSigned(data, qy - lastQy);
+            lastQx = qx;
+            lastQy = qy;
+        }
+        if (event.type != InputEventType::End)
+            ++eventCount;
+    }
+
+    uint32_t stepMicros;
+    std::vector<InputEvent> pending, current;
+    std::vector<uint8_t> data;
+    uint32_t lastTick = 0, encodedTick = 0;
+    int64_t lastQx = 0, lastQy = 0;
+    size_t eventCount = 0;
+};
+
+// Lee un registro y entrega, tick por tick, los eventos a reaplicar.
+class InputReplay {
+public:
+    bool load(const char* filepath) {
+        std::ifstream file(filepath, std::ios::binary);
+        if (!file) {
+            std::cerr << "No se pudo abrir el registro de entrada: " << filepath << std::endl;
+            return false;
+        }
+        std::vector<uint8_t> in((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        if (in.size() < 9 || in[0] != 'I' || in[1] != 'R' || in[2] != 'E' || in[3] != 'C' || in[4] != 1) {
+            std::cerr << "Registro de entrada inválido: " << filepath << std::endl;
+            return false;
+        }
+        stepMicros = in[5] | (in[6] << 8) | (in[7] << 16) | (static_cast<uint32_t>(in[8]) << 24);
+
+        size_t pos = 9;
+        uint32_t tick = 0;
+        int64_t qx = 0, qy = 0;
+        while (pos < in.size()) {
+            uint64_t delta, key;
+            if (!inputlog::readVarint(in, pos, delta) || pos >= in.size())
+                return corrupt(filepath);
+            tick += static_cast<uint32_t>(delta);
+            InputEvent event = { tick, static_cast<InputEventType>(in[pos++]), 0, 0.0, 0.0 };
+            switch (event.type) {
+            case InputEventType::KeyDown:
+            case InputEventType::KeyUp:
+                if (!inputlog::readVarint(in, pos, key))
+                    return corrupt(filepath);
+                event.key = static_cast<int>(key);
+                break;
+            case InputEventType::CursorMove: {
+                int64_t dx, dy;
+                if (!inputlog::readSigned(in, pos, dx) || !inputlog::readSigned(in, pos, dy))
+                    return corrupt(filepath);
+                qx += dx;
+                qy += dy;
+                event.x = qx / kCursorQuantum;
+                event.y = qy / kCursorQuantum;
+                break;
+            }
+            case InputEventType::End:
+                lastTick = tick;
+                return true;
+            default:
+                return corrupt(filepath);
+            }
+            events.push_back(event);
+        }
+        return corrupt(filepath); // Falta la marca de fin
+    }
+
+    // Devuelve los eventos del tick indicado (los ticks deben pedirse en orden creciente).
+    std::vector<InputEvent> eventsForTick(uint32_t tick) {
+        std::vector<InputEvent> result;
+        while (next < events.size() && events[next].tick <= tick)
+            result.push_back(events[next++]);
+        return result;
+    }
+
+    bool finished(uint32_t tick) const { return tick > lastTick; }
+    uint32_t totalTicks() const { return lastTick + 1; }
+    float stepSeconds() const { return stepMicros / 1e6f; }
+
+private:
+    bool corrupt(const char* filepath) {
+        std::cerr << "Registro de entrada corrupto: " << filepath << std::endl;
+        return false;
+    }
+
+    std::vector<InputEvent> events;
+    size_t next = 0;
+    uint32_t stepMicros = 16667;
+    uint32_t lastTick = 0;
+};
@@ -0,0 +1,413 @@
+#pragma once
+// Horneado de iluminación difusa para la geometría estática.
+//  - Genera coordenadas de lightmap: cada grupo de triángulos coplanares de una malla forma una
+//    carta que se proyecta sobre su plano y se empaqueta por estantes en un atlas.
+//  - Calcula en la CPU, con varios hilos, la luz ambiental, la directa de las dos luces (con
+//    sombras) y un rebote indirecto por trazado de caminos sobre el BVH de la escena.
+//  - Guarda y carga el atlas junto con las coordenadas de cada vértice.
+
+#include "bvh.h"
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Malla estática a hornear: 9 floats por vértice (posición, normal y color) y su matriz de mundo.
+struct BakeMesh {
+    const float* vertices;
+    int vertexCount;
+    glm::mat4 model;
+};
+
+// Las mismas luces y factores que usa phong_fragment_shader.glsl.
+struct BakeLights {
+    glm::vec3 pointPos;
+    glm::vec3 direction;  // Dirección de la luz direccional (hacia donde ilumina)
+    glm::vec3 color;
+    float ambientStrength;
+    float diffuseStrength;  // Solo afecta a la luz puntual, igual que en el shader
+};
+
+struct BakeSettings {
+    float texelsPerUnit = 32.0f;
+    int maxChartSize = 512;  // Lado máximo de una carta en texels (el plano base lo alcanza)
+    int samples = 64;        // Rayos del hemisferio por texel para el rebote indirecto
+    unsigned threads = 0;    // 0 = todos los núcleos
+};
+
+struct LightmapAtlas {
+    int width = 0, height = 0;
+    std::vector<glm::vec3> texels;             // Irradiancia difusa RGB por texel
+    std::vector<std::vector<glm::vec2>> uvs;   // Coordenadas por malla y vértice
+
+    bool save(const char* filepath) const {
+        std::ofstream file(filepath, std::ios::binary);
+        if (!file) {
+            std::cerr << "No se pudo crear el lightmap " << filepath << std::endl;
+            return false;
+        }
+        const char magic[4] = { 'L', 'M', 'A', 'P' };
+        uint32_t header[4] = { 1, static_cast<uint32_t>(width), static_cast<uint32_t>(height), static_cast<uint32_t>(uvs.size()) };
+        file.write(magic, 4);
+        file.write(reinterpret_cast<const char*>(header), sizeof(header));
+        for (const auto& mesh : uvs) {
+            uint32_t count = static_cast<uint32_t>(mesh.size());
+            file.write(reinterpret_cast<const char*>(&count), sizeof(count));
+            file.write(reinterpret_cast<const char*>(mesh.data()), count * sizeof(glm::vec2));
+        }
+        file.write(reinterpret_cast<const char*>(texels.data()), texels.size() * sizeof(glm::vec3));
+        return static_cast<bool>(file);
+    }
+
+    bool load(const char* filepath) {
+        std::ifstream file(filepath, std::ios::binary);
+        char magic[4] = {};
+        uint32_t header[4] = {};
+        file.read(magic, 4);
+        file.read(reinterpret_cast<char*>(header), sizeof(header));
+        if (!file || std::string(magic, 4) != "LMAP" || header[0] != 1) {
+            std::cerr << "No se pudo leer el lightmap " << filepath << std::endl;
+            return false;
+        }
+        width = static_cast<int>(header[1]);
+        height = static_cast<int>(header[2]);
+        uvs.assign(header[3], {});
+        for (auto& mesh : uvs) {
+            uint32_t count = 0;
+            file.read(reinterpret_cast<char*>(&count), sizeof(count));
+            mesh.resize(count);
+            file.read(reinterpret_cast<char*>(mesh.data()), count * sizeof(glm::vec2));
+        }
+        texels.resize(static_cast<size_t>(width) * height);
+        file.read(reinterpret_cast<char*>(texels.data()), texels.size() * sizeof(glm::vec3));
+        if (!file) {
+            std::cerr << "Lightmap truncado: " << filepath << std::endl;
+            return false;
+        }
+        return true;
+    }
+};
+
+class LightmapBaker {
+public:
+    // Devuelve el tiempo de trazado en segundos (sin contar la generación de cartas ni el BVH).
+    double bake(const std::vector<BakeMesh>& meshes, const BakeLights& bakeLights, const BakeSettings& settings,
+                LightmapAtlas& atlas) {
+        lights = bakeLights;
+        lights.direction = glm::normalize(lights.direction);
+        samples = std::max(1, settings.samples);
+        gatherTriangles(meshes);
+        buildCharts(meshes, settings);
+        packCharts(atlas);
+        assignUvs(meshes, atlas);
+        rasterizeCharts(atlas);
+        bvh.build(positions);
+
+        atlas.texels.assign(static_cast<size_t>(atlas.width) * atlas.height, glm::vec3(0.0f));
+        unsigned threads = settings.threads ? settings.threads : std::max(1u, std::thread::hardware_concurrency());
+        std::atomic<size_t> nextBlock{ 0 };
+        const size_t blockSize = 256;
+        auto start = std::chrono::steady_clock::now();
+        auto worker = [&]() {
+            Scratch scratch;
+            for (;;) {
+                size_t begin = nextBlock.fetch_add(blockSize);
+                if (begin >= surfaceTexels.size())
+                    break;
+                size_t end = std::min(begin + blockSize, surfaceTexels.size());
+                for (size_t i = begin; i < end; ++i) {
+                    const SurfaceTexel& texel = surfaceTexels[i];
+                    atlas.texels[texel.atlasIndex] = shadeTexel(texel, scratch);
+                }
+            }
+        };
+        std::vector<std::thread> pool;
+        for (unsigned t = 1; t < threads; ++t)
+            pool.emplace_back(worker);
+        worker();
+        for (std::thread& thread : pool)
+            thread.join();
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    size_t texelCount() const { return surfaceTexels.size(); }
+
+private:
+    struct Chart {
+        int mesh;
+        std::vector<int> triangles;  // Índice del primer vértice de cada triángulo en la malla
+        glm::vec3 origin, axisU, axisV, normal;
+        glm::vec2 min2d, max2d;
+        float scale;                 // Texels por unidad de mundo
+        int x, y, w, h;              // Rectángulo en el atlas, con el margen incluido
+    };
+
+    // Punto de la superficie que corresponde al centro de un texel
+    struct SurfaceTexel {
+        glm::vec3 position, normal;
+        uint32_t atlasIndex;
+    };
+
+    // Arreglos temporales de un hilo, reutilizados entre texels
+    struct Scratch {
+        std::vector<glm::vec3> origins, directions;
+        std::vector<RayHit> hits;
+        std::vector<glm::vec3> hitPositions, hitNormals, hitAlbedo, shadowFrom, shadowTo;
+        std::vector<uint8_t> hitBlocked;
+    };
+
+    static const int kPadding = 2;  // Texels de margen alrededor de cada carta (filtrado bilineal)
+
+    void gatherTriangles(const std::vector<BakeMesh>& meshes) {
+        positions.clear();
+        normals.clear();
+        colors.clear();
+        for (const BakeMesh& mesh : meshes) {
+            glm::mat3 normalMatrix(mesh.model); // Las mallas estáticas solo tienen rotación y escala uniforme
+            for (int v = 0; v < mesh.vertexCount - mesh.vertexCount % 3; ++v) {
+                const float* vertex = mesh.vertices + v * 9;
+                positions.push_back(glm::vec3(mesh.model * glm::vec4(vertex[0], vertex[1], vertex[2], 1.0f)));
+                normals.push_back(glm::normalize(normalMatrix * glm::vec3(vertex[3], vertex[4], vertex[5])));
+                colors.push_back(glm::vec3(vertex[6], vertex[7], vertex[8]));
+            }
+        }
+    }
+
+    void buildCharts(const std::vector<BakeMesh>& meshes, const BakeSettings& settings) {
+        charts.clear();
+        meshBase.clear();
+        size_t base = 0;
+        for (size_t m = 0; m < meshes.size(); ++m) {
+            meshBase.push_back(base);
+            int triangleVertices = meshes[m].vertexCount - meshes[m].vertexCount % 3;
+            for (int first = 0; first < triangleVertices; first += 3) {
+                const glm::vec3* p = &positions[base + first];
+                glm::vec3 n = glm::cross(p[1] - p[0], p[2] - p[0]);
+                if (glm::length(n) < 1e-12f)
+                    continue; // Triángulo degenerado: no ocupa texels
+                n = glm::normalize(n);
+                // Los triángulos consecutivos sobre el mismo plano comparten carta
+                bool coplanar = !charts.empty() && charts.back().mesh == static_cast<int>(m) &&
+                                std::fabs(glm::dot(n, charts.back().normal)) > 0.999f &&
+                                std::fabs(glm::dot(p[0] - charts.back().origin, charts.back().normal)) < 1e-4f;
+                if (!coplanar) {
+                    Chart chart;
+                    chart.mesh = static_cast<int>(m);
+                    chart.origin = p[0];
+                    chart.normal = n;
+                    chart.axisU = glm::normalize(p[1] - p[0]);
+                    chart.axisV = glm::cross(n, chart.axisU);
+                    chart.min2d = glm::vec2(1e30f);
+                    chart.max2d = glm::vec2(-1e30f);
+                    charts.push_back(chart);
+                }
+                Chart& chart = charts.back();
+                chart.triangles.push_back(first);
+                for (int k = 0; k < 3; ++k) {
+                    glm::vec2 q = project(chart, p[k]);
+                    chart.min2d = glm::vec2(std::min(chart.min2d.x, q.x), std::min(chart.min2d.y, q.y));
+                    chart.max2d = glm::vec2(std::max(chart.max2d.x, q.x), std::max(chart.max2d.y, q.y));
+                }
+            }
+            base += triangleVertices;
+        }
+        for (Chart& chart : charts) {
+            glm::vec2 extent = chart.max2d - chart.min2d;
+            float longest = std::max(extent.x, extent.y);
+            chart.scale = settings.texelsPerUnit;
+            if (longest * chart.scale > settings.maxChartSize)
+                chart.scale = settings.maxChartSize / longest;
+            chart.w = std::max(1, static_cast<int>(std::ceil(extent.x * chart.scale))) + 2 * kPadding;
+            chart.h = std::max(1, static_cast<int>(std::ceil(extent.y * chart.scale))) + 2 * kPadding;
+        }
+    }
+
+    static glm::vec2 project(const Chart& chart, const glm::vec3& p) {
+        glm::vec3 d = p - chart.origin;
+        return glm::vec2(glm::dot(d, chart.axisU), glm::dot(d, chart.axisV));
+    }
+
+    // Empaquetado por estantes: cartas ordenadas por altura, filas de izquierda a derecha.
+    void packCharts(LightmapAtlas& atlas) {
+        std::vector<Chart*> sorted;
+        size_t area = 0;
+        int widest = 1;
+        for (Chart& chart : charts) {
+            sorted.push_back(&chart);
+            area += static_cast<size_t>(chart.w) * chart.h;
+            widest = std::max(widest, chart.w);
+        }
+        std::sort(sorted.begin(), sorted.end(), [](const Chart* a, const Chart* b) { return a->h > b->h; });
+        int width = 64;
+        while (static_cast<size_t>(width) * width < area || width < widest)
+            width *= 2;
+        int x = 0, y = 0, shelfHeight = 0;
+        for (Chart* chart : sorted) {
+            if (x + chart->w > width) {
+                x = 0;
+                y += shelfHeight;
+                shelfHeight = 0;
+            }
+            chart->x = x;
+            chart->y = y;
+            x += chart->w;
+            shelfHeight = std::max(shelfHeight, chart->h);
+        }
+        atlas.width = width;
+        atlas.height = (y + shelfHeight + 3) / 4 * 4;
+    }
+
+    void assignUvs(const std::vector<BakeMesh>& meshes, LightmapAtlas& atlas) {
+        atlas.uvs.assign(meshes.size(), {});
+        for (size_t m = 0; m < meshes.size(); ++m)
+            atlas.uvs[m].assign(meshes[m].vertexCount, glm::vec2(0.0f));
+        for (const Chart& chart : charts) {
+            for (int first : chart.triangles) {
+                for (int k = 0; k < 3; ++k) {
+                    glm::vec2 q = (project(chart, positions[meshBase[chart.mesh] + first + k]) - chart.min2d) * chart.scale;
+                    atlas.uvs[chart.mesh][first + k] = glm::vec2((chart.x + kPadding + q.x) / atlas.width,
+                                                                 (chart.y + kPadding + q.y) / atlas.height);
+                }
+            }
+        }
+    }
+
+    // Un punto de superficie por texel de cada carta. Los texels del margen usan el punto más
+    // cercano de la carta para que el filtrado no mezcle negro en los bordes.
+    void rasterizeCharts(const LightmapAtlas& atlas) {
+        surfaceTexels.clear();
+        for (const Chart& chart : charts) {
+            for (int ty = chart.y; ty < chart.y + chart.h; ++ty) {
+                for (int tx = chart.x; tx < chart.x + chart.w; ++tx) {
+                    glm::vec2 q = chart.min2d + (glm::vec2(tx - chart.x - kPadding, ty - chart.y - kPadding) + 0.5f) / chart.scale;
+                    size_t best = 0;
+                    glm::vec3 bestWeights(0.0f);
+                    float bestOutside = 1e30f;
+                    for (int first : chart.triangles) {
+                        size_t tri = meshBase[chart.mesh] + first;
+                        glm::vec3 w = barycentric(project(chart, positions[tri]), project(chart, positions[tri + 1]),
+                                                  project(chart, positions[tri + 2]), q);
+                        float outside = -std::min(0.0f, std::min(w.x, std::min(w.y, w.z)));
+                        if (outside < bestOutside) {
+                            bestOutside = outside;
+                            best = tri;
+                            bestWeights = w;
+                        }
+                    }
+                    // Fijar el punto dentro del triángulo
+                    bestWeights = glm::max(bestWeights, glm::vec3(0.0f));
+                    bestWeights /= bestWeights.x + bestWeights.y + bestWeights.z;
+                    SurfaceTexel texel;
+                    texel.position = positions[best] * bestWeights.x + positions[best + 1] * bestWeights.y +
+                                     positions[best + 2] * bestWeights.z;
+                    texel.normal = glm::normalize(normals[best] * bestWeights.x + normals[best + 1] * bestWeights.y +
+                                                  normals[best + 2] * bestWeights.z);
+                    texel.atlasIndex = static_cast<uint32_t>(ty * atlas.width + tx);
+                    surfaceTexels.push_back(texel);
+                }
+            }
+        }
+    }
+
+    static glm::vec3 barycentric(const glm::vec2& a, const glm::vec2& b, const glm::vec2& c, const glm::vec2& p) {
+        glm::vec2 v0 = b - a, v1 = c - a, v2 = p - a;
+        float det = v0.x * v1.y - v1.x * v0.y;
+        float wb = (v2.x * v1.y - v1.x * v2.y) / det;
+        float wc = (v0.x * v2.y - v2.x * v0.y) / det;
+        return glm::vec3(1.0f - wb - wc, wb, wc);
+    }
+
+    // Luz directa difusa en un punto, con las sombras ya resueltas (blocked[0] puntual, blocked[1] direccional).
+    glm::vec3 directLight(const glm::vec3& position, const glm::vec3& normal, const uint8_t* blocked) const {
+        float point = std::max(glm::dot(normal, glm::normalize(lights.pointPos - position)), 0.0f);
+        float directional = std::max(glm::dot(normal, -lights.direction), 0.0f);
+        return lights.color * (lights.diffuseStrength * point * (blocked[0] ? 0.0f : 1.0f) + directional * (blocked[1] ? 0.0f : 1.0f));
+    }
+
+    // Segmentos de sombra hacia las dos luces desde un punto ligeramente separado de la superficie
+    void shadowSegments(const glm::vec3& position, const glm::vec3& normal, glm::vec3* from, glm::vec3* to) const {
+        glm::vec3 origin = position + normal * 1e-3f;
+        from[0] = origin;
+        to[0] = lights.pointPos;
+        from[1] = origin;
+        to[1] = origin - lights.direction * 1000.0f;
+    }
+
+    glm::vec3 shadeTexel(const SurfaceTexel& texel, Scratch& scratch) const {
+        const glm::vec3& n = texel.normal;
+        glm::vec3 from[2], to[2];
+        uint8_t blocked[2];
+        shadowSegments(texel.position, n, from, to);
+        bvh.segmentsOccluded(from, to, blocked, 2);
+        glm::vec3 result = lights.ambientStrength * lights.color + directLight(texel.position, n, blocked);
+
+        // Rebote indirecto: rayos con distribución coseno sobre el hemisferio (la densidad se
+        // cancela con el término coseno, así que basta promediar la radiancia de los impactos)
+        glm::vec3 tangent = std::fabs(n.x) > 0.9f ? glm::vec3(0.0f, 1.0f, 0.0f) : glm::vec3(1.0f, 0.0f, 0.0f);
+        tangent = glm::normalize(glm::cross(tangent, n));
+        glm::vec3 bitangent = glm::cross(n, tangent);
+        uint32_t seed = texel.atlasIndex * 747796405u + 2891336453u; // Semilla fija por texel: mismo resultado con cualquier número de hilos
+        scratch.origins.assign(samples, texel.position + n * 1e-3f);
+        scratch.directions.resize(samples);
+        for (int s = 0; s < samples; ++s) {
+            float r1 = random(seed), r2 = random(seed);
+            float phi = 6.28318531f * r1, r = std::sqrt(r2);
+            scratch.directions[s] = tangent * (r * std::cos(phi)) + bitangent * (r * std::sin(phi)) + n * std::sqrt(1.0f - r2);
+        }
+        scratch.hits.resize(samples);
+        bvh.intersectRays(scratch.origins.data(), scratch.directions.data(), 1e30f, scratch.hits.data(), samples);
+
+        // Sombras de los puntos impactados, todas en un lote
+        scratch.hitPositions.clear();
+        scratch.hitNormals.clear();
+        scratch.hitAlbedo.clear();
+        scratch.shadowFrom.clear();
+        scratch.shadowTo.clear();
+        for (const RayHit& hit : scratch.hits) {
+            if (hit.triangle == kNoHit)
+                continue;
+            size_t tri = 3 * static_cast<size_t>(hit.triangle);
+            float w0 = 1.0f - hit.u - hit.v;
+            glm::vec3 p = positions[tri] * w0 + positions[tri + 1] * hit.u + positions[tri + 2] * hit.v;
+            glm::vec3 hn = glm::normalize(normals[tri] * w0 + normals[tri + 1] * hit.u + normals[tri + 2] * hit.v);
+            // Los triángulos no tienen cara trasera propia: si el rayo llega por detrás, la
+            // cara visible mira hacia el otro lado
+            if (glm::dot(hn, scratch.directions[&hit - scratch.hits.data()]) > 0.0f)
+                hn = -hn;
+            scratch.hitPositions.push_back(p);
+            scratch.hitNormals.push_back(hn);
+            scratch.hitAlbedo.push_back(colors[tri] * w0 + colors[tri + 1] * hit.u + colors[tri + 2] * hit.v);
+            scratch.shadowFrom.resize(scratch.shadowFrom.size() + 2);
+            scratch.shadowTo.resize(scratch.shadowTo.size() + 2);
+            shadowSegments(p, hn, &scratch.shadowFrom[scratch.shadowFrom.size() - 2], &scratch.shadowTo[scratch.shadowTo.size() - 2]);
+        }
+        scratch.hitBlocked.resize(scratch.shadowFrom.size());
+        bvh.segmentsOccluded(scratch.shadowFrom.data(), scratch.shadowTo.data(), scratch.hitBlocked.data(), scratch.shadowFrom.size());
+        glm::vec3 indirect(0.0f);
+        for (size_t h = 0; h < scratch.hitPositions.size(); ++h)
+            indirect += scratch.hitAlbedo[h] * directLight(scratch.hitPositions[h], scratch.hitNormals[h], &scratch.hitBlocked[2 * h]);
+        return result + indirect / static_cast<float>(samples);
+    }
+
+    // Generador PCG: número uniforme en [0, 1)
+    static float random(uint32_t& state) {
+        state = state * 747796405u + 2891336453u;
+        uint32_t word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+        return ((word >> 22u) ^ word) * (1.0f / 4294967296.0f);
+    }
+
+    BakeLights lights;
+    int samples = 64;
+    std::vector<glm::vec3> positions, normals, colors;  // 3 por triángulo, en coordenadas de mundo
+    std::vector<size_t> meshBase;                       // Primer vértice de cada malla en positions
+    std::vector<Chart> charts;
+    std::vector<SurfaceTexel> surfaceTexels;
+    TriangleBvh bvh;
+};
@@ -0,0 +1,34 @@
+#version 330 core
+
+in vec3 FragPos;     // Posición del fragmento en el espacio del mundo.
+in vec3 Normal;      // Normal del fragmento en el espacio del mundo.
+in vec3 vertexColor; // Color del vértice pasado desde el vertex shader.
+in vec2 LightmapUV;  // Coordenada del lightmap
+
+out vec4 FragColor;
+
+// Iluminación difusa horneada: ambiental + directa con sombras + un rebote indirecto
+uniform sampler2D lightmap;
+
+// Variables uniformes de luz y cámara (solo para la componente especular)
+uniform vec3 lightPos;     // Posición de la luz puntual.
+uniform vec3 viewPos;      // Posición de la cámara.
+uniform vec3 lightColor;   // Color de la luz.
+uniform float specularStrength;
+uniform vec3 lightDir;     // Dirección de la luz direccional
+
+void main() {
+    // La parte difusa ya está en el atlas: una lectura en vez de las dos luces por fragmento
+    vec3 diffuse = texture(lightmap, LightmapUV).rgb;
+
+    // Componente especular: depende de la cámara, así que se sigue calculando por fragmento
+    vec3 norm = normalize(Normal);
+    vec3 viewDir = normalize(viewPos - FragPos);
+    vec3 reflectDirPoint = reflect(-normalize(lightPos - FragPos), norm);
+    float specPoint = pow(max(dot(viewDir, reflectDirPoint), 0.0), 64.0);
+    vec3 reflectDirDir = reflect(normalize(lightDir), norm);
+    float specDir = pow(max(dot(viewDir, reflectDirDir), 0.0), 32.0);
+    vec3 specular = specularStrength * (specPoint + specDir) * lightColor;
+
+    FragColor = vec4((diffuse + specular) * vertexColor, 1.0);
+}
@@ -0,0 +1,39 @@
+#version 330 core
+
+layout(location = 0) in vec3 aPos;         // Posición del vértice
+layout(location = 1) in vec3 aNormal;      // Normal del vértice
+layout(location = 2) in vec3 aColor;       // Color del vértice
+layout(location = 3) in vec2 aLightmapUV;  // Coordenada en el atlas de iluminación horneada
+
+out vec3 FragPos;     // Posición del fragmento en el espacio del mundo.
+out vec3 Normal;      // Normal del vértice en el espacio del mundo.
+out vec3 vertexColor; // Color del vértice
+out vec2 LightmapUV;  // Coordenada del lightmap
+
+// Datos por objeto: un rango del buffer de uniforms que se enlaza antes de cada dibujo
+layout(std140) uniform ObjectBlock {
+    mat4 model;
+    mat4 normalMatrix; // transpose(inverse(model)), calculada en la CPU al grabar
+};
+
+// Matrices uniformes para transformar los vértices
+uniform mat4 view;
+uniform mat4 projection;
+
+// Necesario para el pre-pase de profundidad: la profundidad debe coincidir con la de
+// depth_vertex_shader.glsl para que GL_EQUAL acepte los fragmentos
+invariant gl_Position;
+
+void main() {
+    // Calcular la posición del fragmento en el espacio del mundo
+    FragPos = vec3(model * vec4(aPos, 1.0));
+
+    // La geometría horneada es estática y sin escala no uniforme: basta la parte 3x3 del modelo
+    Normal = mat3(model) * aNormal;
+
+    vertexColor = aColor;
+    LightmapUV = aLightmapUV;
+
+    // Transformar el vértice al espacio de pantalla
+    gl_Position = projection * view * model * vec4(aPos, 1.0);
+}
@@ -0,0 +1,217 @@
+#pragma once
+// Bucle de baja latencia.
+//  - SimulationClock: tiempo en doble precisión desde el arranque (un float de glfwGetTime
+//    pierde resolución tras unas horas) y pasos fijos de simulación que se consumen a medida
+//    que avanza el tiempo real.
+//  - InputSampler: la entrada más reciente (teclas de movimiento y cursor). La publica el hilo
+//    de entrada muchas veces por fotograma y el hilo de render la toma sin esperar.
+//  - FrameLimiter: ritmo de fotogramas opcional. Duerme antes de leer la entrada, así la espera
+//    no envejece lo que se dibuja.
+//  - LatencyLog: latencia medida entre la entrada y el envío de los dibujos, por fotograma en un
+//    CSV y resumida al salir.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+const int kSimulationHz = 120;   // Pasos fijos de la simulación de la cámara por segundo
+const int kInputSampleHz = 1000; // Muestreos de la entrada por segundo en el hilo de entrada
+const int kMaxCatchUpSteps = 8;  // Tras una pausa larga no se simula todo el tiempo perdido
+
+// Teclas de movimiento como bits de InputSample::keys
+const uint32_t kInputForward = 1, kInputBackward = 2, kInputLeft = 4, kInputRight = 8;
+
+using LatencyClock = std::chrono::steady_clock;
+
+class SimulationClock {
+public:
+    explicit SimulationClock(double stepSeconds) : stepSeconds(stepSeconds), origin(LatencyClock::now()) {}
+
+    // Segundos desde que se creó el reloj. Se puede llamar desde cualquier hilo.
+    double now() const { return std::chrono::duration<double>(LatencyClock::now() - origin).count(); }
+
+    // Acumula el tiempo real desde la llamada anterior y devuelve cuántos pasos fijos toca
+    // simular. Lo que sobra queda para la próxima llamada.
+    int advance() {
+        double current = now();
+        accumulator += current - lastAdvance;
+        lastAdvance = current;
+        int count = static_cast<int>(accumulator / stepSeconds);
+        if (count > kMaxCatchUpSteps) {
+            droppedSteps += count - kMaxCatchUpSteps;
+            count = kMaxCatchUpSteps;
+            accumulator = 0.0;
+        } else {
+            accumulator -= count * stepSeconds;
+        }
+        totalSteps += count;
+        return count;
+    }
+
+    double step() const { return stepSeconds; }
+    double simulatedSeconds() const { return totalSteps * stepSeconds; }
+    uint64_t steps() const { return totalSteps; }
+    uint64_t dropped() const { return droppedSteps; }
+
+private:
+    double stepSeconds;
+    LatencyClock::time_point origin;
+    double lastAdvance = 0.0, accumulator = 0.0;
+    uint64_t totalSteps = 0, droppedSteps = 0;
+};
+
+// Estado de la entrada en un instante. Los tiempos son segundos de SimulationClock.
+struct InputSample {
+    uint32_t keys = 0;           // Bits kInputForward, kInputBackward...
+    double cursorX = 0.0, cursorY = 0.0;
+    bool hasCursor = false;
+    uint64_t sequence = 0;       // Cambios publicados hasta ahora
+    double sampledAt = -1.0;     // Último muestreo, haya cambiado o no
+    double pendingSince = -1.0;  // Primer cambio que el render todavía no tomó (-1 = ninguno)
+};
+
+class InputSampler {
+public:
+    // Hilo de entrada: publica el estado leído en este muestreo.
+    void publish(uint32_t keys, double cursorX, double cursorY, double now) {
+        std::lock_guard<std::mutex> lock(mutex);
+        ++samples;
+        latest.sampledAt = now;
+        if (latest.hasCursor && keys == latest.keys && cursorX == latest.cursorX && cursorY == latest.cursorY)
+            return;
+        latest.keys = keys;
+        latest.cursorX = cursorX;
+        latest.cursorY = cursorY;
+        latest.hasCursor = true;
+        ++latest.sequence;
+        if (latest.pendingSince < 0.0)
+            latest.pendingSince = now;
+    }
+
+    // Hilo de render: el estado más reciente. Los cambios pendientes quedan marcados como tomados.
+    InputSample take() {
+        std::lock_guard<std::mutex> lock(mutex);
+        InputSample sample = latest;
+        latest.pendingSince = -1.0;
+        return sample;
+    }
+
+    uint64_t sampleCount() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return samples;
+    }
+
+private:
+    mutable std::mutex mutex;
+    InputSample latest;
+    uint64_t samples = 0;
+};
+
+class FrameLimiter {
+public:
+    explicit FrameLimiter(double framesPerSecond) : period(framesPerSecond > 0.0 ? 1.0 / framesPerSecond : 0.0) {}
+
+    bool active() const { return period > 0.0; }
+
+    // Espera hasta el comienzo del fotograma siguiente. Duerme hasta poco antes y termina
+    // cediendo el procesador: sleep_for suele despertar tarde por la granularidad del planificador.
+    void wait(const SimulationClock& clock) {
+        if (!active())
+            return;
+        double now = clock.now();
+        if (deadline == 0.0 || now > deadline + period) {
+            deadline = now + period; // Primer fotograma o muy atrasado: no acumular deuda
+            return;
+        }
+        double sleepSeconds = deadline - now - kSpinSeconds;
+        if (sleepSeconds > 0.0)
+            std::this_thread::sleep_for(std::chrono::duration<double>(sleepSeconds));
+        while (clock.now() < deadline)
+            std::this_thread::yield();
+        deadline += period;
+    }
+
+private:
+    static constexpr double kSpinSeconds = 0.002;
+    double period;
+    double deadline = 0.0;
+};
+
+class LatencyLog {
+public:
+    // Sin archivo solo se acumula el resumen.
+    bool open(const std::string& path) {
+        file.open(path);
+        if (!file) {
+            std::cerr << "No se pudo escribir el registro de latencia: " << path << std::endl;
+            return false;
+        }
+        file << "fotograma,tiempo_s,pasos,fotograma_ms,antiguedad_ms,latencia_ms\n";
+        return true;
+    }
+
+    // Entrada tomada durante el fotograma (al comienzo y en el latch tardío). Se conserva el
+    // cambio más antiguo: es el que más esperó hasta llegar a la GPU.
+    void consume(const InputSample& sample, int steps) {
+        frameSteps += steps;
+        if (sample.pendingSince >= 0.0 && (pendingSince < 0.0 || sample.pendingSince < pendingSince))
+            pendingSince = sample.pendingSince;
+        sampledAt = sample.sampledAt;
+    }
+
+    // Instante del envío de los dibujos, con la cámara ya fijada.
+    void markSubmit(double now) { submitAt = now; }
+
+    void endFrame(double frameStart, double frameSeconds) {
+        double age = submitAt >= 0.0 && sampledAt >= 0.0 ? submitAt - sampledAt : 0.0;
+        double latency = submitAt >= 0.0 && pendingSince >= 0.0 ? submitAt - pendingSince : -1.0;
+        if (file.is_open()) {
+            file << frames << ',' << frameStart << ',' << frameSteps << ',' << frameSeconds * 1e3 << ',' << age * 1e3 << ',';
+            if (latency >= 0.0)
+                file << latency * 1e3;
+            file << '\n';
+        }
+        ++frames;
+        frameSum += frameSeconds;
+        ageSum += age;
+        if (latency >= 0.0)
+            latencies.push_back(latency);
+        frameSteps = 0;
+        pendingSince = sampledAt = submitAt = -1.0;
+    }
+
+    void report(std::ostream& out, const SimulationClock& clock, uint64_t inputSamples, double seconds) {
+        if (frames == 0)
+            return;
+        out << "Baja latencia: " << frames << " fotogramas de " << frameSum / frames * 1e3 << " ms en promedio, "
+            << clock.steps() << " pasos de " << clock.step() * 1e3 << " ms (" << clock.dropped() << " descartados), "
+            << (seconds > 0.0 ? inputSamples / seconds : 0.0) << " muestreos de entrada por segundo" << std::endl;
+        out << "Baja latencia: antigüedad media de la entrada al enviar " << ageSum / frames * 1e3 << " ms" << std::endl;
+        if (latencies.empty()) {
+            out << "Baja latencia: ningún fotograma con entrada nueva" << std::endl;
+            return;
+        }
+        std::vector<double> sorted = latencies;
+        std::sort(sorted.begin(), sorted.end());
+        double sum = 0.0;
+        for (double latency : sorted)
+            sum += latency;
+        out << "Baja latencia: entrada a envío en " << sorted.size() << " fotogramas: promedio " << sum / sorted.size() * 1e3
+            << " ms, p50 " << sorted[sorted.size() / 2] * 1e3 << " ms, p99 " << sorted[sorted.size() * 99 / 100] * 1e3
+            << " ms, máximo " << sorted.back() * 1e3 << " ms" << std::endl;
+    }
+
+private:
+    std::ofstream file;
+    uint64_t frames = 0;
+    int frameSteps = 0;
+    double pendingSince = -1.0, sampledAt = -1.0, submitAt = -1.0;
+    double frameSum = 0.0, ageSum = 0.0;
+    std::vector<double> latencies;
+};
@@ -1,11 +1,29 @@
 #include <GL/glew.h>     // Biblioteca para manejar extensiones de OpenGL.
 #include <GLFW/glfw3.h>  // Biblioteca para crear ventanas y manejar eventos del sistema.
+#include "gl_trace.h"    // Captura del flujo de llamadas de OpenGL (debe ir antes de todo código GL)
 #include <iostream>      // Biblioteca estándar para entrada y salida.
 #include <fstream>       // Biblioteca para manejar archivos.
 #include <sstream>       // Biblioteca para manejar flujos de cadenas.
 #include <glm/glm.hpp>   // Biblioteca para vectores y matrices matemáticas.
 #include <glm/gtc/matrix_transform.hpp> // Incluye funciones para transformar matrices
 #include <glm/gtc/type_ptr.hpp> // Incluye funciones para convertir matrices a punteros
+#include <chrono>        // Relojes para medir el rendimiento de los modos offline
+#include <cstdlib>       // atoi y strtol para leer los argumentos numéricos
+#include <cstring>       // strcmp para leer los argumentos de la línea de comandos
+#include <climits>       // INT_MAX para validar el número de fotogramas
+#include "offline_render.h" // Render a archivo con lectura asíncrona mediante PBOs
+#include "input_record.h"   // Grabación y reproducción determinista de la entrada
+#include "scene.h"          // Almacén de escena con jerarquía de transformaciones
+#include "frame_memory.h"   // Arena por fotograma y registro de recursos de OpenGL
+#include "bvh.h"            // BVH para selección y consultas de visibilidad
+#include "lightmap.h"       // Horneado de iluminación difusa en la CPU
+#include "command_buffer.h" // Buffers de comandos de dibujo grabados en paralelo
+#include "shader_reload.h"  // Recarga de shaders al guardar los archivos
+#include "particles.h"      // Partículas simuladas en la GPU
+#include "terrain.h"        // Terreno por baldosas con LOD continuo
+#include "multiview.h"      // Varias vistas en una sola pasada
+#include "low_latency.h"    // Bucle con hilo de entrada y latch tardío de la cámara
+#include <random>        // Generador de números aleatorios para los benchmarks
 
 // Variables globales para el control de la cámara
 glm::vec3 cameraPos(0.0f, 0.0f, 0.0f); // Cámara más cerca para una mejor visión de la escena
@@ -13,7 +31,7 @@ glm::vec3 cameraFront(0.0f, -0.3f, -1.0f); // Dirección hacia la escena para cu
 glm::vec3 cameraUp(0.0f, 1.0f, 0.0f);
 
 float deltaTime = 0.0f; // Tiempo entre fotogramas actual y anterior
-float lastFrame = 0.0f; // Tiempo del último fotograma
+double lastFrame = 0.0; // Tiempo del último fotograma (en doble precisión: un float pierde resolución en sesiones largas)
 
 // Variables para el movimiento del ratón
 float lastX = 960.0f; // Posición inicial X del cursor
@@ -22,24 +40,42 @@ float yaw = -90.0f;   // Inicialmente mirando hacia el eje -Z
 float pitch = 0.0f;
 bool firstMouse = true;
 
-// Funciones para el movimiento de la cámara
-void processInput(GLFWwindow* window) {
-    float cameraSpeed = 5.0f * deltaTime; // Ajustar velocidad de la cámara
-    if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
+// Teclas de movimiento de la cámara que están presionadas
+struct MovementKeys {
+    bool forward = false, backward = false, left = false, right = false;
+};
+
+// Grabador de entrada activo (solo con --record)
+InputRecorder* inputRecorder = nullptr;
+
+// Mueve la cámara según las teclas presionadas durante dt segundos
+void moveCamera(const MovementKeys& keys, float dt) {
+    float cameraSpeed = 5.0f * dt; // Ajustar velocidad de la cámara
+    if (keys.forward)
         cameraPos += cameraSpeed * cameraFront;
-    if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
+    if (keys.backward)
         cameraPos -= cameraSpeed * cameraFront;
-    if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
+    if (keys.left)
         cameraPos -= glm::normalize(glm::cross(cameraFront, cameraUp)) * cameraSpeed;
-    if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
+    if (keys.right)
         cameraPos += glm::normalize(glm::cross(cameraFront, cameraUp)) * cameraSpeed;
+}
+
+// Funciones para el movimiento de la cámara
+void processInput(GLFWwindow* window) {
+    MovementKeys keys;
+    keys.forward = glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS;
+    keys.backward = glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS;
+    keys.left = glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS;
+    keys.right = glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS;
+    moveCamera(keys, deltaTime);
     // Cerrar la ventana si se presiona la tecla ESC
     if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
         glfwSetWindowShouldClose(window, true);
 }
 
-// Función para manejar el movimiento del ratón
-void mouse_callback(GLFWwindow* window, double xpos, double ypos) {
+// Orienta la cámara a partir de una nueva posición del cursor
+void rotateCamera(double xpos, double ypos) {
     if (firstMouse) {
         lastX = xpos;
         lastY = ypos;
@@ -71,42 +107,198 @@ void mouse_callback(GLFWwindow* window, double xpos, double ypos) {
     cameraFront = glm::normalize(front);
 }
 
+// Selección de triángulos con el BVH. Guarda las posiciones locales de cada triángulo de la
+// escena y su entidad; si alguna entidad se mueve, el BVH se reajusta en vez de reconstruirse.
+struct ScenePicker {
+    TriangleBvh bvh;
+    std::vector<glm::vec3> localPositions;  // 3 por triángulo, en el espacio de su malla
+    std::vector<glm::vec3> worldPositions;
+    std::vector<Entity> triangleOwner;
+    Entity picked = kNoEntity;
+    double pickSeconds = 0.0;
+    unsigned long picks = 0;
+
+    // vertexSources asocia cada VAO con sus vértices (9 floats por vértice).
+    void build(const SceneStore& store, const std::vector<std::pair<unsigned int, const float*>>& vertexSources) {
+        const MeshPool& meshes = store.meshPool();
+        for (size_t m = 0; m < meshes.size(); ++m) {
+            const float* data = nullptr;
+            for (const auto& source : vertexSources)
+                if (source.first == meshes.vao[m])
+                    data = source.second;
+            if (!data)
+                continue;
+            for (int v = meshes.first[m]; v < meshes.first[m] + meshes.count[m] - meshes.count[m] % 3; ++v)
+                localPositions.push_back(glm::vec3(data[v * 9], data[v * 9 + 1], data[v * 9 + 2]));
+            for (int t = 0; t < meshes.count[m] / 3; ++t)
+                triangleOwner.push_back(meshes.owner[m]);
+        }
+        toWorld(store);
+        bvh.build(worldPositions);
+    }
+
+    // Llamar después de store.updateTransforms() cuando se recalculó alguna matriz.
+    void refit(const SceneStore& store) {
+        toWorld(store);
+        bvh.refit(worldPositions);
+    }
+
+    // Entidad bajo el centro de la pantalla (la cruz de la cámara).
+    Entity pick(const glm::vec3& origin, const glm::vec3& direction) {
+        auto start = std::chrono::steady_clock::now();
+        RayHit hit;
+        Entity entity = bvh.intersect(origin, direction, 1e30f, hit) ? triangleOwner[hit.triangle] : kNoEntity;
+        pickSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        ++picks;
+        return entity;
+    }
+
+private:
+    void toWorld(const SceneStore& store) {
+        worldPositions.resize(localPositions.size());
+        for (size_t i = 0; i < localPositions.size(); ++i)
+            worldPositions[i] = glm::vec3(store.worldMatrix(triangleOwner[i / 3]) * glm::vec4(localPositions[i], 1.0f));
+    }
+};
+
+// Selector activo (solo en el modo interactivo)
+ScenePicker* scenePicker = nullptr;
+
+// Actualiza la entidad bajo la cruz y la muestra en el título de la ventana
+void pickUnderCrosshair(GLFWwindow* window) {
+    Entity entity = scenePicker->pick(cameraPos, cameraFront);
+    if (entity == scenePicker->picked)
+        return;
+    scenePicker->picked = entity;
+    std::string title = "Escena con Triángulos Texturizados y Coloreados";
+    if (entity != kNoEntity)
+        title += " - entidad " + std::to_string(entity);
+    glfwSetWindowTitle(window, title.c_str());
+}
+
+// Función para manejar el movimiento del ratón
+void mouse_callback(GLFWwindow* window, double xpos, double ypos) {
+    // Al grabar, el evento se aplica en el siguiente paso fijo, igual que en la reproducción
+    if (inputRecorder)
+        inputRecorder->cursorEvent(xpos, ypos);
+    else
+        rotateCamera(xpos, ypos);
+    if (scenePicker)
+        pickUnderCrosshair(window);
+}
+
+// Callback de teclado: solo se usa al grabar, para registrar los cambios de las teclas WASD
+void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods) {
+    (void)window;
+    (void)scancode;
+    (void)mods;
+    bool movementKey = key == GLFW_KEY_W || key == GLFW_KEY_A || key == GLFW_KEY_S || key == GLFW_KEY_D;
+    if (inputRecorder && movementKey && action != GLFW_REPEAT)
+        inputRecorder->keyEvent(key, action == GLFW_PRESS);
+}
+
+// Aplica un evento grabado al estado de la cámara
+void applyInputEvent(const InputEvent& event, MovementKeys& keys) {
+    if (event.type == InputEventType::CursorMove) {
+        rotateCamera(event.x, event.y);
+        return;
+    }
+    bool down = event.type == InputEventType::KeyDown;
+    if (event.key == GLFW_KEY_W)
+        keys.forward = down;
+    else if (event.key == GLFW_KEY_S)
+        keys.backward = down;
+    else if (event.key == GLFW_KEY_A)
+        keys.left = down;
+    else if (event.key == GLFW_KEY_D)
+        keys.right = down;
+}
+
+// Reproducción de un registro de entrada: un paso fijo por fotograma
+struct ReplaySession {
+    InputReplay log;
+    MovementKeys keys;
+    uint32_t tick = 0;
+    uint64_t cameraHash = 1469598103934665603ull; // FNV-1a de todas las posiciones y direcciones
+
+    bool load(const char* filepath) { return log.load(filepath); }
+
+    // Avanza un paso; devuelve false cuando el registro terminó.
+    bool step() {
+        if (log.finished(tick))
+            return false;
+        for (const InputEvent& event : log.eventsForTick(tick))
+            applyInputEvent(event, keys);
+        moveCamera(keys, log.stepSeconds());
+        ++tick;
+
+        const float state[6] = { cameraPos.x, cameraPos.y, cameraPos.z, cameraFront.x, cameraFront.y, cameraFront.z };
+        const uint8_t* bytes = reinterpret_cast<const uint8_t*>(state);
+        for (size_t i = 0; i < sizeof(state); ++i)
+            cameraHash = (cameraHash ^ bytes[i]) * 1099511628211ull;
+        return true;
+    }
+
+    void report() const {
+        std::cout << "Reproducción: " << tick << " pasos, cámara final (" << cameraPos.x << ", " << cameraPos.y << ", "
+                  << cameraPos.z << "), huella de la trayectoria " << std::hex << cameraHash << std::dec << std::endl;
+    }
+};
+
 // Función que carga el contenido de un archivo y lo devuelve como un string.
 std::string loadShaderSource(const char* filepath) {
     std::ifstream file(filepath);
+    if (!file)
+        std::cerr << "No se pudo abrir el shader: " << filepath << std::endl;
     std::stringstream buffer;
     buffer << file.rdbuf(); // Lee el contenido del archivo y lo almacena en el buffer.
     return buffer.str();    // Convierte el contenido a string y lo devuelve.
 }
 
-// Función para compilar un shader a partir de su código fuente.
-unsigned int compileShader(unsigned int type, const std::string& source) {
+// Función para compilar un shader a partir de su archivo. prefix (defines o código compartido,
+// ya que GLSL no tiene #include) se inserta justo después de la línea #version. Devuelve 0 si
+// no compila. La usan también las partículas y las vistas múltiples.
+unsigned int compileShader(unsigned int type, const char* path, const std::string& prefix) {
+    std::string source = loadShaderSource(path);
+    size_t versionEnd = source.find('\n') + 1;
+    std::string header = source.substr(0, versionEnd), body = source.substr(versionEnd);
+    const char* strings[] = { header.c_str(), prefix.c_str(), body.c_str() };
     unsigned int shader = glCreateShader(type);
-    const char* src = source.c_str();  // Convierte el código fuente a un puntero de tipo char.
-    glShaderSource(shader, 1, &src, nullptr);  // Carga el código fuente en el objeto shader.
+    glShaderSource(shader, 3, strings, nullptr);  // Carga el código fuente en el objeto shader.
     glCompileShader(shader);  // Compila el shader.
 
     int success;
     glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
     if (!success) {
-        char infoLog[512];
-        glGetShaderInfoLog(shader, 512, nullptr, infoLog);
-        std::cerr << "Error al compilar el shader: " << infoLog << std::endl;
+        char infoLog[1024];
+        glGetShaderInfoLog(shader, sizeof(infoLog), nullptr, infoLog);
+        std::cerr << "Error al compilar " << path << ": " << infoLog << std::endl;
+        glDeleteShader(shader);
+        return 0;
     }
     return shader;  // Devuelve el identificador del shader compilado.
 }
 
+// Punto de enlace del bloque de uniforms por objeto (ObjectBlock en los vertex shaders)
+const unsigned int kObjectBlockBinding = 0;
+
+// Los datos por objeto llegan por el bloque ObjectBlock, siempre en el mismo punto de enlace
+void bindObjectBlock(unsigned int program) {
+    unsigned int objectBlock = glGetUniformBlockIndex(program, "ObjectBlock");
+    if (objectBlock != GL_INVALID_INDEX)
+        glUniformBlockBinding(program, objectBlock, kObjectBlockBinding);
+}
+
 // Función para crear un programa de shader que combina un shader de vértices y uno de fragmentos.
 unsigned int createShaderProgram(const char* vertexPath, const char* fragmentPath) {
-    std::string vertexCode = loadShaderSource(vertexPath);
-    std::string fragmentCode = loadShaderSource(fragmentPath);
-
-    unsigned int vertexShader = compileShader(GL_VERTEX_SHADER, vertexCode);
-    unsigned int fragmentShader = compileShader(GL_FRAGMENT_SHADER, fragmentCode);
+    unsigned int vertexShader = compileShader(GL_VERTEX_SHADER, vertexPath, "");
+    unsigned int fragmentShader = compileShader(GL_FRAGMENT_SHADER, fragmentPath, "");
 
     unsigned int shaderProgram = glCreateProgram();
-    glAttachShader(shaderProgram, vertexShader);
-    glAttachShader(shaderProgram, fragmentShader);
+    if (vertexShader)
+        glAttachShader(shaderProgram, vertexShader);
+    if (fragmentShader)
+        glAttachShader(shaderProgram, fragmentShader);
     glLinkProgram(shaderProgram);  // Enlaza el programa completo de shaders.
 
     int success;
@@ -117,31 +309,151 @@ unsigned int createShaderProgram(const char* vertexPath, const char* fragmentPat
         std::cerr << "Error al enlazar el programa de shaders: " << infoLog << std::endl;
     }
 
+    bindObjectBlock(shaderProgram);
     glDeleteShader(vertexShader);
     glDeleteShader(fragmentShader);
+    trackProgram(shaderProgram, vertexPath);
     return shaderProgram;  // Devuelve el identificador del programa de shaders.
 }
 
+// Coordenadas de los vértices de los triángulos, incluyendo las normales y los colores
+const float vertices[] = {
+    // Primer triángulo - Brillante
+    // posiciones         // normales           // colores
+    -0.5f, -0.5f, 0.0f,    0.0f, 0.0f, 1.0f,    1.0f, 0.0f, 0.0f,  // Rojo
+    0.5f, -0.5f, 0.0f,    0.0f, 0.0f, 1.0f,    0.0f, 1.0f, 0.0f,  // Verde
+    0.0f,  0.5f, 0.0f,    0.0f, 0.0f, 1.0f,    0.0f, 0.0f, 1.0f,  // Azul
+    
+    // Segundo triángulo - Textura como cemento
+    // posiciones         // normales           // colores
+    -0.5f, -0.5f, -0.5f,   0.0f, 0.0f, 1.0f,    0.5f, 0.5f, 0.5f,  // Gris
+    0.5f, -0.5f, -0.5f,   0.0f, 0.0f, 1.0f,    0.5f, 0.5f, 0.5f,  // Gris
+    0.0f,  0.5f, -0.5f,   0.0f, 0.0f, 1.0f,    0.5f, 0.5f, 0.5f,  // Gris
+
+    // Tercer triángulo - Mate, como cemento
+    // posiciones         // normales           // colores
+    -0.5f, -0.5f, 0.5f,    0.0f, 0.0f, 1.0f,    0.6f, 0.6f, 0.6f,  // Cemento
+    0.5f, -0.5f, 0.5f,    0.0f, 0.0f, 1.0f,    0.6f, 0.6f, 0.6f,  // Cemento
+    0.0f,  0.5f, 0.5f,    0.0f, 0.0f, 1.0f,    0.6f, 0.6f, 0.6f,  // Cemento
+
+    // Cuarto triángulo - Brillante, metálico
+    // posiciones         // normales           // colores
+    1.0f, -0.5f, 0.0f,    0.0f, 0.0f, 1.0f,    0.8f, 0.8f, 0.8f,  // Plata
+    1.5f, -0.5f, 0.0f,    0.0f, 0.0f, 1.0f,    0.8f, 0.8f, 0.8f,  // Plata
+    1.25f, 0.5f, 0.0f,    0.0f, 0.0f, 1.0f,    0.8f, 0.8f, 0.8f,  // Plata
+
+    // Quinto triángulo - Amarillo brillante
+    -1.0f, -0.5f, 0.0f,    0.0f, 0.0f, 1.0f,    1.0f, 1.0f, 0.0f,  // Amarillo
+    -0.5f, -0.5f, 0.0f,    0.0f, 0.0f, 1.0f,    1.0f, 1.0f, 0.0f,  // Amarillo
+    -0.75f, 0.5f, 0.0f,    0.0f, 0.0f, 1.0f,    1.0f, 1.0f, 0.0f,  // Amarillo
+
+    // Sexto triángulo - Verde claro
+    1.0f,  1.0f, -0.5f,   0.0f, 0.0f, 1.0f,    0.0f, 1.0f, 0.5f,  // Verde claro
+    1.5f,  1.0f, -0.5f,   0.0f, 0.0f, 1.0f,    0.0f, 1.0f, 0.5f,  // Verde claro
+    1.25f, 1.5f, -0.5f,   0.0f, 0.0f, 1.0f,    0.0f, 1.0f, 0.5f,  // Verde claro
+
+    // Séptimo triángulo - Magenta
+    -1.5f, -1.0f, 0.5f,    0.0f, 0.0f, 1.0f,    1.0f, 0.0f, 1.0f,  // Magenta
+    -1.0f, -1.0f, 0.5f,    0.0f, 0.0f, 1.0f,    1.0f, 0.0f, 1.0f,  // Magenta
+    -1.25f, -0.5f, 0.5f,   0.0f, 0.0f, 1.0f,    1.0f, 0.0f, 1.0f,  // Magenta
+
+    // Octavo triángulo - Cyan
+    -2.0f,  1.0f, -1.0f,   0.0f, 0.0f, 1.0f,    0.0f, 1.0f, 1.0f,  // Cyan
+    -1.5f,  1.0f, -1.0f,   0.0f, 0.0f, 1.0f,    0.0f, 1.0f, 1.0f,  // Cyan
+    -1.75f, 1.5f, -1.0f,   0.0f, 0.0f, 1.0f,    0.0f, 1.0f, 1.0f,  // Cyan
+
+    // Noveno triángulo - Gris oscuro
+    0.0f, -1.0f, -1.0f,   0.0f, 0.0f, 1.0f,    0.3f, 0.3f, 0.3f,  // Gris oscuro
+    0.5f, -1.0f, -1.0f,   0.0f, 0.0f, 1.0f,    0.3f, 0.3f, 0.3f,  // Gris oscuro
+    0.25f, -0.5f, -1.0f,  0.0f, 0.0f, 1.0f,    0.3f, 0.3f, 0.3f,  // Gris oscuro
+
+    // Décimo triángulo - Azul cobalto
+    2.0f,  0.0f, 0.5f,    0.0f, 0.0f, 1.0f,    0.0f, 0.0f, 0.8f,  // Azul cobalto
+    2.5f,  0.0f, 0.5f,    0.0f, 0.0f, 1.0f,    0.0f, 0.0f, 0.8f,  // Azul cobalto
+    2.25f, 0.5f, 0.5f,    0.0f, 0.0f, 1.0f,    0.0f, 0.0f, 0.8f,  // Azul cobalto
+
+    // Undécimo triángulo - Verde oliva
+    -2.5f, -0.5f, 0.5f,    0.0f, 0.0f, 1.0f,    0.5f, 0.5f, 0.0f,  // Verde oliva
+    -3.0f, -0.5f, 0.5f,    0.0f, 0.0f, 1.0f,    0.5f, 0.5f, 0.0f,  // Verde oliva
+    -2.75f, 0.0f, 0.5f,    0.0f, 0.0f, 1.0f,    0.5f, 0.5f, 0.0f,  // Verde oliva
+
+    // Duodécimo triángulo - Lila pastel
+    -3.0f,  1.0f, -0.5f,   0.0f, 0.0f, 1.0f,    0.8f, 0.6f, 1.0f,  // Lila pastel
+    -2.5f,  1.0f, -0.5f,   0.0f, 0.0f, 1.0f,    0.8f, 0.6f, 1.0f,  // Lila pastel
+    -2.75f, 1.5f, -0.5f,   0.0f, 0.0f, 1.0f,    0.8f, 0.6f, 1.0f,  // Lila pastel
+
+    // Decimotercer triángulo - Naranja quemado
+    3.0f, -1.5f, 0.0f,    0.0f, 0.0f, 1.0f,    1.0f, 0.3f, 0.0f,  // Naranja quemado
+    3.5f, -1.5f, 0.0f,    0.0f, 0.0f, 1.0f,    1.0f, 0.3f, 0.0f,  // Naranja quemado
+    3.25f, -1.0f, 0.0f,   0.0f, 0.0f, 1.0f,    1.0f, 0.3f, 0.0f,  // Naranja quemado
+
+    // Decimocuarto triángulo - Azul claro
+    4.0f,  0.5f, 0.0f,    0.0f, 0.0f, 1.0f,    0.4f, 0.7f, 1.0f,  // Azul claro
+    4.5f,  0.5f, 0.0f,    0.0f, 0.0f, 1.0f,    0.4f, 0.7f, 1.0f,  // Azul claro
+    4.25f, 1.0f, 0.0f,    0.0f, 0.0f, 1.0f,    0.4f, 0.7f, 1.0f,  // Azul claro
+
+    // Decimoquinto triángulo - Rojo oscuro
+    -4.0f, -0.5f, -0.5f,   0.0f, 0.0f, 1.0f,    0.5f, 0.0f, 0.0f,  // Rojo oscuro
+    -4.5f, -0.5f, -0.5f,   0.0f, 0.0f, 1.0f,    0.5f, 0.0f, 0.0f,  // Rojo oscuro
+    -4.25f, 0.0f, -0.5f,   0.0f, 0.0f, 1.0f,    0.5f, 0.0f, 0.0f,  // Rojo oscuro
+
+    // Decimosexto triángulo - Rosa brillante
+    3.0f,  1.0f, 1.0f,    0.0f, 0.0f, 1.0f,    1.0f, 0.2f, 0.5f,  // Rosa brillante
+    3.5f,  1.0f, 1.0f,    0.0f, 0.0f, 1.0f,    1.0f, 0.2f, 0.5f,  // Rosa brillante
+    3.25f, 1.5f, 1.0f,    0.0f, 0.0f, 1.0f,    1.0f, 0.2f, 0.5f,  // Rosa brillante
+
+    // Decimoséptimo triángulo - Verde esmeralda
+    -3.0f, -1.0f, 1.5f,    0.0f, 0.0f, 1.0f,    0.0f, 0.8f, 0.4f,  // Verde esmeralda
+    -3.5f, -1.0f, 1.5f,    0.0f, 0.0f, 1.0f,    0.0f, 0.8f, 0.4f,  // Verde esmeralda
+    -3.25f, -0.5f, 1.5f,   0.0f, 0.0f, 1.0f,    0.0f, 0.8f, 0.4f,  // Verde esmeralda
+
+    // Decimooctavo triángulo - Azul marino
+    2.5f,  0.5f, -1.5f,   0.0f, 0.0f, 1.0f,    0.0f, 0.0f, 0.5f,  // Azul marino
+    3.0f,  0.5f, -1.5f,   0.0f, 0.0f, 1.0f,    0.0f, 0.0f, 0.5f,  // Azul marino
+    2.75f, 1.0f, -1.5f,   0.0f, 0.0f, 1.0f,    0.0f, 0.0f, 0.5f,  // Azul marino
+
+    // Decimonoveno triángulo - Amarillo dorado
+    -2.0f, -2.0f, 1.0f,    0.0f, 0.0f, 1.0f,    1.0f, 0.9f, 0.0f,  // Amarillo dorado
+    -1.5f, -2.0f, 1.0f,    0.0f, 0.0f, 1.0f,    1.0f, 0.9f, 0.0f,  // Amarillo dorado
+    -1.75f, -1.5f, 1.0f,   0.0f, 0.0f, 1.0f,    1.0f, 0.9f, 0.0f,  // Amarillo dorado
+
+    // Vigésimo triángulo - Blanco brillante
+    4.5f,  2.0f, 0.5f,    0.0f, 0.0f, 1.0f,    1.0f, 1.0f, 1.0f,  // Blanco brillante
+    5.0f,  2.0f, 0.5f,    0.0f, 0.0f, 1.0f,    1.0f, 1.0f, 1.0f,  // Blanco brillante
+    4.75f, 2.5f, 0.5f,    0.0f, 0.0f, 1.0f,    1.0f, 1.0f, 1.0f   // Blanco brillante
+};
+
+// Vértices del plano base infinito (también los usa el BVH de selección)
+const float groundVertices[] = {
+    // posiciones            // normales         // colores
+    -100.0f, -1.0f,  100.0f,    0.0f, 1.0f, 0.0f,   0.3f, 0.3f, 0.3f,  // Gris
+     100.0f, -1.0f,  100.0f,    0.0f, 1.0f, 0.0f,   0.3f, 0.3f, 0.3f,  // Gris
+     100.0f, -1.0f, -100.0f,    0.0f, 1.0f, 0.0f,   0.3f, 0.3f, 0.3f,  // Gris
+
+    -100.0f, -1.0f,  100.0f,    0.0f, 1.0f, 0.0f,   0.3f, 0.3f, 0.3f,  // Gris
+     100.0f, -1.0f, -100.0f,    0.0f, 1.0f, 0.0f,   0.3f, 0.3f, 0.3f,  // Gris
+    -100.0f, -1.0f, -100.0f,    0.0f, 1.0f, 0.0f,   0.3f, 0.3f, 0.3f   // Gris
+};
+
+// Luces de la escena (también las usa el horneado de iluminación)
+const glm::vec3 lightPos(5.0f, 10.0f, 10.0f); // Luz elevada para iluminar desde arriba
+const glm::vec3 lightColor(0.9f, 0.9f, 1.0f); // Luz ligeramente azulada
+const glm::vec3 lightDir(-0.2f, -1.0f, -0.3f); // Luz direccional descendente
+const glm::vec3 pointLightPos(2.0f, 1.0f, 1.0f);
+
+// Intensidades de los componentes de iluminación
+const float ambientStrength = 0.2f;
+const float diffuseStrength = 1.0f;
+const float specularStrength = 0.5f;
+
 // Función para crear el plano base infinito
 void createGroundPlane(unsigned int &VAO, unsigned int &VBO) {
-    float groundVertices[] = {
-        // posiciones            // normales         // colores
-        -100.0f, -1.0f,  100.0f,    0.0f, 1.0f, 0.0f,   0.3f, 0.3f, 0.3f,  // Gris
-         100.0f, -1.0f,  100.0f,    0.0f, 1.0f, 0.0f,   0.3f, 0.3f, 0.3f,  // Gris
-         100.0f, -1.0f, -100.0f,    0.0f, 1.0f, 0.0f,   0.3f, 0.3f, 0.3f,  // Gris
-
-        -100.0f, -1.0f,  100.0f,    0.0f, 1.0f, 0.0f,   0.3f, 0.3f, 0.3f,  // Gris
-         100.0f, -1.0f, -100.0f,    0.0f, 1.0f, 0.0f,   0.3f, 0.3f, 0.3f,  // Gris
-        -100.0f, -1.0f, -100.0f,    0.0f, 1.0f, 0.0f,   0.3f, 0.3f, 0.3f   // Gris
-    };
-
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
+    VAO = trackedGenVertexArray("plano base");
+    VBO = trackedGenBuffer("plano base");
 
     glBindVertexArray(VAO);
 
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(groundVertices), groundVertices, GL_STATIC_DRAW);
+    trackedBufferData(GL_ARRAY_BUFFER, VBO, sizeof(groundVertices), groundVertices, GL_STATIC_DRAW);
 
     // Atributo de posición
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 9 * sizeof(float), (void*)0);
@@ -156,7 +468,1434 @@ void createGroundPlane(unsigned int &VAO, unsigned int &VBO) {
     glEnableVertexAttribArray(2);
 }
 
-int main() {
+// Crea una entidad por triángulo de vertices[] y una para el plano base, todas hijas de una raíz.
+// Los vértices ya están en coordenadas de mundo, así que las transformaciones locales son identidad.
+// Con groundVAO en 0 no hay plano base (lo reemplaza el terreno).
+void buildSceneStore(SceneStore& store, const float* vertices, int vertexCount, unsigned int VAO, unsigned int groundVAO) {
+    const int stride = 9; // posición, normal y color
+    Entity root = store.createEntity();
+    for (int first = 0; first < vertexCount; first += 3) {
+        glm::vec3 boundsMin(1e30f), boundsMax(-1e30f);
+        for (int v = first; v < first + 3; ++v) {
+            glm::vec3 p(vertices[v * stride], vertices[v * stride + 1], vertices[v * stride + 2]);
+            boundsMin = glm::min(boundsMin, p);
+            boundsMax = glm::max(boundsMax, p);
+        }
+        Entity triangle = store.createEntity(root);
+        store.addMesh(triangle, VAO, first, 3, boundsMin, boundsMax);
+    }
+    if (groundVAO) {
+        Entity ground = store.createEntity(root);
+        store.addMesh(ground, groundVAO, 0, 6, glm::vec3(-100.0f, -1.0f, -100.0f), glm::vec3(100.0f, -1.0f, 100.0f));
+    }
+    store.updateTransforms();
+}
+
+// Mide el costo por fotograma de actualizar la jerarquía cuando solo se mueve una fracción de
+// las entidades, y lo compara con recalcular todas las matrices.
+void runTransformBenchmark(int entityCount) {
+    const int treeSize = 100;  // Entidades por árbol (una raíz y sus descendientes)
+    const int frames = 100;
+    SceneStore store;
+    std::mt19937 rng(1234);
+    std::vector<Entity> entities;
+    entities.reserve(entityCount);
+    for (int i = 0; i < entityCount; ++i) {
+        int inTree = i % treeSize;
+        Entity parent = kNoEntity;
+        if (inTree > 0) // Padre aleatorio entre las entidades anteriores del mismo árbol
+            parent = entities[i - 1 - std::uniform_int_distribution<int>(0, inTree - 1)(rng)];
+        entities.push_back(store.createEntity(parent));
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    store.updateTransforms();
+    double layoutMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    int movers = std::max(1, entityCount / 100);
+    std::uniform_int_distribution<int> pick(0, entityCount - 1);
+    std::uniform_real_distribution<float> offset(-1.0f, 1.0f);
+    double partialMs = 0.0;
+    size_t recomputed = 0;
+    for (int frame = 0; frame < frames; ++frame) {
+        for (int m = 0; m < movers; ++m)
+            store.setLocalPosition(entities[pick(rng)], glm::vec3(offset(rng), offset(rng), offset(rng)));
+        start = std::chrono::steady_clock::now();
+        recomputed += store.updateTransforms();
+        partialMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    double fullMs = 0.0;
+    for (int frame = 0; frame < frames / 10; ++frame) {
+        store.markAllDirty();
+        start = std::chrono::steady_clock::now();
+        store.updateTransforms();
+        fullMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    std::cout << "Jerarquía de " << entityCount << " entidades (" << entityCount / treeSize << " árboles), "
+              << movers << " se mueven por fotograma" << std::endl;
+    std::cout << "  construcción del preorden y primer cálculo: " << layoutMs << " ms" << std::endl;
+    std::cout << "  actualización con marcas de sucio: " << partialMs / frames << " ms/fotograma, "
+              << recomputed / frames << " matrices recalculadas" << std::endl;
+    std::cout << "  recálculo completo: " << fullMs / (frames / 10) << " ms/fotograma" << std::endl;
+}
+
+// Mide la construcción del BVH y el rendimiento de las consultas sobre un terreno ondulado
+// teselado con N triángulos, y el reajuste de un BVH de cajas de objetos que se mueven.
+void runBvhBenchmark(int triangleCount) {
+    std::mt19937 rng(4321);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    int cells = std::max(1, static_cast<int>(std::sqrt(triangleCount / 2.0)));
+    float side = static_cast<float>(cells) * 0.1f;
+    auto height = [](float x, float z) { return 2.0f * std::sin(x * 0.7f) * std::cos(z * 0.5f) + 0.3f * std::sin(x * 5.0f + z * 3.0f); };
+    std::vector<glm::vec3> positions;
+    positions.reserve(6 * static_cast<size_t>(cells) * cells);
+    for (int z = 0; z < cells; ++z) {
+        for (int x = 0; x < cells; ++x) {
+            float x0 = x * 0.1f, x1 = x0 + 0.1f, z0 = z * 0.1f, z1 = z0 + 0.1f;
+            glm::vec3 a(x0, height(x0, z0), z0), b(x1, height(x1, z0), z0);
+            glm::vec3 c(x1, height(x1, z1), z1), d(x0, height(x0, z1), z1);
+            positions.insert(positions.end(), { a, b, c, a, c, d });
+        }
+    }
+    triangleCount = static_cast<int>(positions.size() / 3);
+    auto seconds = [](std::chrono::steady_clock::time_point since) {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - since).count();
+    };
+
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+    TriangleBvh bvh;
+    auto start = std::chrono::steady_clock::now();
+    bvh.build(positions, 1);
+    double serialBuild = seconds(start);
+    start = std::chrono::steady_clock::now();
+    bvh.build(positions, threads);
+    double parallelBuild = seconds(start);
+    start = std::chrono::steady_clock::now();
+    bvh.refit(positions);
+    double refitTime = seconds(start);
+    std::cout << "BVH de " << triangleCount << " triángulos, " << bvh.nodeArray().size() << " nodos" << std::endl;
+    std::cout << "  construcción SAH: " << serialBuild * 1000.0 << " ms con 1 hilo, " << parallelBuild * 1000.0
+              << " ms con " << threads << " hilos" << std::endl;
+    std::cout << "  reajuste: " << refitTime * 1000.0 << " ms" << std::endl;
+
+    // Rayos primarios coherentes de una cámara que mira el terreno en diagonal; cada paquete
+    // toma 8 píxeles contiguos de una fila
+    const int raysX = 512, raysY = 512, rayCount = raysX * raysY;
+    glm::vec3 eye(side * 0.5f, 10.0f, -2.0f);
+    glm::vec3 forward = glm::normalize(glm::vec3(0.0f, -0.5f, 1.0f));
+    glm::vec3 right(1.0f, 0.0f, 0.0f);
+    glm::vec3 up = glm::cross(forward, right);
+    std::vector<glm::vec3> origins(rayCount, eye), directions(rayCount);
+    for (int y = 0; y < raysY; ++y)
+        for (int x = 0; x < raysX; ++x)
+            directions[y * raysX + x] = glm::normalize(forward + right * ((x + 0.5f) / raysX - 0.5f) + up * ((y + 0.5f) / raysY - 0.5f));
+    std::vector<RayHit> hits(rayCount);
+
+    start = std::chrono::steady_clock::now();
+    size_t singleHits = 0;
+    for (int r = 0; r < rayCount; ++r)
+        singleHits += bvh.intersect(origins[r], directions[r], 1e30f, hits[r]);
+    double singleTime = seconds(start);
+
+    start = std::chrono::steady_clock::now();
+    size_t packet4Hits = 0;
+    for (int base = 0; base < rayCount; base += 4) {
+        RayPacket<4> packet;
+        for (int l = 0; l < 4; ++l)
+            packet.set(l, origins[base + l], directions[base + l], 1e30f);
+        bvh.intersectPacket(packet);
+        for (int l = 0; l < 4; ++l)
+            packet4Hits += packet.triangle[l] != kNoHit;
+    }
+    double packet4Time = seconds(start);
+
+    start = std::chrono::steady_clock::now();
+    bvh.intersectRays(origins.data(), directions.data(), 1e30f, hits.data(), rayCount);
+    double packet8Time = seconds(start);
+    size_t packet8Hits = 0;
+    for (const RayHit& hit : hits)
+        packet8Hits += hit.triangle != kNoHit;
+
+    // Rayos de sombra: de puntos vecinos sobre el terreno hacia una luz puntual, como en el
+    // horneado de iluminación (segmentos coherentes dentro de cada paquete)
+    std::vector<glm::vec3> from(rayCount), to(rayCount, glm::vec3(side * 0.5f, 8.0f, side * 0.5f));
+    for (int y = 0; y < raysY; ++y) {
+        for (int x = 0; x < raysX; ++x) {
+            float px = (x + 0.5f) / raysX * side, pz = (y + 0.5f) / raysY * side;
+            from[y * raysX + x] = glm::vec3(px, height(px, pz) + 0.01f, pz);
+        }
+    }
+    std::vector<uint8_t> blocked(rayCount);
+    start = std::chrono::steady_clock::now();
+    bvh.segmentsOccluded(from.data(), to.data(), blocked.data(), rayCount);
+    double segmentTime = seconds(start);
+
+    std::cout << "  rayos individuales: " << rayCount / singleTime / 1e6 << " Mrayos/s (" << singleHits << " impactos)" << std::endl;
+    std::cout << "  paquetes de 4: " << rayCount / packet4Time / 1e6 << " Mrayos/s (" << packet4Hits << " impactos)" << std::endl;
+    std::cout << "  paquetes de 8: " << rayCount / packet8Time / 1e6 << " Mrayos/s (" << packet8Hits << " impactos)" << std::endl;
+    size_t blockedCount = 0;
+    for (uint8_t b : blocked)
+        blockedCount += b;
+    std::cout << "  rayos de sombra en paquetes de 8: " << rayCount / segmentTime / 1e6 << " Msegmentos/s (" << blockedCount
+              << " en sombra)" << std::endl;
+
+    // Selección: un rayo por consulta desde cámaras al azar sobre el terreno
+    const int pickCount = 10000;
+    size_t picked = 0;
+    start = std::chrono::steady_clock::now();
+    for (int p = 0; p < pickCount; ++p) {
+        glm::vec3 origin(unit(rng) * side, 5.0f, unit(rng) * side);
+        glm::vec3 direction(unit(rng) - 0.5f, -0.5f, unit(rng) - 0.5f);
+        RayHit hit;
+        picked += bvh.intersect(origin, direction, 1e30f, hit);
+    }
+    std::cout << "  selección: " << seconds(start) / pickCount * 1e6 << " us por consulta (" << picked << " de "
+              << pickCount << " con impacto)" << std::endl;
+
+    // BVH de objetos: una caja por objeto; cada fotograma se mueve el 1% y se reajusta
+    int objectCount = std::max(1, triangleCount / 10);
+    std::vector<Aabb> objects(objectCount);
+    for (Aabb& box : objects) {
+        glm::vec3 p(unit(rng) * side, unit(rng) * side, unit(rng) * side);
+        box.grow(p - 0.5f);
+        box.grow(p + 0.5f);
+    }
+    Bvh objectBvh;
+    start = std::chrono::steady_clock::now();
+    objectBvh.build(objects, threads);
+    double objectBuild = seconds(start);
+    const int frames = 20;
+    double objectRefit = 0.0;
+    for (int frame = 0; frame < frames; ++frame) {
+        for (int m = 0; m < std::max(1, objectCount / 100); ++m) {
+            Aabb& box = objects[rng() % objectCount];
+            glm::vec3 offset(unit(rng) - 0.5f, unit(rng) - 0.5f, unit(rng) - 0.5f);
+            box.min += offset;
+            box.max += offset;
+        }
+        start = std::chrono::steady_clock::now();
+        objectBvh.refit(objects);
+        objectRefit += seconds(start);
+    }
+    std::cout << "BVH de " << objectCount << " objetos: construcción " << objectBuild * 1000.0 << " ms, reajuste "
+              << objectRefit / frames * 1000.0 << " ms/fotograma" << std::endl;
+}
+
+// Geometría estática que se hornea. Los triángulos y el plano base ya están en coordenadas de
+// mundo; el orden de las mallas es el de los VAOs que reciben las coordenadas del lightmap.
+std::vector<BakeMesh> staticBakeMeshes() {
+    return { { vertices, static_cast<int>(sizeof(vertices) / (9 * sizeof(float))), glm::mat4(1.0f) },
+             { groundVertices, static_cast<int>(sizeof(groundVertices) / (9 * sizeof(float))), glm::mat4(1.0f) } };
+}
+
+BakeLights sceneBakeLights() {
+    return { lightPos, lightDir, lightColor, ambientStrength, diffuseStrength };
+}
+
+// Hornea la iluminación difusa de la escena con todos los núcleos y guarda el atlas.
+int runBake(const std::string& output, int samples) {
+    BakeSettings settings;
+    settings.samples = samples;
+    LightmapAtlas atlas;
+    LightmapBaker baker;
+    auto start = std::chrono::steady_clock::now();
+    double traceSeconds = baker.bake(staticBakeMeshes(), sceneBakeLights(), settings, atlas);
+    double totalSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Lightmap de " << atlas.width << "x" << atlas.height << ", " << baker.texelCount() << " texels con "
+              << samples << " muestras, " << std::max(1u, std::thread::hardware_concurrency()) << " hilos" << std::endl;
+    std::cout << "  trazado: " << traceSeconds << " s (" << baker.texelCount() / traceSeconds / 1000.0
+              << " mil texels/s), total: " << totalSeconds << " s" << std::endl;
+    if (!atlas.save(output.c_str()))
+        return -1;
+    std::cout << "  guardado en " << output << std::endl;
+    return 0;
+}
+
+// Tiempo de horneado con 1, 2, 4... hilos hasta el número de núcleos.
+void runBakeScaling(int samples) {
+    unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<unsigned> counts;
+    for (unsigned threads = 1; threads < cores; threads *= 2)
+        counts.push_back(threads);
+    counts.push_back(cores);
+    double serialSeconds = 0.0;
+    std::cout << "Escalado del horneado (" << samples << " muestras por texel, " << cores << " núcleos)" << std::endl;
+    for (unsigned threads : counts) {
+        BakeSettings settings;
+        settings.samples = samples;
+        settings.threads = threads;
+        LightmapAtlas atlas;
+        LightmapBaker baker;
+        double seconds = baker.bake(staticBakeMeshes(), sceneBakeLights(), settings, atlas);
+        if (threads == 1)
+            serialSeconds = seconds;
+        std::cout << "  " << threads << " hilos: " << seconds << " s, aceleración " << serialSeconds / seconds
+                  << "x, eficiencia " << 100.0 * serialSeconds / seconds / threads << " %" << std::endl;
+    }
+}
+
+// Recursos de OpenGL del lightmap: el atlas como textura, un buffer de coordenadas por VAO y el
+// programa que reemplaza el cálculo difuso por fragmento.
+struct LightmapResources {
+    unsigned int texture = 0;
+    unsigned int program = 0;
+    std::vector<unsigned int> uvBuffers;
+
+    // vaos sigue el orden de staticBakeMeshes().
+    bool create(const char* filepath, const std::vector<unsigned int>& vaos) {
+        LightmapAtlas atlas;
+        if (!atlas.load(filepath))
+            return false;
+        std::vector<BakeMesh> meshes = staticBakeMeshes();
+        bool matches = atlas.uvs.size() == meshes.size();
+        for (size_t m = 0; matches && m < meshes.size(); ++m)
+            matches = atlas.uvs[m].size() == static_cast<size_t>(meshes[m].vertexCount);
+        if (!matches) {
+            std::cerr << "El lightmap " << filepath << " no corresponde a la escena; hay que hornearlo de nuevo" << std::endl;
+            return false;
+        }
+
+        texture = trackedGenTexture("lightmap");
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB16F, atlas.width, atlas.height, 0, GL_RGB, GL_FLOAT, atlas.texels.data());
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glResources.resize(GlResourceKind::Texture, texture, static_cast<size_t>(atlas.width) * atlas.height * 6);
+
+        // Atributo 3: coordenada del lightmap, en un buffer aparte del de posiciones
+        for (size_t m = 0; m < vaos.size(); ++m) {
+            unsigned int buffer = trackedGenBuffer("UV del lightmap");
+            glBindVertexArray(vaos[m]);
+            trackedBufferData(GL_ARRAY_BUFFER, buffer, atlas.uvs[m].size() * sizeof(glm::vec2), atlas.uvs[m].data(), GL_STATIC_DRAW);
+            glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+            glEnableVertexAttribArray(3);
+            uvBuffers.push_back(buffer);
+        }
+        glBindVertexArray(0);
+        program = createShaderProgram("lightmap_vertex_shader.glsl", "lightmap_fragment_shader.glsl");
+        return true;
+    }
+
+    void destroy() {
+        for (unsigned int& buffer : uvBuffers)
+            trackedDeleteBuffer(buffer);
+        uvBuffers.clear();
+        if (texture)
+            trackedDeleteTexture(texture);
+        if (program)
+            trackedDeleteProgram(program);
+    }
+};
+
+// Contenido de ObjectBlock para un dibujo (std140: dos mat4 seguidas, sin relleno)
+struct ObjectUniforms {
+    glm::mat4 model;
+    glm::mat4 normalMatrix;
+};
+
+// Grabación paralela de la lista de dibujo. Cada hilo graba un tramo contiguo de las mallas en
+// su propio buffer de comandos y escribe los uniforms de esos objetos en su parte del área de
+// preparación; el hilo del contexto sube el área con una sola copia y traduce los comandos.
+struct ParallelDrawRecorder {
+    RecordingPool pool;
+    unsigned int uniformBuffer = 0;
+    size_t uniformCapacity = 0;
+    size_t uniformStride = 0;  // sizeof(ObjectUniforms) redondeado a la alineación de rangos
+    double recordSeconds = 0.0, submitSeconds = 0.0;
+    size_t frames = 0;
+
+    explicit ParallelDrawRecorder(unsigned threads) : pool(std::max(1u, threads)) {}
+
+    void create() {
+        int alignment = 256;
+        glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+        uniformStride = (sizeof(ObjectUniforms) + alignment - 1) / alignment * alignment;
+        uniformBuffer = trackedGenBuffer("uniforms por objeto");
+    }
+
+    void destroy() { trackedDeleteBuffer(uniformBuffer); }
+
+    void report(std::ostream& out) const {
+        if (frames == 0)
+            return;
+        out << "Lista de dibujo con " << pool.threadCount() << " hilos: grabación " << recordSeconds / frames * 1e3
+            << " ms, envío " << submitSeconds / frames * 1e3 << " ms por fotograma" << std::endl;
+    }
+};
+
+// Contador de sobredibujo. Durante el pase de iluminación cada fragmento que pasa la prueba de
+// profundidad (es decir, que ejecuta el fragment shader de Phong) incrementa el stencil del
+// píxel. Después, un triángulo de pantalla completa por nivel (stencil >= nivel) pinta el mapa de
+// calor y cuenta los píxeles con una consulta de oclusión: la suma de todos los niveles es el
+// total de fragmentos sombreados, sin leer el stencil en la CPU. Las consultas se esperan en el
+// mismo fotograma, así que es una herramienta de diagnóstico y no algo para dejar activo.
+struct OverdrawCounter {
+    unsigned int program = 0;
+    unsigned int emptyVAO = 0; // El core profile exige un VAO enlazado aunque no haya atributos
+    unsigned int query = 0;
+    double shadedFragments = 0.0, coveredPixels = 0.0;
+    size_t frames = 0;
+
+    void create() {
+        program = createShaderProgram("overdraw_vertex_shader.glsl", "overdraw_fragment_shader.glsl");
+        emptyVAO = trackedGenVertexArray("sobredibujo");
+        glGenQueries(1, &query);
+    }
+
+    void destroy() {
+        if (query)
+            glDeleteQueries(1, &query);
+        query = 0;
+        trackedDeleteVertexArray(emptyVAO);
+        trackedDeleteProgram(program);
+    }
+
+    // Prepara el stencil para contar; se llama justo antes del pase de iluminación.
+    static void beginCounting() {
+        glEnable(GL_STENCIL_TEST);
+        glStencilFunc(GL_ALWAYS, 0, 0xFF);
+        glStencilOp(GL_KEEP, GL_KEEP, GL_INCR);
+    }
+
+    // Pinta el mapa de calor sobre la imagen y acumula el conteo del fotograma.
+    void resolve() {
+        static const glm::vec3 heat[] = { { 0.0f, 0.0f, 0.6f }, { 0.0f, 0.7f, 0.2f }, { 0.9f, 0.9f, 0.0f },
+                                          { 1.0f, 0.5f, 0.0f }, { 1.0f, 0.0f, 0.0f }, { 1.0f, 0.0f, 1.0f },
+                                          { 1.0f, 1.0f, 1.0f } };
+        const int levels = sizeof(heat) / sizeof(heat[0]);
+        glDisable(GL_DEPTH_TEST);
+        glStencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
+        glUseProgram(program);
+        glBindVertexArray(emptyVAO);
+        int colorLoc = glGetUniformLocation(program, "levelColor");
+        for (int level = 1; level <= 0xFF; ++level) {
+            glStencilFunc(GL_LEQUAL, level, 0xFF); // Pasa donde level <= stencil
+            glUniform3fv(colorLoc, 1, glm::value_ptr(heat[std::min(level, levels) - 1]));
+            glBeginQuery(GL_SAMPLES_PASSED, query);
+            glDrawArrays(GL_TRIANGLES, 0, 3);
+            glEndQuery(GL_SAMPLES_PASSED);
+            GLuint64 samples = 0;
+            glGetQueryObjectui64v(query, GL_QUERY_RESULT, &samples);
+            if (samples == 0)
+                break;
+            if (level == 1)
+                coveredPixels += static_cast<double>(samples);
+            shadedFragments += static_cast<double>(samples);
+        }
+        glDisable(GL_STENCIL_TEST);
+        glEnable(GL_DEPTH_TEST);
+        ++frames;
+    }
+
+    // Fragmentos sombreados por píxel cubierto (1.0 = sin sobredibujo).
+    double average() const { return coveredPixels > 0.0 ? shadedFragments / coveredPixels : 0.0; }
+
+    void reset() { shadedFragments = coveredPixels = 0.0, frames = 0; }
+
+    void report(std::ostream& out) const {
+        if (frames > 0)
+            out << "Sobredibujo: " << average() << " fragmentos sombreados por píxel cubierto" << std::endl;
+    }
+};
+
+// Recursos de la escena que se necesitan para dibujar un fotograma
+struct SceneResources {
+    SceneStore* store;
+    FrameArena* frameArena;   // Memoria temporal del fotograma (buffers de comandos y uniforms)
+    ParallelDrawRecorder* recorder;
+    unsigned int shaderProgram;
+    glm::mat4 projection;
+    glm::vec3 lightPos, lightColor, lightDir, pointLightPos;
+    unsigned int lightmapTexture = 0; // Atlas de iluminación horneada (0 = Phong por fragmento)
+    unsigned int depthProgram = 0;    // Pre-pase de profundidad (0 = sin pre-pase)
+    bool frontToBack = false;         // Ordenar los objetos de adelante hacia atrás antes de grabar
+    OverdrawCounter* overdraw = nullptr; // Cuenta y pinta los fragmentos sombreados por píxel
+    ParticleSystem* particles = nullptr;  // Partículas simuladas en la GPU (se dibujan al final)
+    TerrainSystem* terrain = nullptr;     // Terreno por baldosas en lugar del plano base
+    MultiView* multiView = nullptr;       // Varias vistas en una pasada (instancia por vista)
+    std::function<void()> latchCamera = nullptr; // Actualiza la cámara justo antes del envío (--low-latency)
+};
+
+// Traduce los buffers de comandos, en orden, a llamadas de OpenGL. Los enlaces repetidos se
+// descartan también entre buffers: un tramo que empieza con el mismo programa o VAO que dejó el
+// anterior no vuelve a enlazarlo. Si programOverride no es 0 reemplaza a los programas grabados:
+// así el pre-pase de profundidad reutiliza los mismos buffers con su propio programa. Con
+// instances > 1 cada dibujo se instancia (una instancia por vista).
+void submitCommandBuffers(const CommandBuffer* buffers, size_t count, unsigned int uniformBuffer,
+                          unsigned int currentProgram, unsigned int programOverride = 0, int instances = 1) {
+    uint32_t program = currentProgram, vao = 0xFFFFFFFFu;
+    for (size_t b = 0; b < count; ++b) {
+        const DrawCommand* command = buffers[b].data();
+        const DrawCommand* end = command + buffers[b].size();
+        for (; command != end; ++command) {
+            const uint32_t* args = command->args;
+            switch (command->type) {
+            case DrawCommandType::BindProgram: {
+                uint32_t id = programOverride ? programOverride : args[0];
+                if (id != program)
+                    glUseProgram(program = id);
+                break;
+            }
+            case DrawCommandType::BindVertexArray:
+                if (args[0] != vao)
+                    glBindVertexArray(vao = args[0]);
+                break;
+            case DrawCommandType::SetUniformRange:
+                glBindBufferRange(GL_UNIFORM_BUFFER, args[0], uniformBuffer, args[1], args[2]);
+                break;
+            case DrawCommandType::Draw:
+                if (instances > 1)
+                    glDrawArraysInstanced(GL_TRIANGLES, args[0], args[1], instances);
+                else
+                    glDrawArrays(GL_TRIANGLES, args[0], args[1]);
+                break;
+            }
+        }
+    }
+}
+
+// Uniforms de iluminación de Phong (luces, cámara e intensidades) sobre el programa enlazado.
+// Los comparten el programa de la escena, el de las partículas y el del terreno.
+void setPhongLighting(unsigned int shaderProgram, const SceneResources& scene) {
+    // Pasar la posición, el color y la dirección de la luz al fragment shader
+    int lightPosLoc = glGetUniformLocation(shaderProgram, "lightPos");
+    glUniform3fv(lightPosLoc, 1, &scene.lightPos[0]);
+
+    int lightColorLoc = glGetUniformLocation(shaderProgram, "lightColor");
+    glUniform3fv(lightColorLoc, 1, &scene.lightColor[0]);
+
+    int lightDirLoc = glGetUniformLocation(shaderProgram, "lightDir");
+    glUniform3fv(lightDirLoc, 1, glm::value_ptr(scene.lightDir));
+
+    int pointLightPosLoc = glGetUniformLocation(shaderProgram, "pointLightPos");
+    glUniform3fv(pointLightPosLoc, 1, glm::value_ptr(scene.pointLightPos));
+
+    int viewPosLoc = glGetUniformLocation(shaderProgram, "viewPos");
+    glUniform3fv(viewPosLoc, 1, &cameraPos[0]);
+
+    // Pasar las intensidades de los componentes de iluminación al fragment shader
+    glUniform1f(glGetUniformLocation(shaderProgram, "ambientStrength"), ambientStrength);
+    glUniform1f(glGetUniformLocation(shaderProgram, "diffuseStrength"), diffuseStrength);
+    glUniform1f(glGetUniformLocation(shaderProgram, "specularStrength"), specularStrength);
+}
+
+// Dibuja la escena completa desde la cámara actual sobre el framebuffer enlazado.
+void drawScene(const SceneResources& scene) {
+    // Con varias vistas, el programa, los viewports y el framebuffer de capas los prepara MultiView
+    unsigned int shaderProgram = scene.shaderProgram;
+    if (scene.multiView) {
+        scene.multiView->setCamera(cameraPos, cameraFront, cameraUp);
+        shaderProgram = scene.multiView->begin();
+    }
+
+    // Limpiar la pantalla (con una pasada por vista, solo en la primera)
+    glClearColor(0.3f, 0.3f, 0.3f, 1.0f);
+    if (!scene.multiView || scene.multiView->firstPass())
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | (scene.overdraw ? GL_STENCIL_BUFFER_BIT : 0));
+
+    // Usar el programa de shaders
+    glUseProgram(shaderProgram);
+
+    // Definir la matriz de vista basada en la posición de la cámara
+    glm::mat4 view = glm::lookAt(cameraPos, cameraPos + cameraFront, cameraUp);
+
+    // Pasar las matrices de transformación al vertex shader
+    int viewLoc = glGetUniformLocation(shaderProgram, "view");
+    int projLoc = glGetUniformLocation(shaderProgram, "projection");
+    glUniformMatrix4fv(viewLoc, 1, GL_FALSE, glm::value_ptr(view));
+    glUniformMatrix4fv(projLoc, 1, GL_FALSE, glm::value_ptr(scene.projection));
+
+    setPhongLighting(shaderProgram, scene);
+
+    // Con lightmap, la parte difusa sale del atlas horneado (unidad de textura 0)
+    if (scene.lightmapTexture) {
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, scene.lightmapTexture);
+        glUniform1i(glGetUniformLocation(shaderProgram, "lightmap"), 0);
+    }
+
+    // Pasar el color del objeto al fragment shader
+    glm::vec3 objectColor(1.0f, 0.5f, 0.3f); // Color base del objeto (naranja)
+    int objectColorLoc = glGetUniformLocation(shaderProgram, "objectColor");
+    glUniform3fv(objectColorLoc, 1, glm::value_ptr(objectColor));
+
+    // Grabar la lista de dibujo en paralelo: los buffers de comandos y el área de uniforms salen
+    // de la arena del fotograma y cada tramo escribe solo en su parte
+    const SceneStore& store = *scene.store;
+    const MeshPool& meshes = store.meshPool();
+    ParallelDrawRecorder& recorder = *scene.recorder;
+    size_t drawCount = meshes.size();
+    if (drawCount == 0) {
+        if (scene.multiView)
+            scene.multiView->end();
+        return;
+    }
+    auto recordStart = std::chrono::steady_clock::now();
+    size_t stride = recorder.uniformStride;
+    size_t uniformBytes = drawCount * stride;
+    uint8_t* uniforms = static_cast<uint8_t*>(scene.frameArena->allocate(uniformBytes, alignof(ObjectUniforms)));
+    size_t sliceSize = std::max<size_t>(64, (drawCount + recorder.pool.threadCount() * 4 - 1) / (recorder.pool.threadCount() * 4));
+    unsigned slices = static_cast<unsigned>((drawCount + sliceSize - 1) / sliceSize);
+    CommandBuffer* buffers = scene.frameArena->allocateArray<CommandBuffer>(slices);
+    // Sin construir: CommandBuffer::push escribe cada comando que informa y el resto no se lee.
+    // Poner a cero el peor caso en cada fotograma contaría como tiempo de grabación.
+    DrawCommand* storage = static_cast<DrawCommand*>(scene.frameArena->allocate(
+        CommandBuffer::worstCase(sliceSize) * slices * sizeof(DrawCommand), alignof(DrawCommand)));
+
+    // De adelante hacia atrás: lo que queda tapado falla la prueba de profundidad antes del
+    // fragment shader. La clave es el punto medio del tramo de profundidad que la caja ocupa
+    // delante de la cámara; con el centro, un objeto enorme como el piso (cuyo centro queda junto
+    // a la cámara) se dibujaría primero y todo lo que tiene encima lo volvería a sombrear. Los
+    // tramos siguen el orden ordenado, pero cada malla conserva su lugar en el área de uniforms.
+    uint32_t* order = nullptr;
+    if (scene.frontToBack) {
+        order = static_cast<uint32_t*>(scene.frameArena->allocate(drawCount * sizeof(uint32_t), alignof(uint32_t)));
+        float* depth = static_cast<float*>(scene.frameArena->allocate(drawCount * sizeof(float), alignof(float)));
+        for (size_t m = 0; m < drawCount; ++m) {
+            glm::mat4 modelView = view * store.worldMatrix(meshes.owner[m]);
+            glm::vec3 center = 0.5f * (meshes.boundsMin[m] + meshes.boundsMax[m]);
+            glm::vec3 extent = 0.5f * (meshes.boundsMax[m] - meshes.boundsMin[m]);
+            float centerDepth = -(modelView * glm::vec4(center, 1.0f)).z;
+            float radius = std::abs(modelView[0][2]) * extent.x + std::abs(modelView[1][2]) * extent.y +
+                           std::abs(modelView[2][2]) * extent.z;
+            depth[m] = 0.5f * (std::max(centerDepth - radius, 0.0f) + centerDepth + radius);
+            order[m] = static_cast<uint32_t>(m);
+        }
+        std::sort(order, order + drawCount, [depth](uint32_t a, uint32_t b) { return depth[a] < depth[b]; });
+    }
+
+    recorder.pool.run(slices, [&](unsigned slice) {
+        size_t begin = slice * sliceSize, end = std::min(drawCount, begin + sliceSize);
+        CommandBuffer& buffer = buffers[slice];
+        buffer.begin(storage + slice * CommandBuffer::worstCase(sliceSize), CommandBuffer::worstCase(sliceSize));
+        buffer.bindProgram(shaderProgram);
+        for (size_t i = begin; i < end; ++i) {
+            size_t m = order ? order[i] : i;
+            ObjectUniforms& object = *reinterpret_cast<ObjectUniforms*>(uniforms + m * stride);
+            object.model = store.worldMatrix(meshes.owner[m]);
+            object.normalMatrix = glm::transpose(glm::inverse(object.model));
+            buffer.bindVertexArray(meshes.vao[m]);
+            buffer.setUniformRange(kObjectBlockBinding, static_cast<uint32_t>(m * stride), sizeof(ObjectUniforms));
+            buffer.draw(meshes.first[m], meshes.count[m]);
+        }
+    });
+    auto submitStart = std::chrono::steady_clock::now();
+
+    // Subir todos los uniforms del fotograma de una vez; el buffer se huérfana para no esperar a
+    // la GPU si todavía lee los del fotograma anterior
+    if (uniformBytes > recorder.uniformCapacity)
+        recorder.uniformCapacity = uniformBytes * 3 / 2;
+    trackedBufferData(GL_UNIFORM_BUFFER, recorder.uniformBuffer, recorder.uniformCapacity, nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, uniformBytes, uniforms);
+
+    // Latch tardío: la cámara se vuelve a leer con la entrada más reciente después de grabar y
+    // subir los uniforms, así el envío no usa la del comienzo del fotograma. Solo cambian la vista
+    // y la posición de la cámara (y el buffer de vistas con MultiView); el orden de adelante hacia
+    // atrás se calculó con la anterior, que difiere en menos de un fotograma.
+    if (scene.latchCamera) {
+        scene.latchCamera();
+        view = glm::lookAt(cameraPos, cameraPos + cameraFront, cameraUp);
+        glUniformMatrix4fv(viewLoc, 1, GL_FALSE, glm::value_ptr(view));
+        glUniform3fv(glGetUniformLocation(shaderProgram, "viewPos"), 1, &cameraPos[0]);
+        if (scene.multiView)
+            scene.multiView->setCamera(cameraPos, cameraFront, cameraUp);
+    }
+    unsigned int currentProgram = shaderProgram;
+    if (scene.depthProgram) {
+        // Pre-pase: solo profundidad, con los mismos buffers de comandos
+        glUseProgram(scene.depthProgram);
+        glUniformMatrix4fv(glGetUniformLocation(scene.depthProgram, "view"), 1, GL_FALSE, glm::value_ptr(view));
+        glUniformMatrix4fv(glGetUniformLocation(scene.depthProgram, "projection"), 1, GL_FALSE, glm::value_ptr(scene.projection));
+        glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+        submitCommandBuffers(buffers, slices, recorder.uniformBuffer, scene.depthProgram, scene.depthProgram);
+        currentProgram = scene.depthProgram;
+
+        // Iluminación: solo pasa el fragmento que quedó más cerca, una vez por píxel
+        glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+        glDepthMask(GL_FALSE);
+        glDepthFunc(GL_EQUAL);
+    }
+    if (scene.overdraw)
+        OverdrawCounter::beginCounting();
+    submitCommandBuffers(buffers, slices, recorder.uniformBuffer, currentProgram, 0,
+                         scene.multiView ? scene.multiView->instances() : 1);
+    if (scene.depthProgram) {
+        glDepthMask(GL_TRUE);
+        glDepthFunc(GL_LESS);
+    }
+
+    // Terreno: después de los objetos, así lo que tapan no se sombrea
+    if (scene.terrain) {
+        setPhongLighting(scene.terrain->useProgram(view, scene.projection), scene);
+        scene.terrain->draw();
+    }
+
+    // Partículas: esferas opacas, después de la geometría y fuera del pre-pase
+    if (scene.particles) {
+        setPhongLighting(scene.particles->useRenderProgram(view, scene.projection), scene);
+        scene.particles->draw();
+    }
+    if (scene.overdraw)
+        scene.overdraw->resolve();
+    if (scene.multiView)
+        scene.multiView->end();
+
+    auto submitEnd = std::chrono::steady_clock::now();
+    recorder.recordSeconds += std::chrono::duration<double>(submitStart - recordStart).count();
+    recorder.submitSeconds += std::chrono::duration<double>(submitEnd - submitStart).count();
+    ++recorder.frames;
+}
+
+// Opciones de la línea de comandos
+struct AppOptions {
+    int offlineFrames = 0;                  // --offline N: renderizar N fotogramas a archivo y salir
+    int offlineFps = 60;                    // --fps N: fotogramas por segundo del recorrido
+    int readbackSlots = 3;                  // --pbo-slots N: tamaño del anillo de PBOs
+    FrameFormat format = FrameFormat::PNG;  // --format png|y4m
+    std::string output;                     // --out patrón (png: "frame_%05d.png") o archivo (y4m)
+    std::string cameraPathFile;             // --path archivo con la trayectoria de la cámara
+    std::string recordFile;                 // --record archivo: grabar la entrada con paso fijo
+    std::string replayFile;                 // --replay archivo: reproducir una entrada grabada
+    int benchTransforms = 0;                // --bench-transforms N: medir la jerarquía con N entidades
+    int benchBvh = 0;                       // --bench-bvh N: medir el BVH con N triángulos
+    std::string bakeFile;                   // --bake archivo [muestras]: hornear el lightmap y salir
+    int bakeSamples = 64;
+    int benchBake = 0;                      // --bench-bake [muestras]: escalado del horneado por núcleos
+    std::string lightmapFile;               // --lightmap archivo: usar la iluminación horneada
+    bool benchLightmap = false;             // --bench-lightmap: costo de GPU con y sin lightmap
+    std::string captureFile;                // --capture archivo [N]: grabar las llamadas de OpenGL
+    int captureFrames = 1;
+    unsigned recordThreads = 0;             // --record-threads N: hilos que graban la lista de dibujo (0 = núcleos)
+    int benchCommands = 0;                  // --bench-commands N: grabación y envío con hasta N entidades
+    bool depthPrepass = false;              // --depth-prepass: pre-pase de profundidad y orden de adelante hacia atrás
+    bool overdraw = false;                  // --overdraw: mapa de calor y conteo del sobredibujo
+    int benchPrepass = 0;                   // --bench-prepass [N]: tiempos con y sin pre-pase (N triángulos apilados)
+    int particles = 0;                      // --particles N: fuente de N partículas simuladas en la GPU
+    bool particlesFeedback = false;         // --particles-tf: simular con transform feedback aunque haya compute
+    int benchParticles = 0;                 // --bench-particles [N]: partículas por segundo con hasta N partículas
+    std::string terrainDir;                 // --terrain carpeta: terreno por baldosas en lugar del plano base
+    int terrainCapMB = 8;                   // --terrain-cap MB: tope de memoria de las baldosas residentes
+    std::string makeTerrainDir;             // --make-terrain carpeta [N]: generar N x N baldosas y salir
+    int makeTerrainTiles = 16;
+    int views = 0;                          // --views N: N vistas en una pasada (2 = estéreo, 6 = cubo)
+    bool viewsLayered = false;              // --views-layered: cada vista en una capa en vez de un viewport
+    bool viewsGeometryShader = false;       // --views-gs: enrutar las vistas con geometry shader
+    int benchViews = 0;                     // --bench-views [N]: envío con 1, 2, 4 y 6 vistas y N entidades
+    bool lowLatency = false;                // --low-latency [archivo]: hilo de entrada, paso fijo y latch tardío
+    std::string latencyLogFile = "latencia.csv";
+    int frameLimit = 0;                     // --frame-limit FPS: limitar el ritmo del bucle de baja latencia
+};
+
+bool parseOptions(int argc, char** argv, AppOptions& options) {
+    for (int i = 1; i < argc; ++i) {
+        bool hasValue = i + 1 < argc;
+        if (!std::strcmp(argv[i], "--offline") && hasValue) {
+            ++i;
+            char* end = nullptr;
+            long frames = std::strtol(argv[i], &end, 10);
+            if (end == argv[i] || *end != '\0' || frames <= 0 || frames > INT_MAX) {
+                std::cerr << "--offline necesita un número de fotogramas positivo: " << argv[i] << std::endl;
+                return false;
+            }
+            options.offlineFrames = static_cast<int>(frames);
+        }
+        else if (!std::strcmp(argv[i], "--fps") && hasValue)
+            options.offlineFps = std::max(1, std::atoi(argv[++i]));
+        else if (!std::strcmp(argv[i], "--pbo-slots") && hasValue)
+            options.readbackSlots = std::max(1, std::atoi(argv[++i]));
+        else if (!std::strcmp(argv[i], "--format") && hasValue) {
+            ++i;
+            if (!std::strcmp(argv[i], "png"))
+                options.format = FrameFormat::PNG;
+            else if (!std::strcmp(argv[i], "y4m"))
+                options.format = FrameFormat::Y4M;
+            else {
+                std::cerr << "Formato desconocido: " << argv[i] << " (se admite png o y4m)" << std::endl;
+                return false;
+            }
+        }
+        else if (!std::strcmp(argv[i], "--out") && hasValue)
+            options.output = argv[++i];
+        else if (!std::strcmp(argv[i], "--path") && hasValue)
+            options.cameraPathFile = argv[++i];
+        else if (!std::strcmp(argv[i], "--record") && hasValue)
+            options.recordFile = argv[++i];
+        else if (!std::strcmp(argv[i], "--replay") && hasValue)
+            options.replayFile = argv[++i];
+        else if (!std::strcmp(argv[i], "--bench-transforms"))
+            options.benchTransforms = hasValue && argv[i + 1][0] != '-' ? std::atoi(argv[++i]) : 1000000;
+        else if (!std::strcmp(argv[i], "--bench-bvh"))
+            options.benchBvh = hasValue && argv[i + 1][0] != '-' ? std::atoi(argv[++i]) : 1000000;
+        else if (!std::strcmp(argv[i], "--bake") && hasValue) {
+            options.bakeFile = argv[++i];
+            if (i + 1 < argc && argv[i + 1][0] != '-')
+                options.bakeSamples = std::max(1, std::atoi(argv[++i]));
+        } else if (!std::strcmp(argv[i], "--bench-bake"))
+            options.benchBake = hasValue && argv[i + 1][0] != '-' ? std::max(1, std::atoi(argv[++i])) : 16;
+        else if (!std::strcmp(argv[i], "--lightmap") && hasValue)
+            options.lightmapFile = argv[++i];
+        else if (!std::strcmp(argv[i], "--bench-lightmap"))
+            options.benchLightmap = true;
+        else if (!std::strcmp(argv[i], "--record-threads") && hasValue)
+            options.recordThreads = static_cast<unsigned>(std::max(1, std::atoi(argv[++i])));
+        else if (!std::strcmp(argv[i], "--bench-commands"))
+            options.benchCommands = hasValue && argv[i + 1][0] != '-' ? std::max(1, std::atoi(argv[++i])) : 100000;
+        else if (!std::strcmp(argv[i], "--depth-prepass"))
+            options.depthPrepass = true;
+        else if (!std::strcmp(argv[i], "--overdraw"))
+            options.overdraw = true;
+        else if (!std::strcmp(argv[i], "--bench-prepass"))
+            options.benchPrepass = hasValue && argv[i + 1][0] != '-' ? std::max(1, std::atoi(argv[++i])) : 2000;
+        else if (!std::strcmp(argv[i], "--particles") && hasValue)
+            options.particles = std::max(1, std::atoi(argv[++i]));
+        else if (!std::strcmp(argv[i], "--particles-tf"))
+            options.particlesFeedback = true;
+        else if (!std::strcmp(argv[i], "--bench-particles"))
+            options.benchParticles = hasValue && argv[i + 1][0] != '-' ? std::max(1, std::atoi(argv[++i])) : 1000000;
+        else if (!std::strcmp(argv[i], "--views") && hasValue)
+            options.views = std::max(1, std::min(kMaxViews, std::atoi(argv[++i])));
+        else if (!std::strcmp(argv[i], "--views-layered"))
+            options.viewsLayered = true;
+        else if (!std::strcmp(argv[i], "--views-gs"))
+            options.viewsGeometryShader = true;
+        else if (!std::strcmp(argv[i], "--bench-views"))
+            options.benchViews = hasValue && argv[i + 1][0] != '-' ? std::max(1, std::atoi(argv[++i])) : 10000;
+        else if (!std::strcmp(argv[i], "--terrain") && hasValue)
+            options.terrainDir = argv[++i];
+        else if (!std::strcmp(argv[i], "--terrain-cap") && hasValue)
+            options.terrainCapMB = std::max(1, std::atoi(argv[++i]));
+        else if (!std::strcmp(argv[i], "--make-terrain") && hasValue) {
+            options.makeTerrainDir = argv[++i];
+            if (i + 1 < argc && argv[i + 1][0] != '-')
+                options.makeTerrainTiles = std::max(1, std::atoi(argv[++i]));
+        } else if (!std::strcmp(argv[i], "--low-latency")) {
+            options.lowLatency = true;
+            if (hasValue && argv[i + 1][0] != '-')
+                options.latencyLogFile = argv[++i];
+        } else if (!std::strcmp(argv[i], "--frame-limit") && hasValue)
+            options.frameLimit = std::max(1, std::atoi(argv[++i]));
+        else if (!std::strcmp(argv[i], "--capture") && hasValue) {
+            options.captureFile = argv[++i];
+            if (i + 1 < argc && argv[i + 1][0] != '-')
+                options.captureFrames = std::max(1, std::atoi(argv[++i]));
+        }
+        else {
+            std::cerr << "Argumento desconocido: " << argv[i] << std::endl;
+            return false;
+        }
+    }
+    if (options.benchLightmap && options.lightmapFile.empty()) {
+        std::cerr << "--bench-lightmap necesita --lightmap archivo" << std::endl;
+        return false;
+    }
+    if (options.views > 0 && (!options.lightmapFile.empty() || options.depthPrepass || options.overdraw ||
+                              options.particles > 0 || !options.terrainDir.empty())) {
+        std::cerr << "--views solo dibuja la escena con Phong: no se combina con --lightmap, --depth-prepass, "
+                     "--overdraw, --particles ni --terrain" << std::endl;
+        return false;
+    }
+    if (options.lowLatency && (!options.recordFile.empty() || !options.replayFile.empty())) {
+        std::cerr << "--low-latency no se combina con --record ni --replay: la grabación usa su propio paso fijo" << std::endl;
+        return false;
+    }
+    if (options.frameLimit > 0 && !options.lowLatency) {
+        std::cerr << "--frame-limit necesita --low-latency" << std::endl;
+        return false;
+    }
+    if (!options.terrainDir.empty() && !options.lightmapFile.empty()) {
+        std::cerr << "--terrain no tiene lightmap: el atlas se hornea sobre el plano base" << std::endl;
+        return false;
+    }
+    if (options.output.empty())
+        options.output = options.format == FrameFormat::Y4M ? "recorrido.y4m" : "frame_%05d.png";
+    if (options.format == FrameFormat::PNG && !isFramePattern(options.output)) {
+        std::cerr << "--out con png necesita un patrón con una sola conversión %d o %0Nd (por ejemplo frame_%05d.png): "
+                  << options.output << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Renderiza el recorrido guionizado a archivo. La lectura del fotograma N viaja por el anillo
+// de PBOs mientras la GPU ya trabaja en los siguientes, así que el ritmo lo marca el render.
+// Si hay una reproducción activa, la cámara la controla el registro de entrada en vez de la trayectoria.
+int runOfflineRender(const AppOptions& options, const SceneResources& scene, int width, int height,
+                     ReplaySession* replay) {
+    CameraPath path = CameraPath::defaultFlythrough();
+    if (!options.cameraPathFile.empty() && !path.loadFromFile(options.cameraPathFile.c_str()))
+        return -1;
+
+    OffscreenTarget target;
+    if (!target.create(width, height, 8))
+        return -1;
+    PboReadbackRing readback;
+    readback.create(width, height, options.readbackSlots);
+    FrameWriter writer(options.format, options.output, width, height, options.offlineFps);
+    glResources.report(std::cout);
+
+    auto start = std::chrono::steady_clock::now();
+    double renderSeconds = 0.0; // Tiempo de CPU dedicado a emitir el render (sin esperas de lectura)
+    bool failed = false;        // Algún fotograma no se pudo leer de la GPU
+    for (int frame = 0; frame < options.offlineFrames; ++frame) {
+        if (replay) {
+            replay->step();
+        } else {
+            float t = static_cast<float>(frame) / options.offlineFps;
+            path.sample(std::min(t, path.duration()), cameraPos, cameraFront);
+        }
+
+        auto renderStart = std::chrono::steady_clock::now();
+        glTrace.beginFrame();
+        scene.frameArena->reset();
+        scene.store->updateTransforms();
+        target.bindForRender();
+        if (scene.terrain)
+            scene.terrain->update(cameraPos, true); // Sin baldosas a medio cargar: el mismo video en cada ejecución
+        if (scene.particles)
+            scene.particles->update(1.0f / options.offlineFps); // Paso fijo: el mismo video en cada ejecución
+        drawScene(scene);
+        target.resolve();
+        renderSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - renderStart).count();
+
+        // Si el anillo está lleno hay que liberar el fotograma más antiguo antes de reutilizarlo;
+        // si no se puede, el fotograma se perdió y el recorrido quedaría incompleto
+        if (readback.full()) {
+            CapturedFrame captured = writer.acquire();
+            if (readback.collect(captured, true) != ReadbackStatus::Ready) {
+                failed = true;
+                break;
+            }
+            writer.push(std::move(captured));
+        }
+        readback.submit(frame);
+
+        // Recoger sin bloquear lo que la GPU ya haya terminado
+        ReadbackStatus status = ReadbackStatus::Ready;
+        while (!readback.empty()) {
+            CapturedFrame captured = writer.acquire();
+            status = readback.collect(captured, false);
+            if (status != ReadbackStatus::Ready)
+                break;
+            writer.push(std::move(captured));
+        }
+        glTrace.endFrame(false);
+        if (status == ReadbackStatus::Error) {
+            failed = true;
+            break;
+        }
+    }
+    while (!failed && !readback.empty()) {
+        CapturedFrame captured = writer.acquire();
+        if (readback.collect(captured, true) != ReadbackStatus::Ready)
+            failed = true;
+        else
+            writer.push(std::move(captured));
+    }
+    double readbackSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    writer.finish();
+    double totalSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    // Un fotograma perdido en la lectura o en la escritura deja el recorrido incompleto
+    if (failed || writer.framesWritten() != options.offlineFrames) {
+        std::cerr << "Render offline interrumpido: " << writer.framesWritten() << " de " << options.offlineFrames
+                  << " fotogramas escritos en " << options.output << std::endl;
+        readback.destroy();
+        target.destroy();
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        return -1;
+    }
+
+    int frames = options.offlineFrames;
+    std::cout << "Render offline: " << frames << " fotogramas de " << width << "x" << height << std::endl;
+    std::cout << "  render + lectura: " << frames / readbackSeconds << " fps"
+              << " (emisión del render: " << frames / renderSeconds << " fps)" << std::endl;
+    std::cout << "  incluyendo escritura a disco: " << frames / totalSeconds << " fps, "
+              << writer.framesWritten() << " fotogramas escritos en " << options.output << std::endl;
+
+    if (replay)
+        replay->report();
+    scene.recorder->report(std::cout);
+    if (scene.overdraw)
+        scene.overdraw->report(std::cout);
+    if (scene.terrain)
+        scene.terrain->report(std::cout);
+
+    readback.destroy();
+    target.destroy();
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    return 0;
+}
+
+// Compara el costo de GPU de la escena con Phong por fragmento y con el lightmap horneado,
+// renderizando sin MSAA a un FBO para medir solo el sombreado.
+int runLightmapBenchmark(const SceneResources& scene, unsigned int phongProgram, int width, int height) {
+    OffscreenTarget target;
+    if (!target.create(width, height, 1))
+        return -1;
+    unsigned int query;
+    glGenQueries(1, &query);
+    const int frames = 60;
+    double gpuMs[2] = { 0.0, 0.0 };
+    // El primer par de fotogramas compila y sube recursos en el driver; no se cuenta
+    const int warmup = 2;
+    for (int frame = -warmup; frame < 2 * frames; ++frame) {
+        // Alternar los dos programas para que ambos vean las mismas condiciones del driver
+        bool baked = (frame + warmup) % 2 == 1;
+        SceneResources variant = scene;
+        variant.shaderProgram = baked ? scene.shaderProgram : phongProgram;
+        variant.lightmapTexture = baked ? scene.lightmapTexture : 0;
+        scene.frameArena->reset();
+        target.bindForRender();
+        glBeginQuery(GL_TIME_ELAPSED, query);
+        drawScene(variant);
+        glEndQuery(GL_TIME_ELAPSED);
+        GLuint64 elapsed = 0;
+        glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsed);
+        if (frame >= 0)
+            gpuMs[baked] += elapsed / 1e6;
+    }
+    glDeleteQueries(1, &query);
+    target.destroy();
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    double phong = gpuMs[0] / frames, baked = gpuMs[1] / frames;
+    std::cout << "Costo de GPU por fotograma a " << width << "x" << height << " (" << frames << " fotogramas)" << std::endl;
+    std::cout << "  Phong por fragmento: " << phong << " ms" << std::endl;
+    std::cout << "  lightmap + especular: " << baked << " ms (" << 100.0 * (1.0 - baked / phong) << " % menos)" << std::endl;
+    return 0;
+}
+
+// Mide la grabación paralela y el envío de la lista de dibujo con escenas cada vez más grandes
+// (copias de los triángulos repartidas frente a la cámara) y con 1, 2, 4... hilos hasta maxThreads.
+int runCommandBenchmark(const SceneResources& base, unsigned int triangleVAO, int triangleCount, int maxEntities,
+                        unsigned maxThreads) {
+    OffscreenTarget target;
+    if (!target.create(640, 360, 1)) // Resolución baja: interesa el costo de CPU, no el de rasterizar
+        return -1;
+    unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+    maxThreads = std::max(1u, maxThreads);
+    std::vector<unsigned> threadCounts;
+    for (unsigned t = 1; t < maxThreads; t *= 2)
+        threadCounts.push_back(t);
+    threadCounts.push_back(maxThreads);
+    std::vector<int> sizes;
+    for (int n : { maxEntities / 100, maxEntities / 10, maxEntities })
+        if (n > 0 && (sizes.empty() || n != sizes.back()))
+            sizes.push_back(n);
+
+    const int frames = 20, warmup = 3;
+    std::mt19937 rng(99);
+    std::uniform_real_distribution<float> across(-20.0f, 20.0f), height(-1.0f, 3.0f), depth(-40.0f, -2.0f);
+    std::cout << "Lista de dibujo con buffers de comandos (" << frames << " fotogramas, " << cores << " núcleos)" << std::endl;
+    for (int entities : sizes) {
+        SceneStore store;
+        Entity root = store.createEntity();
+        for (int i = 0; i < entities; ++i) {
+            Entity e = store.createEntity(root);
+            store.setLocalPosition(e, glm::vec3(across(rng), height(rng), depth(rng)));
+            int first = 3 * (i % triangleCount);
+            store.addMesh(e, triangleVAO, first, 3, glm::vec3(-0.5f), glm::vec3(0.5f));
+        }
+        store.updateTransforms();
+        // La arena se dimensiona de entrada para no medir su crecimiento
+        FrameArena arena(static_cast<size_t>(entities) * (base.recorder->uniformStride + 4 * sizeof(DrawCommand)) + 64 * 1024);
+
+        for (unsigned threads : threadCounts) {
+            ParallelDrawRecorder recorder(threads);
+            recorder.create();
+            SceneResources scene = base;
+            scene.store = &store;
+            scene.frameArena = &arena;
+            scene.recorder = &recorder;
+            for (int frame = 0; frame < warmup + frames; ++frame) {
+                if (frame == warmup)
+                    recorder.recordSeconds = recorder.submitSeconds = 0.0, recorder.frames = 0;
+                arena.reset();
+                target.bindForRender();
+                drawScene(scene);
+                glFinish(); // Que la GPU no acumule trabajo entre fotogramas medidos
+            }
+            std::cout << "  " << entities << " entidades, " << threads << " hilos: grabación "
+                      << recorder.recordSeconds / frames * 1e3 << " ms, envío " << recorder.submitSeconds / frames * 1e3
+                      << " ms por fotograma" << std::endl;
+            recorder.destroy();
+        }
+    }
+    target.destroy();
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    return 0;
+}
+
+// Tiempos de fotograma y sobredibujo con y sin pre-pase de profundidad y orden de adelante hacia
+// atrás. Se mide la escena de la ventana y una pila de copias de los triángulos frente a la
+// cámara, donde muchos fragmentos quedan tapados.
+int runPrepassBenchmark(const SceneResources& base, unsigned int depthProgram, unsigned int triangleVAO, int triangleCount,
+                        unsigned int groundVAO, int stacked, int width, int height) {
+    OffscreenTarget target;
+    if (!target.create(width, height, 1))
+        return -1;
+    OverdrawCounter counter;
+    counter.create();
+    unsigned int query;
+    glGenQueries(1, &query);
+
+    SceneStore stack;
+    Entity root = stack.createEntity();
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> across(-3.0f, 3.0f), elevation(-1.0f, 2.0f), depth(-25.0f, -2.0f);
+    for (int i = 0; i < stacked; ++i) {
+        Entity e = stack.createEntity(root);
+        stack.setLocalPosition(e, glm::vec3(across(rng), elevation(rng), depth(rng)));
+        stack.setLocalScale(e, glm::vec3(2.0f));
+        stack.addMesh(e, triangleVAO, 3 * (i % triangleCount), 3, glm::vec3(-0.5f), glm::vec3(0.5f));
+    }
+    Entity ground = stack.createEntity(root);
+    stack.addMesh(ground, groundVAO, 0, 6, glm::vec3(-100.0f, -1.0f, -100.0f), glm::vec3(100.0f, -1.0f, 100.0f));
+    stack.updateTransforms();
+    FrameArena arena(static_cast<size_t>(stacked + 1) * (base.recorder->uniformStride + 4 * sizeof(DrawCommand) + 8) + 64 * 1024);
+
+    struct Variant {
+        const char* name;
+        bool prepass, sorted;
+    };
+    const Variant variants[] = { { "orden del arreglo", false, false },
+                                 { "adelante hacia atrás", false, true },
+                                 { "pre-pase", true, false },
+                                 { "pre-pase + adelante hacia atrás", true, true } };
+    const int variantCount = sizeof(variants) / sizeof(variants[0]);
+    const int frames = 60, warmup = 2;
+    std::cout << "Pre-pase de profundidad a " << width << "x" << height << " (" << frames << " fotogramas)" << std::endl;
+    for (SceneStore* store : { base.store, &stack }) {
+        std::cout << "  " << (store == base.store ? "escena de la ventana" : "pila de triángulos") << ", "
+                  << store->meshPool().size() << " objetos:" << std::endl;
+        auto configure = [&](const Variant& variant) {
+            SceneResources scene = base;
+            scene.store = store;
+            scene.frameArena = &arena;
+            scene.depthProgram = variant.prepass ? depthProgram : 0;
+            scene.frontToBack = variant.sorted;
+            return scene;
+        };
+        double gpuMs[variantCount] = {}, frameMs[variantCount] = {}, overdraw[variantCount] = {};
+        for (int v = 0; v < variantCount; ++v) {
+            SceneResources scene = configure(variants[v]);
+            scene.overdraw = &counter;
+            counter.reset();
+            arena.reset();
+            target.bindForRender();
+            drawScene(scene);
+            overdraw[v] = counter.average();
+        }
+        // Las variantes se alternan fotograma a fotograma para que todas vean el mismo estado del driver
+        for (int frame = -warmup; frame < frames; ++frame) {
+            for (int v = 0; v < variantCount; ++v) {
+                SceneResources scene = configure(variants[v]);
+                arena.reset();
+                glFinish();
+                auto start = std::chrono::steady_clock::now();
+                target.bindForRender();
+                glBeginQuery(GL_TIME_ELAPSED, query);
+                drawScene(scene);
+                glEndQuery(GL_TIME_ELAPSED);
+                glFinish();
+                double wallMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+                GLuint64 elapsed = 0;
+                glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsed);
+                if (frame >= 0) {
+                    gpuMs[v] += elapsed / 1e6;
+                    frameMs[v] += wallMs;
+                }
+            }
+        }
+        for (int v = 0; v < variantCount; ++v)
+            std::cout << "    " << variants[v].name << ": GPU " << gpuMs[v] / frames << " ms, fotograma "
+                      << frameMs[v] / frames << " ms, sobredibujo " << overdraw[v] << std::endl;
+    }
+    glDeleteQueries(1, &query);
+    counter.destroy();
+    target.destroy();
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    return 0;
+}
+
+// Costo de dibujar 1, 2, 4 y 6 vistas de una escena con N entidades: repitiendo la grabación,
+// los uniforms y los dibujos en una pasada por vista, o en una sola pasada instanciada por
+// viewports, por capas o con geometry shader. La emisión en la CPU debería quedar plana.
+int runMultiViewBenchmark(const SceneResources& base, unsigned int triangleVAO, int triangleCount, int entities,
+                          int width, int height) {
+    OffscreenTarget target;
+    if (!target.create(width, height, 1))
+        return -1;
+    SceneStore store;
+    Entity root = store.createEntity();
+    std::mt19937 rng(5);
+    std::uniform_real_distribution<float> across(-20.0f, 20.0f), elevation(-1.0f, 3.0f), depth(-20.0f, 20.0f);
+    for (int i = 0; i < entities; ++i) {
+        Entity e = store.createEntity(root);
+        store.setLocalPosition(e, glm::vec3(across(rng), elevation(rng), depth(rng)));
+        int first = 3 * (i % triangleCount);
+        store.addMesh(e, triangleVAO, first, 3, glm::vec3(-0.5f), glm::vec3(0.5f));
+    }
+    store.updateTransforms();
+    FrameArena arena(static_cast<size_t>(entities) * (base.recorder->uniformStride + 4 * sizeof(DrawCommand)) + 64 * 1024);
+    SceneResources scene = base;
+    scene.store = &store;
+    scene.frameArena = &arena;
+
+    struct Variant {
+        const char* name;
+        MultiViewRouting routing;
+        bool geometryShader;
+        bool passPerView;
+    };
+    const Variant variants[] = {
+        { "una pasada por vista", MultiViewRouting::Viewports, false, true },
+        { "una pasada, viewports", MultiViewRouting::Viewports, false, false },
+        { "una pasada, capas", MultiViewRouting::Layers, false, false },
+        { "una pasada, geometry shader", MultiViewRouting::Viewports, true, false },
+    };
+    const int frames = 10, warmup = 2;
+    std::cout << "Vistas múltiples con " << entities << " entidades a " << width << "x" << height << " (" << frames
+              << " fotogramas)" << std::endl;
+    for (int views : { 1, 2, 4, 6 }) {
+        std::cout << "  " << views << (views == 1 ? " vista" : " vistas") << ":" << std::endl;
+        for (const Variant& variant : variants) {
+            MultiViewSettings settings;
+            settings.count = views;
+            settings.routing = variant.routing;
+            settings.geometryShader = variant.geometryShader;
+            MultiView multiView;
+            if (!multiView.create(settings, width, height, bindObjectBlock))
+                continue;
+            scene.multiView = &multiView;
+            int passes = variant.passPerView ? views : 1;
+            double emitSeconds = 0.0, frameSeconds = 0.0;
+            for (int frame = 0; frame < warmup + frames; ++frame) {
+                glFinish();
+                auto start = std::chrono::steady_clock::now();
+                target.bindForRender();
+                for (int pass = 0; pass < passes; ++pass) {
+                    arena.reset();
+                    multiView.selectPass(variant.passPerView ? pass : 0, variant.passPerView ? 1 : 0);
+                    drawScene(scene);
+                }
+                auto emitted = std::chrono::steady_clock::now();
+                glFinish();
+                if (frame >= warmup) {
+                    emitSeconds += std::chrono::duration<double>(emitted - start).count();
+                    frameSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+                }
+            }
+            std::cout << "    " << variant.name << ": emisión en la CPU " << emitSeconds / frames * 1e3 << " ms ("
+                      << static_cast<size_t>(entities) * passes << " dibujos), fotograma " << frameSeconds / frames * 1e3
+                      << " ms" << std::endl;
+            multiView.destroy();
+        }
+    }
+    target.destroy();
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    return 0;
+}
+
+// Partículas por segundo de la simulación en la GPU con N/100, N/10 y N partículas, con compute
+// shader (si hay OpenGL 4.3) y con transform feedback, más el costo de dibujarlas.
+int runParticleBenchmark(const SceneResources& base, int maxParticles, int width, int height) {
+    OffscreenTarget target;
+    if (!target.create(width, height, 1))
+        return -1;
+    std::vector<bool> modes;
+    if (GLEW_VERSION_4_3)
+        modes.push_back(false);
+    modes.push_back(true);
+    std::vector<int> sizes;
+    for (int n : { maxParticles / 100, maxParticles / 10, maxParticles })
+        if (n > 0 && (sizes.empty() || n != sizes.back()))
+            sizes.push_back(n);
+
+    // Segundos para repetir work() steps veces, entre dos glFinish. Cada repetición emite una sola
+    // llamada de simulación o de dibujo, así que el tiempo es prácticamente el de la GPU.
+    auto measure = [](int steps, const std::function<void()>& work) {
+        glFinish();
+        auto start = std::chrono::steady_clock::now();
+        for (int step = 0; step < steps; ++step)
+            work();
+        glFinish();
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    };
+
+    const int steps = 30, draws = 10;
+    glm::mat4 view = glm::lookAt(cameraPos, cameraPos + cameraFront, cameraUp);
+    target.bindForRender();
+    std::cout << "Partículas en la GPU (" << steps << " pasos de simulación, " << draws << " dibujos a " << width << "x"
+              << height << ")" << std::endl;
+    for (bool feedback : modes) {
+        for (int count : sizes) {
+            ParticleSettings settings;
+            settings.count = static_cast<size_t>(count);
+            settings.transformFeedback = feedback;
+            ParticleSystem particles;
+            if (!particles.create(settings))
+                continue;
+            // Los primeros pasos escalonan los nacimientos; se simula un rato para medir el
+            // régimen estable, con la mayoría de las partículas vivas
+            for (int step = 0; step < 120; ++step)
+                particles.update(1.0f / 60.0f);
+
+            double simSeconds = measure(steps, [&] { particles.update(1.0f / 60.0f); });
+            double drawSeconds = measure(draws, [&] {
+                glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+                setPhongLighting(particles.useRenderProgram(view, base.projection), base);
+                particles.draw();
+            });
+            std::cout << "  " << (feedback ? "transform feedback" : "compute shader") << ", " << count
+                      << " partículas: simulación " << simSeconds / steps * 1e3 << " ms por paso ("
+                      << count * static_cast<double>(steps) / simSeconds / 1e6 << " millones de partículas/s), dibujo "
+                      << drawSeconds / draws * 1e3 << " ms" << std::endl;
+            particles.destroy();
+        }
+    }
+    target.destroy();
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    return 0;
+}
+
+// Bucle de baja latencia (--low-latency). GLFW solo entrega eventos en el hilo principal, así
+// que ese hilo pasa a ser el de entrada: procesa los eventos y muestrea teclas y cursor a
+// kInputSampleHz, mientras el render corre en un hilo propio con el contexto. La cámara avanza
+// con paso fijo y se vuelve a fijar con la entrada más reciente justo antes del envío (el latch
+// tardío de drawScene). betweenFrames corre en el hilo de render entre fotogramas.
+int runLowLatencyLoop(GLFWwindow* window, SceneResources& scene, const AppOptions& options,
+                      const std::function<void()>& betweenFrames) {
+    LatencyLog latencyLog;
+    if (!latencyLog.open(options.latencyLogFile))
+        return -1;
+    SimulationClock clock(1.0 / kSimulationHz);
+    InputSampler sampler;
+    FrameLimiter limiter(options.frameLimit);
+    std::atomic<bool> running(true);
+
+    // Solo el hilo de render toca la cámara: aplica el cursor más reciente y simula los pasos
+    // fijos que tocan hasta ahora con las teclas más recientes
+    auto latchInput = [&] {
+        InputSample input = sampler.take();
+        if (input.hasCursor)
+            rotateCamera(input.cursorX, input.cursorY);
+        MovementKeys keys;
+        keys.forward = input.keys & kInputForward;
+        keys.backward = input.keys & kInputBackward;
+        keys.left = input.keys & kInputLeft;
+        keys.right = input.keys & kInputRight;
+        int steps = clock.advance();
+        for (int s = 0; s < steps; ++s)
+            moveCamera(keys, static_cast<float>(clock.step()));
+        latencyLog.consume(input, steps);
+    };
+    scene.latchCamera = [&] {
+        latchInput();
+        latencyLog.markSubmit(clock.now());
+    };
+
+    glfwMakeContextCurrent(nullptr);
+    std::thread renderThread([&] {
+        glfwMakeContextCurrent(window);
+        if (limiter.active())
+            glfwSwapInterval(0); // El ritmo lo marca el limitador y no el vsync
+        double previousFrame = clock.now();
+        while (running) {
+            limiter.wait(clock);
+            glTrace.beginFrame();
+            scene.frameArena->reset();
+            betweenFrames();
+
+            double frameStart = clock.now();
+            double frameSeconds = frameStart - previousFrame;
+            previousFrame = frameStart;
+
+            // La cámara del comienzo del fotograma sirve para el streaming y la selección de LOD;
+            // la que se dibuja sale del latch tardío
+            latchInput();
+            scene.store->updateTransforms();
+            if (scene.particles)
+                scene.particles->update(static_cast<float>(std::min(frameSeconds, 0.05)));
+            if (scene.terrain)
+                scene.terrain->update(cameraPos);
+            drawScene(scene);
+            glfwSwapBuffers(window);
+            glTrace.endFrame(true);
+            latencyLog.endFrame(frameStart, frameSeconds);
+        }
+        glfwMakeContextCurrent(nullptr);
+    });
+
+    // Hilo de entrada: muestreo a ritmo fijo, independiente del ritmo de los fotogramas
+    auto tick = std::chrono::duration_cast<LatencyClock::duration>(std::chrono::duration<double>(1.0 / kInputSampleHz));
+    auto nextSample = LatencyClock::now();
+    while (running) {
+        glfwPollEvents();
+        uint32_t keys = 0;
+        if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
+            keys |= kInputForward;
+        if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
+            keys |= kInputBackward;
+        if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
+            keys |= kInputLeft;
+        if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
+            keys |= kInputRight;
+        double cursorX, cursorY;
+        glfwGetCursorPos(window, &cursorX, &cursorY);
+        sampler.publish(keys, cursorX, cursorY, clock.now());
+        if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS || glfwWindowShouldClose(window))
+            running = false;
+
+        // Si el muestreo se atrasa (la ventana se arrastró, por ejemplo), se retoma desde ahora
+        nextSample += tick;
+        if (nextSample < LatencyClock::now())
+            nextSample = LatencyClock::now();
+        std::this_thread::sleep_until(nextSample);
+    }
+    renderThread.join();
+    glfwMakeContextCurrent(window);
+    scene.latchCamera = nullptr;
+    latencyLog.report(std::cout, clock, sampler.sampleCount(), clock.now());
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    AppOptions options;
+    if (!parseOptions(argc, argv, options))
+        return -1;
+    bool offline = options.offlineFrames > 0;
+
+    // Los benchmarks de CPU no necesitan ventana ni contexto de OpenGL
+    if (options.benchTransforms > 0) {
+        runTransformBenchmark(options.benchTransforms);
+        return 0;
+    }
+    if (options.benchBvh > 0) {
+        runBvhBenchmark(options.benchBvh);
+        return 0;
+    }
+    if (!options.bakeFile.empty())
+        return runBake(options.bakeFile, options.bakeSamples);
+    if (options.benchBake > 0) {
+        runBakeScaling(options.benchBake);
+        return 0;
+    }
+    if (!options.makeTerrainDir.empty())
+        return writeTerrainTiles(options.makeTerrainDir, options.makeTerrainTiles) ? 0 : -1;
+
+    ReplaySession replay;
+    bool replaying = !options.replayFile.empty();
+    if (replaying && !replay.load(options.replayFile.c_str()))
+        return -1;
+    const uint32_t recordStepMicros = 16667; // Paso fijo de simulación al grabar (60 Hz)
+    InputRecorder recorder(recordStepMicros);
+    if (!options.recordFile.empty())
+        inputRecorder = &recorder;
+
     // Inicializar GLFW
     if (!glfwInit()) {
         std::cerr << "No se pudo inicializar GLFW" << std::endl;
@@ -165,6 +1904,11 @@ int main() {
 
     // Activar MSAA antes de crear la ventana
     glfwWindowHint(GLFW_SAMPLES, 8); // Habilitar MSAA con 4 muestras
+    glfwWindowHint(GLFW_STENCIL_BITS, 8); // El contador de sobredibujo cuenta en el stencil
+
+    // En modo offline la ventana solo aporta el contexto; se renderiza a un FBO propio
+    if (offline)
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
 
     // Crear una ventana de 1920x1080 píxeles
     GLFWwindow* window = glfwCreateWindow(1920, 1080, "Escena con Triángulos Texturizados y Coloreados", NULL, NULL);
@@ -175,7 +1919,12 @@ int main() {
     }
 
     glfwMakeContextCurrent(window);
-    glfwSetCursorPosCallback(window, mouse_callback); // Configurar el callback para el movimiento del ratón
+    // En reproducción la cámara solo la mueve el registro; en baja latencia el cursor lo muestrea
+    // el hilo de entrada
+    if (!replaying && !options.lowLatency) {
+        glfwSetCursorPosCallback(window, mouse_callback); // Configurar el callback para el movimiento del ratón
+        glfwSetKeyCallback(window, key_callback);
+    }
     glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED); // Ocultar y capturar el cursor
 
     // Inicializar GLEW
@@ -184,126 +1933,22 @@ int main() {
         return -1;
     }
 
+    // La captura empieza antes de crear recursos para que la traza pueda recrearlos
+    if (!options.captureFile.empty())
+        glTrace.start(options.captureFile, 1920, 1080, 8, options.captureFrames);
+
     // Habilitar Multisampling en OpenGL
     glEnable(GL_MULTISAMPLE); // Activar MSAA
 
     glEnable(GL_DEPTH_TEST); // Habilitar el buffer de profundidad desde el inicio para Phong Shading
 
-    // Definir las coordenadas de los vértices de los triángulos, incluyendo las normales y los colores
-    float vertices[] = {
-        // Primer triángulo - Brillante
-        // posiciones         // normales           // colores
-        -0.5f, -0.5f, 0.0f,    0.0f, 0.0f, 1.0f,    1.0f, 0.0f, 0.0f,  // Rojo
-        0.5f, -0.5f, 0.0f,    0.0f, 0.0f, 1.0f,    0.0f, 1.0f, 0.0f,  // Verde
-        0.0f,  0.5f, 0.0f,    0.0f, 0.0f, 1.0f,    0.0f, 0.0f, 1.0f,  // Azul
-        
-        // Segundo triángulo - Textura como cemento
-        // posiciones         // normales           // colores
-        -0.5f, -0.5f, -0.5f,   0.0f, 0.0f, 1.0f,    0.5f, 0.5f, 0.5f,  // Gris
-        0.5f, -0.5f, -0.5f,   0.0f, 0.0f, 1.0f,    0.5f, 0.5f, 0.5f,  // Gris
-        0.0f,  0.5f, -0.5f,   0.0f, 0.0f, 1.0f,    0.5f, 0.5f, 0.5f,  // Gris
-
-        // Tercer triángulo - Mate, como cemento
-        // posiciones         // normales           // colores
-        -0.5f, -0.5f, 0.5f,    0.0f, 0.0f, 1.0f,    0.6f, 0.6f, 0.6f,  // Cemento
-        0.5f, -0.5f, 0.5f,    0.0f, 0.0f, 1.0f,    0.6f, 0.6f, 0.6f,  // Cemento
-        0.0f,  0.5f, 0.5f,    0.0f, 0.0f, 1.0f,    0.6f, 0.6f, 0.6f,  // Cemento
-
-        // Cuarto triángulo - Brillante, metálico
-        // posiciones         // normales           // colores
-        1.0f, -0.5f, 0.0f,    0.0f, 0.0f, 1.0f,    0.8f, 0.8f, 0.8f,  // Plata
-        1.5f, -0.5f, 0.0f,    0.0f, 0.0f, 1.0f,    0.8f, 0.8f, 0.8f,  // Plata
-        1.25f, 0.5f, 0.0f,    0.0f, 0.0f, 1.0f,    0.8f, 0.8f, 0.8f,  // Plata
-
-        // Quinto triángulo - Amarillo brillante
-        -1.0f, -0.5f, 0.0f,    0.0f, 0.0f, 1.0f,    1.0f, 1.0f, 0.0f,  // Amarillo
-        -0.5f, -0.5f, 0.0f,    0.0f, 0.0f, 1.0f,    1.0f, 1.0f, 0.0f,  // Amarillo
-        -0.75f, 0.5f, 0.0f,    0.0f, 0.0f, 1.0f,    1.0f, 1.0f, 0.0f,  // Amarillo
-
-        // Sexto triángulo - Verde claro
-        1.0f,  1.0f, -0.5f,   0.0f, 0.0f, 1.0f,    0.0f, 1.0f, 0.5f,  // Verde claro
-        1.5f,  1.0f, -0.5f,   0.0f, 0.0f, 1.0f,    0.0f, 1.0f, 0.5f,  // Verde claro
-        1.25f, 1.5f, -0.5f,   0.0f, 0.0f, 1.0f,    0.0f, 1.0f, 0.5f,  // Verde claro
-
-        // Séptimo triángulo - Magenta
-        -1.5f, -1.0f, 0.5f,    0.0f, 0.0f, 1.0f,    1.0f, 0.0f, 1.0f,  // Magenta
-        -1.0f, -1.0f, 0.5f,    0.0f, 0.0f, 1.0f,    1.0f, 0.0f, 1.0f,  // Magenta
-        -1.25f, -0.5f, 0.5f,   0.0f, 0.0f, 1.0f,    1.0f, 0.0f, 1.0f,  // Magenta
-
-        // Octavo triángulo - Cyan
-        -2.0f,  1.0f, -1.0f,   0.0f, 0.0f, 1.0f,    0.0f, 1.0f, 1.0f,  // Cyan
-        -1.5f,  1.0f, -1.0f,   0.0f, 0.0f, 1.0f,    0.0f, 1.0f, 1.0f,  // Cyan
-        -1.75f, 1.5f, -1.0f,   0.0f, 0.0f, 1.0f,    0.0f, 1.0f, 1.0f,  // Cyan
-
-        // Noveno triángulo - Gris oscuro
-        0.0f, -1.0f, -1.0f,   0.0f, 0.0f, 1.0f,    0.3f, 0.3f, 0.3f,  // Gris oscuro
-        0.5f, -1.0f, -1.0f,   0.0f, 0.0f, 1.0f,    0.3f, 0.3f, 0.3f,  // Gris oscuro
-        0.25f, -0.5f, -1.0f,  0.0f, 0.0f, 1.0f,    0.3f, 0.3f, 0.3f,  // Gris oscuro
-
-        // Décimo triángulo - Azul cobalto
-        2.0f,  0.0f, 0.5f,    0.0f, 0.0f, 1.0f,    0.0f, 0.0f, 0.8f,  // Azul cobalto
-        2.5f,  0.0f, 0.5f,    0.0f, 0.0f, 1.0f,    0.0f, 0.0f, 0.8f,  // Azul cobalto
-        2.25f, 0.5f, 0.5f,    0.0f, 0.0f, 1.0f,    0.0f, 0.0f, 0.8f,  // Azul cobalto
-
-        // Undécimo triángulo - Verde oliva
-        -2.5f, -0.5f, 0.5f,    0.0f, 0.0f, 1.0f,    0.5f, 0.5f, 0.0f,  // Verde oliva
-        -3.0f, -0.5f, 0.5f,    0.0f, 0.0f, 1.0f,    0.5f, 0.5f, 0.0f,  // Verde oliva
-        -2.75f, 0.0f, 0.5f,    0.0f, 0.0f, 1.0f,    0.5f, 0.5f, 0.0f,  // Verde oliva
-
-        // Duodécimo triángulo - Lila pastel
-        -3.0f,  1.0f, -0.5f,   0.0f, 0.0f, 1.0f,    0.8f, 0.6f, 1.0f,  // Lila pastel
-        -2.5f,  1.0f, -0.5f,   0.0f, 0.0f, 1.0f,    0.8f, 0.6f, 1.0f,  // Lila pastel
-        -2.75f, 1.5f, -0.5f,   0.0f, 0.0f, 1.0f,    0.8f, 0.6f, 1.0f,  // Lila pastel
-
-        // Decimotercer triángulo - Naranja quemado
-        3.0f, -1.5f, 0.0f,    0.0f, 0.0f, 1.0f,    1.0f, 0.3f, 0.0f,  // Naranja quemado
-        3.5f, -1.5f, 0.0f,    0.0f, 0.0f, 1.0f,    1.0f, 0.3f, 0.0f,  // Naranja quemado
-        3.25f, -1.0f, 0.0f,   0.0f, 0.0f, 1.0f,    1.0f, 0.3f, 0.0f,  // Naranja quemado
-
-        // Decimocuarto triángulo - Azul claro
-        4.0f,  0.5f, 0.0f,    0.0f, 0.0f, 1.0f,    0.4f, 0.7f, 1.0f,  // Azul claro
-        4.5f,  0.5f, 0.0f,    0.0f, 0.0f, 1.0f,    0.4f, 0.7f, 1.0f,  // Azul claro
-        4.25f, 1.0f, 0.0f,    0.0f, 0.0f, 1.0f,    0.4f, 0.7f, 1.0f,  // Azul claro
-
-        // Decimoquinto triángulo - Rojo oscuro
-        -4.0f, -0.5f, -0.5f,   0.0f, 0.0f, 1.0f,    0.5f, 0.0f, 0.0f,  // Rojo oscuro
-        -4.5f, -0.5f, -0.5f,   0.0f, 0.0f, 1.0f,    0.5f, 0.0f, 0.0f,  // Rojo oscuro
-        -4.25f, 0.0f, -0.5f,   0.0f, 0.0f, 1.0f,    0.5f, 0.0f, 0.0f,  // Rojo oscuro
-
-        // Decimosexto triángulo - Rosa brillante
-        3.0f,  1.0f, 1.0f,    0.0f, 0.0f, 1.0f,    1.0f, 0.2f, 0.5f,  // Rosa brillante
-        3.5f,  1.0f, 1.0f,    0.0f, 0.0f, 1.0f,    1.0f, 0.2f, 0.5f,  // Rosa brillante
-        3.25f, 1.5f, 1.0f,    0.0f, 0.0f, 1.0f,    1.0f, 0.2f, 0.5f,  // Rosa brillante
-
-        // Decimoséptimo triángulo - Verde esmeralda
-        -3.0f, -1.0f, 1.5f,    0.0f, 0.0f, 1.0f,    0.0f, 0.8f, 0.4f,  // Verde esmeralda
-        -3.5f, -1.0f, 1.5f,    0.0f, 0.0f, 1.0f,    0.0f, 0.8f, 0.4f,  // Verde esmeralda
-        -3.25f, -0.5f, 1.5f,   0.0f, 0.0f, 1.0f,    0.0f, 0.8f, 0.4f,  // Verde esmeralda
-
-        // Decimooctavo triángulo - Azul marino
-        2.5f,  0.5f, -1.5f,   0.0f, 0.0f, 1.0f,    0.0f, 0.0f, 0.5f,  // Azul marino
-        3.0f,  0.5f, -1.5f,   0.0f, 0.0f, 1.0f,    0.0f, 0.0f, 0.5f,  // Azul marino
-        2.75f, 1.0f, -1.5f,   0.0f, 0.0f, 1.0f,    0.0f, 0.0f, 0.5f,  // Azul marino
-
-        // Decimonoveno triángulo - Amarillo dorado
-        -2.0f, -2.0f, 1.0f,    0.0f, 0.0f, 1.0f,    1.0f, 0.9f, 0.0f,  // Amarillo dorado
-        -1.5f, -2.0f, 1.0f,    0.0f, 0.0f, 1.0f,    1.0f, 0.9f, 0.0f,  // Amarillo dorado
-        -1.75f, -1.5f, 1.0f,   0.0f, 0.0f, 1.0f,    1.0f, 0.9f, 0.0f,  // Amarillo dorado
-
-        // Vigésimo triángulo - Blanco brillante
-        4.5f,  2.0f, 0.5f,    0.0f, 0.0f, 1.0f,    1.0f, 1.0f, 1.0f,  // Blanco brillante
-        5.0f,  2.0f, 0.5f,    0.0f, 0.0f, 1.0f,    1.0f, 1.0f, 1.0f,  // Blanco brillante
-        4.75f, 2.5f, 0.5f,    0.0f, 0.0f, 1.0f,    1.0f, 1.0f, 1.0f   // Blanco brillante
-        };
 
-    unsigned int VBO, VAO;
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
+    unsigned int VAO = trackedGenVertexArray("triángulos");
+    unsigned int VBO = trackedGenBuffer("triángulos");
 
     glBindVertexArray(VAO);
 
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+    trackedBufferData(GL_ARRAY_BUFFER, VBO, sizeof(vertices), vertices, GL_STATIC_DRAW);
 
     // Atributo de posición
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 9 * sizeof(float), (void*)0);
@@ -320,90 +1965,260 @@ int main() {
     // Crear el programa de shaders
     unsigned int shaderProgram = createShaderProgram("phong_vertex_shader.glsl", "phong_fragment_shader.glsl");
 
-    // Definir la posición y el color de la luz y de la cámara
-    glm::vec3 lightPos(5.0f, 10.0f, 10.0f); // Luz elevada para iluminar desde arriba
-    glm::vec3 lightColor(0.9f, 0.9f, 1.0f); // Luz ligeramente azulada
-    glm::vec3 lightDir(-0.2f, -1.0f, -0.3f); // Luz direccional descendente
-    glm::vec3 pointLightPos(2.0f, 1.0f, 1.0f);
-
     // Crear el plano base
     unsigned int groundVAO, groundVBO;
     createGroundPlane(groundVAO, groundVBO);
 
     glm::mat4 projection = glm::perspective(glm::radians(90.0f), 1920.0f / 1080.0f, 0.1f, 100.0f);
 
-    while (!glfwWindowShouldClose(window)) {
-        // Tiempo para calcular deltaTime
-        float currentFrame = glfwGetTime();
-        deltaTime = currentFrame - lastFrame;
-        lastFrame = currentFrame;
+    // Una entidad por triángulo más el plano base (salvo que lo reemplace el terreno)
+    SceneStore store;
+    buildSceneStore(store, vertices, sizeof(vertices) / (9 * sizeof(float)), VAO, options.terrainDir.empty() ? groundVAO : 0);
+
+    FrameArena frameArena(64 * 1024); // Se reinicia en cada iteración del bucle
+    unsigned recordThreads = options.recordThreads ? options.recordThreads : std::thread::hardware_concurrency();
+    ParallelDrawRecorder drawRecorder(recordThreads);
+    drawRecorder.create();
+    SceneResources scene = { &store, &frameArena, &drawRecorder, shaderProgram, projection, lightPos, lightColor, lightDir, pointLightPos };
+
+    // Iluminación horneada: el programa con lightmap reemplaza al Phong por fragmento
+    LightmapResources lightmap;
+    if (!options.lightmapFile.empty()) {
+        if (!lightmap.create(options.lightmapFile.c_str(), { VAO, groundVAO })) {
+            glfwTerminate();
+            return -1;
+        }
+        scene.shaderProgram = lightmap.program;
+        scene.lightmapTexture = lightmap.texture;
+    }
 
-        // Procesar entradas
-        processInput(window);
+    // Pre-pase de profundidad (con orden de adelante hacia atrás) y contador de sobredibujo
+    unsigned int depthProgram = 0;
+    if (options.depthPrepass || options.benchPrepass > 0)
+        depthProgram = createShaderProgram("depth_vertex_shader.glsl", "depth_fragment_shader.glsl");
+    if (options.depthPrepass) {
+        scene.depthProgram = depthProgram;
+        scene.frontToBack = true;
+    }
+    OverdrawCounter overdraw;
+    if (options.overdraw) {
+        overdraw.create();
+        scene.overdraw = &overdraw;
+    }
 
-        // Limpiar la pantalla
-        glClearColor(0.3f, 0.3f, 0.3f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    // Fuente de partículas frente a la cámara
+    ParticleSystem particles;
+    if (options.particles > 0) {
+        ParticleSettings settings;
+        settings.count = static_cast<size_t>(options.particles);
+        settings.transformFeedback = options.particlesFeedback;
+        if (!particles.create(settings)) {
+            glfwTerminate();
+            return -1;
+        }
+        scene.particles = &particles;
+    }
 
-        // Usar el programa de shaders
-        glUseProgram(shaderProgram);
+    // Terreno por baldosas leídas en segundo plano alrededor de la cámara
+    TerrainSystem terrain;
+    if (!options.terrainDir.empty()) {
+        TerrainSettings settings;
+        settings.directory = options.terrainDir;
+        settings.memoryCap = static_cast<size_t>(options.terrainCapMB) << 20;
+        if (!terrain.create(settings, createShaderProgram("terrain_vertex_shader.glsl", "phong_fragment_shader.glsl"))) {
+            glfwTerminate();
+            return -1;
+        }
+        scene.terrain = &terrain;
+    }
 
-        // Definir la matriz de vista basada en la posición de la cámara
-        glm::mat4 view = glm::lookAt(cameraPos, cameraPos + cameraFront, cameraUp);
+    // Varias vistas de la cámara en una sola pasada
+    MultiView multiView;
+    if (options.views > 0) {
+        MultiViewSettings settings;
+        settings.count = options.views;
+        settings.routing = options.viewsLayered ? MultiViewRouting::Layers : MultiViewRouting::Viewports;
+        settings.geometryShader = options.viewsGeometryShader;
+        if (!multiView.create(settings, 1920, 1080, bindObjectBlock)) {
+            glfwTerminate();
+            return -1;
+        }
+        scene.multiView = &multiView;
+    }
+    glResources.report(std::cout);
+
+    // Libera todo lo creado arriba; se usa en cada salida
+    auto releaseScene = [&]() {
+        glTrace.finish(); // Si la aplicación terminó antes de completar los fotogramas pedidos
+        lightmap.destroy();
+        overdraw.destroy();
+        trackedDeleteProgram(depthProgram);
+        particles.destroy();
+        terrain.destroy();
+        multiView.destroy();
+        drawRecorder.destroy();
+        trackedDeleteVertexArray(VAO);
+        trackedDeleteBuffer(VBO);
+        trackedDeleteVertexArray(groundVAO);
+        trackedDeleteBuffer(groundVBO);
+        trackedDeleteProgram(shaderProgram);
+        glResources.reportLeaks(std::cerr);
+    };
 
-        // Pasar las matrices de transformación al vertex shader
-        int viewLoc = glGetUniformLocation(shaderProgram, "view");
-        int projLoc = glGetUniformLocation(shaderProgram, "projection");
-        int modelLoc = glGetUniformLocation(shaderProgram, "model");
-        glm::mat4 model = glm::mat4(1.0f); // Matriz identidad
-        glUniformMatrix4fv(viewLoc, 1, GL_FALSE, glm::value_ptr(view));
-        glUniformMatrix4fv(projLoc, 1, GL_FALSE, glm::value_ptr(projection));
-        glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
+    if (options.benchCommands > 0) {
+        int result = runCommandBenchmark(scene, VAO, sizeof(vertices) / (27 * sizeof(float)), options.benchCommands,
+                                         drawRecorder.pool.threadCount());
+        releaseScene();
+        glfwTerminate();
+        return result;
+    }
 
-        // Pasar la posición, el color y la dirección de la luz al fragment shader
-        int lightPosLoc = glGetUniformLocation(shaderProgram, "lightPos");
-        glUniform3fv(lightPosLoc, 1, &lightPos[0]);
+    if (options.benchViews > 0) {
+        glfwSwapInterval(0);
+        int result = runMultiViewBenchmark(scene, VAO, sizeof(vertices) / (27 * sizeof(float)), options.benchViews, 1920, 1080);
+        releaseScene();
+        glfwTerminate();
+        return result;
+    }
+
+    if (options.benchParticles > 0) {
+        glfwSwapInterval(0);
+        int result = runParticleBenchmark(scene, options.benchParticles, 1920, 1080);
+        releaseScene();
+        glfwTerminate();
+        return result;
+    }
 
-        int lightColorLoc = glGetUniformLocation(shaderProgram, "lightColor");
-        glUniform3fv(lightColorLoc, 1, &lightColor[0]);
+    if (options.benchPrepass > 0) {
+        glfwSwapInterval(0);
+        int result = runPrepassBenchmark(scene, depthProgram, VAO, sizeof(vertices) / (27 * sizeof(float)), groundVAO,
+                                         options.benchPrepass, 1920, 1080);
+        releaseScene();
+        glfwTerminate();
+        return result;
+    }
 
-        int lightDirLoc = glGetUniformLocation(shaderProgram, "lightDir");
-        glUniform3fv(lightDirLoc, 1, glm::value_ptr(lightDir));
+    if (options.benchLightmap) {
+        glfwSwapInterval(0);
+        int result = runLightmapBenchmark(scene, shaderProgram, 1920, 1080);
+        releaseScene();
+        glfwTerminate();
+        return result;
+    }
 
-        int pointLightPosLoc = glGetUniformLocation(shaderProgram, "pointLightPos");
-        glUniform3fv(pointLightPosLoc, 1, glm::value_ptr(pointLightPos));
+    if (offline) {
+        glfwSwapInterval(0); // Sin vsync: el ritmo lo marca la GPU
+        int result = runOfflineRender(options, scene, 1920, 1080, replaying ? &replay : nullptr);
+        releaseScene();
+        glfwTerminate();
+        return result;
+    }
 
-        int viewPosLoc = glGetUniformLocation(shaderProgram, "viewPos");
-        glUniform3fv(viewPosLoc, 1, &cameraPos[0]);
+    // BVH de la escena para seleccionar con la cruz de la cámara
+    ScenePicker picker;
+    picker.build(store, { { VAO, vertices }, { groundVAO, groundVertices } });
+    scenePicker = &picker;
+
+    MovementKeys recordedKeys;   // Estado de WASD reconstruido a partir de los eventos grabados
+    uint32_t recordTick = 0;
+    double recordAccumulator = 0.0;
+    double recordStep = recordStepMicros / 1e6;
+
+    // Recarga del programa en uso al guardar sus shaders. Con vistas múltiples se dibuja con el
+    // programa de vistas, que comparte el fragment shader de Phong.
+    ShaderReloader shaderReloader(bindObjectBlock);
+    if (scene.multiView)
+        shaderReloader.adopt(multiView.programSlot(), multiView.shaderFiles(), MultiView::bindViewBlock);
+    else if (options.lightmapFile.empty())
+        shaderReloader.adopt(shaderProgram, "phong_vertex_shader.glsl", "phong_fragment_shader.glsl");
+    else
+        shaderReloader.adopt(lightmap.program, "lightmap_vertex_shader.glsl", "lightmap_fragment_shader.glsl");
+    shaderReloader.start();
+    double terrainTitleTime = 0.0;
+
+    // El cambio de programa ocurre entre fotogramas
+    auto swapReloadedProgram = [&] {
+        shaderReloader.update();
+        scene.shaderProgram = options.lightmapFile.empty() ? shaderProgram : lightmap.program;
+    };
+    if (options.lowLatency && runLowLatencyLoop(window, scene, options, swapReloadedProgram) != 0) {
+        shaderReloader.destroy();
+        releaseScene();
+        glfwTerminate();
+        return -1;
+    }
 
-        // Pasar las intensidades de los componentes de iluminación al fragment shader
-        glUniform1f(glGetUniformLocation(shaderProgram, "ambientStrength"), 0.2f);
-        glUniform1f(glGetUniformLocation(shaderProgram, "diffuseStrength"), 1.0f);
-        glUniform1f(glGetUniformLocation(shaderProgram, "specularStrength"), 0.5f);
+    while (!options.lowLatency && !glfwWindowShouldClose(window)) {
+        glTrace.beginFrame();
+        frameArena.reset();
 
-        // Pasar el color del objeto al fragment shader
-        glm::vec3 objectColor(1.0f, 0.5f, 0.3f); // Color base del objeto (naranja)
-        int objectColorLoc = glGetUniformLocation(shaderProgram, "objectColor");
-        glUniform3fv(objectColorLoc, 1, glm::value_ptr(objectColor));
+        swapReloadedProgram();
 
-        // Dibujar los triángulos
-        glBindVertexArray(VAO);
-        glDrawArrays(GL_TRIANGLES, 0, 60);
+        // Tiempo para calcular deltaTime
+        double currentFrame = glfwGetTime();
+        deltaTime = static_cast<float>(currentFrame - lastFrame);
+        lastFrame = currentFrame;
 
-        // Dibujar el plano base
-        glBindVertexArray(groundVAO);
-        glDrawArrays(GL_TRIANGLES, 0, 6);
+        // Procesar entradas
+        if (replaying) {
+            // Un paso fijo por fotograma: las mismas vistas en cada ejecución
+            if (!replay.step())
+                break;
+        } else if (inputRecorder) {
+            // Pasos fijos según el tiempo real; los eventos se sellan con el tick en que se aplican
+            recordAccumulator += deltaTime;
+            while (recordAccumulator >= recordStep) {
+                for (const InputEvent& event : recorder.beginTick(recordTick++))
+                    applyInputEvent(event, recordedKeys);
+                moveCamera(recordedKeys, static_cast<float>(recordStep));
+                recordAccumulator -= recordStep;
+            }
+        } else {
+            processInput(window);
+        }
+        if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+            glfwSetWindowShouldClose(window, true);
+
+        if (store.updateTransforms() > 0)
+            picker.refit(store);
+        if (scene.particles)
+            particles.update(std::min(deltaTime, 0.05f)); // Tras una pausa larga, no saltar de golpe
+        if (scene.terrain)
+            terrain.update(cameraPos);
+        drawScene(scene);
+
+        // Estado del terreno en el título de la ventana, una vez por segundo
+        if (scene.terrain && currentFrame - terrainTitleTime >= 1.0) {
+            terrainTitleTime = currentFrame;
+            std::ostringstream title;
+            title << "Terreno: " << terrain.residentTiles() << " baldosas, " << terrain.residentBytes() / (1024 * 1024.0)
+                  << " MB, " << terrain.frameVertices() << " vértices";
+            glfwSetWindowTitle(window, title.str().c_str());
+        }
 
         // Intercambiar buffers
         glfwSwapBuffers(window);
+        glTrace.endFrame(true);
         glfwPollEvents();
     }
 
+    if (replaying)
+        replay.report();
+    if (inputRecorder)
+        recorder.save(options.recordFile.c_str());
+    if (picker.picks > 0)
+        std::cout << "Selección con BVH: " << picker.picks << " consultas, " << picker.pickSeconds / picker.picks * 1e6
+                  << " us en promedio" << std::endl;
+    drawRecorder.report(std::cout);
+    overdraw.report(std::cout);
+    terrain.report(std::cout);
+    shaderReloader.destroy();
+
     // Limpiar los recursos
-    glDeleteVertexArrays(1, &VAO);
-    glDeleteBuffers(1, &VBO);
-    glDeleteVertexArrays(1, &groundVAO);
-    glDeleteBuffers(1, &groundVBO);
+    glResources.report(std::cout);
+    releaseScene();
+    std::cout << "Arena por fotograma: máximo " << frameArena.highWaterBytes() << " de "
+              << frameArena.capacityBytes() << " bytes" << std::endl;
     glfwTerminate();
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,269 @@
+#pragma once
+// Varias vistas de la escena en una sola pasada (estéreo, pantalla dividida o las 6 caras de un
+// cubo). Cada dibujo se emite una vez con N instancias; la instancia i toma su matriz del bloque
+// de uniforms ViewBlock y se envía a su viewport (gl_ViewportIndex) o a la capa i de un
+// framebuffer de capas (gl_Layer). Así la grabación, la subida de uniforms y las llamadas de
+// dibujo no crecen con el número de vistas.
+//  - Con ARB_shader_viewport_layer_array el vertex shader elige la vista; si no, lo hace un
+//    geometry shader de paso.
+//  - Con capas, al terminar se copia cada capa a su recuadro del framebuffer de destino.
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include "frame_memory.h"
+#include "shader_reload.h"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Carga y compilación de shaders (main6.cpp). prefix se inserta después de la línea #version.
+std::string loadShaderSource(const char* filepath);
+unsigned int compileShader(unsigned int type, const char* path, const std::string& prefix);
+
+const int kMaxViews = 6;
+const unsigned int kViewBlockBinding = 1;   // ObjectBlock usa el 0
+const float kStereoEyeSeparation = 0.065f;  // Distancia entre los ojos en la vista estéreo
+
+enum class MultiViewRouting {
+    Viewports, // Recuadros de un mismo framebuffer
+    Layers     // Capas de una textura array; después se copian a los recuadros
+};
+
+struct MultiViewSettings {
+    int count = 2;                  // 2 = estéreo, 6 = cubo, otro = pantalla dividida alrededor de la cámara
+    MultiViewRouting routing = MultiViewRouting::Viewports;
+    bool geometryShader = false;    // Forzar el enrutamiento con geometry shader
+    float fovDegrees = 90.0f;
+    float nearPlane = 0.1f, farPlane = 100.0f;
+};
+
+class MultiView {
+public:
+    // onLinked enlaza ObjectBlock como en el resto de los programas de la escena.
+    bool create(const MultiViewSettings& viewSettings, int width, int height, const std::function<void(unsigned int)>& onLinked) {
+        settings = viewSettings;
+        targetWidth = width;
+        targetHeight = height;
+        settings.count = std::max(1, std::min(settings.count, kMaxViews));
+        if (!GLEW_VERSION_4_1) {
+            std::cerr << "Las vistas múltiples necesitan OpenGL 4.1 (arreglos de viewports)" << std::endl;
+            return false;
+        }
+        useGeometryShader = settings.geometryShader || !GLEW_ARB_shader_viewport_layer_array;
+        program = linkProgram();
+        if (!program)
+            return false;
+        onLinked(program);
+
+        // Recuadros en una grilla: 1x1, 2x1, 2x2 o 3x2
+        columns = settings.count == 1 ? 1 : settings.count <= 4 ? 2 : 3;
+        rows = (settings.count + columns - 1) / columns;
+        tileWidth = width / columns;
+        tileHeight = height / rows;
+        // Las caras del cubo son cuadradas; se centran en su recuadro
+        viewWidth = cube() ? std::min(tileWidth, tileHeight) : tileWidth;
+        viewHeight = cube() ? viewWidth : tileHeight;
+
+        viewBuffer = trackedGenBuffer("vistas (ViewBlock)");
+        trackedBufferData(GL_UNIFORM_BUFFER, viewBuffer, kMaxViews * sizeof(glm::mat4), nullptr, GL_DYNAMIC_DRAW);
+
+        if (settings.routing == MultiViewRouting::Layers) {
+            colorArray = createArray("vistas (color)", GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, 4);
+            depthArray = createArray("vistas (profundidad)", GL_DEPTH_COMPONENT24, GL_DEPTH_COMPONENT, GL_UNSIGNED_INT, 4);
+            layeredFramebuffer = trackedGenFramebuffer("vistas (capas)");
+            glBindFramebuffer(GL_FRAMEBUFFER, layeredFramebuffer);
+            glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, colorArray, 0);
+            glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, depthArray, 0);
+            bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+            layerFramebuffer = trackedGenFramebuffer("vistas (lectura de una capa)");
+            if (!complete) {
+                std::cerr << "El framebuffer de capas está incompleto" << std::endl;
+                destroy();
+                return false;
+            }
+        }
+        std::cout << "Vistas: " << settings.count << " en una pasada, "
+                  << (settings.routing == MultiViewRouting::Layers ? "por capas" : "por viewports") << " con "
+                  << (useGeometryShader ? "geometry shader" : "gl_ViewportIndex/gl_Layer en el vertex shader") << std::endl;
+        return true;
+    }
+
+    void destroy() {
+        trackedDeleteFramebuffer(layeredFramebuffer);
+        trackedDeleteFramebuffer(layerFramebuffer);
+        trackedDeleteTexture(colorArray);
+        trackedDeleteTexture(depthArray);
+        trackedDeleteBuffer(viewBuffer);
+        trackedDeleteProgram(program);
+    }
+
+    // Calcula las matrices de todas las vistas a partir de la cámara y las sube al bloque de vistas.
+    void setCamera(const glm::vec3& position, const glm::vec3& front, const glm::vec3& up) {
+        glm::mat4 projection = glm::perspective(glm::radians(settings.fovDegrees),
+                                                static_cast<float>(viewWidth) / viewHeight, settings.nearPlane, settings.farPlane);
+        glm::mat4 matrices[kMaxViews];
+        glm::vec3 right = glm::normalize(glm::cross(front, up));
+        for (int v = 0; v < settings.count; ++v) {
+            glm::vec3 eye = position, direction = front, viewUp = up;
+            if (settings.count == 2) {
+                eye += right * (v == 0 ? -0.5f : 0.5f) * kStereoEyeSeparation;
+            } else if (cube()) {
+                static const glm::vec3 directions[6] = { { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 } };
+                // Arriba en +Y para las caras laterales, así la grilla se lee derecha (un cubemap
+                // de textura usaría -Y)
+                static const glm::vec3 ups[6] = { { 0, 1, 0 }, { 0, 1, 0 }, { 0, 0, 1 }, { 0, 0, -1 }, { 0, 1, 0 }, { 0, 1, 0 } };
+                direction = directions[v];
+                viewUp = ups[v];
+            } else {
+                // Pantalla dividida: las vistas giran alrededor del eje vertical
+                float angle = glm::radians(360.0f * v / settings.count);
+                direction = std::cos(angle) * front + std::sin(angle) * right;
+            }
+            matrices[v] = projection * glm::lookAt(eye, eye + direction, viewUp);
+        }
+        glBindBuffer(GL_UNIFORM_BUFFER, viewBuffer);
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, settings.count * sizeof(glm::mat4), matrices);
+    }
+
+    // Vistas que cubre la próxima pasada. Por defecto todas; una pasada por vista sirve para
+    // comparar con el camino de siempre.
+    void selectPass(int first, int count) {
+        passFirst = first;
+        passCount = count;
+    }
+
+    // Variable con el programa de vistas y sus etapas, para que la recarga de shaders lo reemplace.
+    unsigned int& programSlot() { return program; }
+
+    std::vector<ShaderStageFile> shaderFiles() const {
+        std::vector<ShaderStageFile> files = {
+            { GL_VERTEX_SHADER, "multiview_vertex_shader.glsl", useGeometryShader ? "#define VIEW_FROM_GEOMETRY_SHADER\n" : "" },
+            { GL_FRAGMENT_SHADER, "phong_fragment_shader.glsl", "" }
+        };
+        if (useGeometryShader)
+            files.push_back({ GL_GEOMETRY_SHADER, "multiview_geometry_shader.glsl", "" });
+        return files;
+    }
+
+    // ViewBlock en su punto de enlace; ObjectBlock lo enlaza el dueño.
+    static void bindViewBlock(unsigned int linked) {
+        glUniformBlockBinding(linked, glGetUniformBlockIndex(linked, "ViewBlock"), kViewBlockBinding);
+    }
+
+    // Prepara el framebuffer y los viewports de la pasada y deja enlazado el programa de vistas.
+    unsigned int begin() {
+        glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &targetFramebuffer);
+        if (layeredFramebuffer)
+            glBindFramebuffer(GL_DRAW_FRAMEBUFFER, layeredFramebuffer);
+        for (int v = 0; v < settings.count; ++v) {
+            ViewRect box = layeredFramebuffer ? ViewRect{ 0, 0, viewWidth, viewHeight } : viewRect(v);
+            glViewportIndexedf(v, static_cast<float>(box.x), static_cast<float>(box.y), static_cast<float>(box.width),
+                               static_cast<float>(box.height));
+        }
+        glUseProgram(program);
+        glUniform1i(glGetUniformLocation(program, "firstView"), passFirst);
+        glBindBufferBase(GL_UNIFORM_BUFFER, kViewBlockBinding, viewBuffer);
+        return program;
+    }
+
+    // Restaura el viewport completo y, con capas, copia cada capa a su recuadro del destino.
+    void end() {
+        if (layeredFramebuffer && passFirst + instances() == settings.count) {
+            glBindFramebuffer(GL_READ_FRAMEBUFFER, layerFramebuffer);
+            glBindFramebuffer(GL_DRAW_FRAMEBUFFER, targetFramebuffer);
+            glViewport(0, 0, targetWidth, targetHeight);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT); // Lo que queda entre los recuadros
+            for (int v = 0; v < settings.count; ++v) {
+                glFramebufferTextureLayer(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, colorArray, 0, v);
+                ViewRect box = viewRect(v);
+                glBlitFramebuffer(0, 0, viewWidth, viewHeight, box.x, box.y, box.x + box.width, box.y + box.height,
+                                  GL_COLOR_BUFFER_BIT, GL_NEAREST);
+            }
+            glBindFramebuffer(GL_READ_FRAMEBUFFER, targetFramebuffer);
+        } else if (layeredFramebuffer) {
+            glBindFramebuffer(GL_DRAW_FRAMEBUFFER, targetFramebuffer);
+        }
+        glViewport(0, 0, targetWidth, targetHeight);
+    }
+
+    int count() const { return settings.count; }
+    int instances() const { return passCount > 0 ? passCount : settings.count; }
+    bool firstPass() const { return passFirst == 0; }
+    bool geometryShaderRouting() const { return useGeometryShader; }
+
+private:
+    struct ViewRect {
+        int x, y, width, height;
+    };
+
+    bool cube() const { return settings.count == 6; }
+
+    // Recuadro de la vista v en el destino (la fila 0 queda arriba)
+    ViewRect viewRect(int v) const {
+        int column = v % columns, row = v / columns;
+        int x = column * tileWidth + (tileWidth - viewWidth) / 2;
+        int y = (rows - 1 - row) * tileHeight + (tileHeight - viewHeight) / 2;
+        return ViewRect{ x, y, viewWidth, viewHeight };
+    }
+
+    unsigned int createArray(const char* label, GLint internalFormat, GLenum format, GLenum type, size_t texelBytes) {
+        unsigned int texture = trackedGenTexture(label);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+        glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, internalFormat, viewWidth, viewHeight, settings.count, 0, format, type, nullptr);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+        glResources.resize(GlResourceKind::Texture, texture,
+                           static_cast<size_t>(viewWidth) * viewHeight * settings.count * texelBytes);
+        return texture;
+    }
+
+    // Programa de Phong con el vertex shader de vistas (y el geometry shader si hace falta)
+    unsigned int linkProgram() const {
+        std::vector<unsigned int> shaders;
+        for (const ShaderStageFile& file : shaderFiles())
+            shaders.push_back(compileShader(file.type, file.path.c_str(), file.prefix));
+        unsigned int linked = glCreateProgram();
+        bool ok = true;
+        for (unsigned int shader : shaders) {
+            ok = ok && shader;
+            if (shader)
+                glAttachShader(linked, shader);
+        }
+        if (ok) {
+            glLinkProgram(linked);
+            int success;
+            glGetProgramiv(linked, GL_LINK_STATUS, &success);
+            if (!success) {
+                char infoLog[1024];
+                glGetProgramInfoLog(linked, sizeof(infoLog), nullptr, infoLog);
+                std::cerr << "Error al enlazar el programa de vistas: " << infoLog << std::endl;
+                ok = false;
+            }
+        }
+        for (unsigned int shader : shaders)
+            if (shader)
+                glDeleteShader(shader);
+        if (!ok) {
+            glDeleteProgram(linked);
+            return 0;
+        }
+        bindViewBlock(linked);
+        trackProgram(linked, "multiview_vertex_shader.glsl");
+        return linked;
+    }
+
+    MultiViewSettings settings;
+    bool useGeometryShader = false;
+    unsigned int program = 0, viewBuffer = 0;
+    unsigned int colorArray = 0, depthArray = 0, layeredFramebuffer = 0, layerFramebuffer = 0;
+    int targetWidth = 0, targetHeight = 0, columns = 1, rows = 1, tileWidth = 0, tileHeight = 0, viewWidth = 0, viewHeight = 0;
+    int passFirst = 0, passCount = 0;
+    GLint targetFramebuffer = 0;
+};
@@ -0,0 +1,28 @@
+#version 410 core
+// Enrutamiento de vistas para drivers sin ARB_shader_viewport_layer_array: copia el triángulo y
+// lo manda al viewport y a la capa de la vista que eligió el vertex shader.
+
+layout(triangles) in;
+layout(triangle_strip, max_vertices = 3) out;
+
+in vec3 geometryFragPos[];
+in vec3 geometryNormal[];
+in vec3 geometryColor[];
+flat in int viewIndex[];
+
+out vec3 FragPos;
+out vec3 Normal;
+out vec3 vertexColor;
+
+void main() {
+    for (int i = 0; i < 3; ++i) {
+        FragPos = geometryFragPos[i];
+        Normal = geometryNormal[i];
+        vertexColor = geometryColor[i];
+        gl_ViewportIndex = viewIndex[0];
+        gl_Layer = viewIndex[0];
+        gl_Position = gl_in[i].gl_Position;
+        EmitVertex();
+    }
+    EndPrimitive();
+}
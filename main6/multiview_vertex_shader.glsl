@@ -0,0 +1,47 @@
+#version 410 core
+// Escena en varias vistas en una sola pasada: cada dibujo se instancia una vez por vista y la
+// instancia elige su matriz del bloque ViewBlock y su viewport (o capa del framebuffer).
+// Sin ARB_shader_viewport_layer_array el enrutamiento lo hace multiview_geometry_shader.glsl;
+// entonces el código recibe VIEW_FROM_GEOMETRY_SHADER y las salidas cambian de nombre.
+#ifdef VIEW_FROM_GEOMETRY_SHADER
+#define FragPos geometryFragPos
+#define Normal geometryNormal
+#define vertexColor geometryColor
+flat out int viewIndex;
+#else
+#extension GL_ARB_shader_viewport_layer_array : require
+#endif
+
+layout(location = 0) in vec3 aPos;
+layout(location = 1) in vec3 aNormal;
+layout(location = 2) in vec3 aColor;
+
+out vec3 FragPos;
+out vec3 Normal;
+out vec3 vertexColor;
+
+layout(std140) uniform ObjectBlock {
+    mat4 model;
+    mat4 normalMatrix;
+};
+
+// Vista y proyección de cada vista (hasta 6: las caras de un cubo)
+layout(std140) uniform ViewBlock {
+    mat4 viewProjection[6];
+};
+
+uniform int firstView; // Vista de la instancia 0 (una pasada por vista usa 0, 1, 2...)
+
+void main() {
+    int view = firstView + gl_InstanceID;
+    FragPos = vec3(model * vec4(aPos, 1.0));
+    Normal = normalize(mat3(normalMatrix) * aNormal);
+    vertexColor = aColor;
+    gl_Position = viewProjection[view] * vec4(FragPos, 1.0);
+#ifdef VIEW_FROM_GEOMETRY_SHADER
+    viewIndex = view;
+#else
+    gl_ViewportIndex = view;
+    gl_Layer = view;
+#endif
+}
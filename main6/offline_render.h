@@ -0,0 +1,555 @@
+#pragma once
+// Modo de render offline: la cámara sigue una trayectoria guionizada, cada fotograma se
+// renderiza en un framebuffer fuera de pantalla y se lee de vuelta mediante un anillo de
+// pixel buffer objects (PBO) con fences. Así la lectura del fotograma N se solapa con el
+// render del fotograma N+1 en vez de detener la GPU como haría un glReadPixels síncrono.
+// Los píxeles se entregan a un hilo escritor que genera una secuencia PNG o un archivo Y4M.
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include "frame_memory.h"
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Punto de control de la trayectoria de la cámara.
+struct CameraKeyframe {
+    float time;         // Segundos desde el inicio del recorrido
+    glm::vec3 position; // Posición de la cámara
+    float yaw;          // Mismos ángulos que usa mouse_callback (en grados)
+    float pitch;
+};
+
+// Trayectoria de cámara interpolada con splines de Catmull-Rom.
+class CameraPath {
+public:
+    // Carga un archivo de texto con una línea por punto de control: "t x y z yaw pitch".
+    // Las líneas vacías o que empiezan con '#' se ignoran.
+    bool loadFromFile(const char* filepath) {
+        std::ifstream file(filepath);
+        if (!file) {
+            std::cerr << "No se pudo abrir la trayectoria de cámara: " << filepath << std::endl;
+            return false;
+        }
+        keys.clear();
+        std::string line;
+        while (std::getline(file, line)) {
+            if (line.empty() || line[0] == '#')
+                continue;
+            std::istringstream in(line);
+            CameraKeyframe key;
+            if (in >> key.time >> key.position.x >> key.position.y >> key.position.z >> key.yaw >> key.pitch)
+                keys.push_back(key);
+        }
+        if (keys.size() < 2) {
+            std::cerr << "La trayectoria necesita al menos dos puntos de control: " << filepath << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    // Recorrido por defecto: un paseo lateral frente a los triángulos de la escena.
+    static CameraPath defaultFlythrough() {
+        CameraPath path;
+        path.keys = {
+            { 0.0f, glm::vec3(-5.0f, 0.5f,  4.0f), -60.0f, -5.0f },
+            { 3.0f, glm::vec3(-1.5f, 0.2f,  3.0f), -85.0f, -8.0f },
+            { 6.0f, glm::vec3( 2.0f, 0.8f,  3.5f), -110.0f, -12.0f },
+            { 9.0f, glm::vec3( 5.5f, 1.5f,  2.0f), -140.0f, -15.0f },
+            { 12.0f, glm::vec3( 0.0f, 3.0f,  6.0f), -90.0f, -25.0f },
+        };
+        return path;
+    }
+
+    float duration() const { return keys.empty() ? 0.0f : keys.back().time; }
+
+    // Evalúa la trayectoria en el instante t y devuelve la posición y la dirección de la cámara.
+    void sample(float t, glm::vec3& position, glm::vec3& front) const {
+        size_t i = 0;
+        while (i + 2 < keys.size() && keys[i + 1].time <= t)
+            ++i;
+        const CameraKeyframe& k0 = keys[i > 0 ? i - 1 : i];
+        const CameraKeyframe& k1 = keys[i];
+        const CameraKeyframe& k2 = keys[i + 1];
+        const CameraKeyframe& k3 = keys[i + 2 < keys.size() ? i + 2 : i + 1];
+
+        float span = k2.time - k1.time;
+        float u = span > 0.0f ? glm::clamp((t - k1.time) / span, 0.0f, 1.0f) : 0.0f;
+
+        position = catmullRom(k0.position, k1.position, k2.position, k3.position, u);
+        float yaw = catmullRom(k0.yaw, k1.yaw, k2.yaw, k3.yaw, u);
+        float pitch = glm::clamp(catmullRom(k0.pitch, k1.pitch, k2.pitch, k3.pitch, u), -89.0f, 89.0f);
+
+        front.x = cos(glm::radians(yaw)) * cos(glm::radians(pitch));
+        front.y = sin(glm::radians(pitch));
+        front.z = sin(glm::radians(yaw)) * cos(glm::radians(pitch));
+        front = glm::normalize(front);
+    }
+
+private:
+    template <typename T>
+    static T catmullRom(const T& p0, const T& p1, const T& p2, const T& p3, float u) {
+        float u2 = u * u;
+        float u3 = u2 * u;
+        return 0.5f * ((2.0f * p1) + (p2 - p0) * u +
+                       (2.0f * p0 - 5.0f * p1 + 4.0f * p2 - p3) * u2 +
+                       (3.0f * p1 - p0 - 3.0f * p2 + p3) * u3);
+    }
+
+    std::vector<CameraKeyframe> keys;
+};
+
+// Framebuffer fuera de pantalla: un FBO multisample (igual que el MSAA de la ventana) que se
+// resuelve a un FBO simple de donde se leen los píxeles.
+struct OffscreenTarget {
+    int width = 0, height = 0;
+    unsigned int msaaFBO = 0, msaaColor = 0, msaaDepth = 0;
+    unsigned int resolveFBO = 0, resolveColor = 0;
+
+    bool create(int w, int h, int samples) {
+        width = w;
+        height = h;
+
+        // No todos los drivers admiten 8 muestras en un renderbuffer
+        int maxSamples = 1;
+        glGetIntegerv(GL_MAX_SAMPLES, &maxSamples);
+        samples = std::min(samples, maxSamples);
+
+        size_t msaaBytes = static_cast<size_t>(w) * h * 4 * samples;
+        msaaFBO = trackedGenFramebuffer("offline MSAA");
+        glBindFramebuffer(GL_FRAMEBUFFER, msaaFBO);
+        msaaColor = trackedGenRenderbuffer("offline color MSAA");
+        glResources.resize(GlResourceKind::Renderbuffer, msaaColor, msaaBytes);
+        glBindRenderbuffer(GL_RENDERBUFFER, msaaColor);
+        glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples, GL_RGBA8, w, h);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, msaaColor);
+        msaaDepth = trackedGenRenderbuffer("offline profundidad MSAA");
+        glResources.resize(GlResourceKind::Renderbuffer, msaaDepth, msaaBytes);
+        glBindRenderbuffer(GL_RENDERBUFFER, msaaDepth);
+        glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples, GL_DEPTH24_STENCIL8, w, h);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, msaaDepth);
+        bool ok = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+
+        resolveFBO = trackedGenFramebuffer("offline resuelto");
+        glBindFramebuffer(GL_FRAMEBUFFER, resolveFBO);
+        resolveColor = trackedGenRenderbuffer("offline color resuelto");
+        glResources.resize(GlResourceKind::Renderbuffer, resolveColor, static_cast<size_t>(w) * h * 4);
+        glBindRenderbuffer(GL_RENDERBUFFER, resolveColor);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, w, h);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, resolveColor);
+        ok = ok && glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        if (!ok) {
+            std::cerr << "El framebuffer fuera de pantalla está incompleto" << std::endl;
+            destroy();
+        }
+        return ok;
+    }
+
+    void bindForRender() const {
+        glBindFramebuffer(GL_FRAMEBUFFER, msaaFBO);
+        glViewport(0, 0, width, height);
+    }
+
+    // Resuelve el MSAA y deja el FBO resuelto enlazado como origen de lectura.
+    void resolve() const {
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, msaaFBO);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, resolveFBO);
+        glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, resolveFBO);
+    }
+
+    void destroy() {
+        trackedDeleteFramebuffer(msaaFBO);
+        trackedDeleteFramebuffer(resolveFBO);
+        trackedDeleteRenderbuffer(msaaColor);
+        trackedDeleteRenderbuffer(msaaDepth);
+        trackedDeleteRenderbuffer(resolveColor);
+    }
+};
+
+// Fotograma leído de la GPU, en RGBA8 con la primera fila abajo (convención de OpenGL).
+struct CapturedFrame {
+    int index = 0;
+    std::vector<uint8_t> rgba;
+};
+
+enum class ReadbackStatus { Ready, NotReady, Error };
+
+const int kReadbackTimeoutSeconds = 10; // Espera máxima por una lectura antes de darla por perdida
+
+// Anillo de PBOs: glReadPixels escribe en un PBO (la llamada regresa de inmediato) y un fence
+// marca cuándo la copia terminó. Solo se mapea un PBO cuando ya han pasado varios fotogramas.
+class PboReadbackRing {
+public:
+    bool create(int w, int h, int slots) {
+        width = w;
+        height = h;
+        frameBytes = static_cast<size_t>(w) * h * 4;
+        ring.resize(slots);
+        for (Slot& slot : ring) {
+            slot.pbo = trackedGenBuffer("PBO de lectura");
+            trackedBufferData(GL_PIXEL_PACK_BUFFER, slot.pbo, frameBytes, nullptr, GL_STREAM_READ);
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        return true;
+    }
+
+    bool full() const { return pending == static_cast<int>(ring.size()); }
+    bool empty() const { return pending == 0; }
+
+    // Encola la lectura asíncrona del framebuffer de lectura actual.
+    void submit(int frameIndex) {
+        Slot& slot = ring[head];
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+        glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        slot.frameIndex = frameIndex;
+        head = (head + 1) % ring.size();
+        ++pending;
+    }
+
+    // Recupera el fotograma pendiente más antiguo. Si wait es falso y la GPU aún no terminó,
+    // devuelve NotReady sin bloquear; si es verdadero espera hasta que la copia termine
+    // (kReadbackTimeoutSeconds como máximo). Error significa que el fotograma se perdió: el
+    // fence falló, se agotó la espera o el PBO no se pudo mapear.
+    ReadbackStatus collect(CapturedFrame& out, bool wait) {
+        if (pending == 0)
+            return ReadbackStatus::NotReady;
+        Slot& slot = ring[tail];
+        GLenum status = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+        for (int waited = 0; wait && status == GL_TIMEOUT_EXPIRED && waited < kReadbackTimeoutSeconds; ++waited)
+            status = glClientWaitSync(slot.fence, 0, 1000000000ull); // De a 1 s
+        if (status == GL_WAIT_FAILED) {
+            std::cerr << "Falló la espera de la lectura del fotograma " << slot.frameIndex << std::endl;
+            return ReadbackStatus::Error;
+        }
+        if (status == GL_TIMEOUT_EXPIRED) {
+            if (!wait)
+                return ReadbackStatus::NotReady;
+            std::cerr << "La lectura del fotograma " << slot.frameIndex << " no terminó en "
+                      << kReadbackTimeoutSeconds << " s" << std::endl;
+            return ReadbackStatus::Error;
+        }
+        glDeleteSync(slot.fence);
+        slot.fence = nullptr;
+
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+        void* data = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, frameBytes, GL_MAP_READ_BIT);
+        out.index = slot.frameIndex;
+        out.rgba.resize(frameBytes);
+        if (data) {
+            std::memcpy(out.rgba.data(), data, frameBytes);
+            glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        tail = (tail + 1) % ring.size();
+        --pending;
+        if (!data) {
+            std::cerr << "No se pudo mapear el PBO del fotograma " << out.index << std::endl;
+            return ReadbackStatus::Error;
+        }
+        return ReadbackStatus::Ready;
+    }
+
+    void destroy() {
+        for (Slot& slot : ring) {
+            if (slot.fence)
+                glDeleteSync(slot.fence);
+            trackedDeleteBuffer(slot.pbo);
+        }
+        ring.clear();
+    }
+
+private:
+    struct Slot {
+        unsigned int pbo = 0;
+        GLsync fence = nullptr;
+        int frameIndex = 0;
+    };
+    std::vector<Slot> ring;
+    int width = 0, height = 0;
+    size_t frameBytes = 0;
+    size_t head = 0, tail = 0;
+    int pending = 0;
+};
+
+enum class FrameFormat { PNG, Y4M };
+
+// Un patrón de nombres de PNG debe tener exactamente una conversión entera (%d o %0Nd) y nada
+// más que snprintf interprete ("%%" es un % literal): se usa como formato con el índice del
+// fotograma.
+inline bool isFramePattern(const std::string& pattern) {
+    int conversions = 0;
+    for (size_t i = 0; i < pattern.size(); ++i) {
+        if (pattern[i] != '%')
+            continue;
+        if (++i < pattern.size() && pattern[i] == '%')
+            continue;
+        if (i < pattern.size() && pattern[i] == '0')
+            ++i;
+        while (i < pattern.size() && pattern[i] >= '0' && pattern[i] <= '9')
+            ++i;
+        if (i >= pattern.size() || pattern[i] != 'd')
+            return false;
+        ++conversions;
+    }
+    return conversions == 1;
+}
+
+// Hilo escritor: recibe fotogramas del hilo de render y los codifica en disco. La cola está
+// acotada para que la memoria no crezca si el disco es más lento que el render; los buffers
+// se reciclan para no reservar memoria en cada fotograma.
+class FrameWriter {
+public:
+    FrameWriter(FrameFormat format, std::string outputPattern, int width, int height, int fps, size_t maxQueued = 8)
+        : format(format), pattern(std::move(outputPattern)), width(width), height(height), fps(fps), maxQueued(maxQueued) {
+        worker = std::thread(&FrameWriter::run, this);
+    }
+
+    ~FrameWriter() { finish(); }
+
+    // Entrega un buffer vacío (reciclado si es posible) para llenarlo con el siguiente fotograma.
+    CapturedFrame acquire() {
+        std::lock_guard<std::mutex> lock(mutex);
+        CapturedFrame frame;
+        if (!freeList.empty()) {
+            frame = std::move(freeList.back());
+            freeList.pop_back();
+        }
+        return frame;
+    }
+
+    // Encola un fotograma; bloquea si la cola está llena.
+    void push(CapturedFrame&& frame) {
+        std::unique_lock<std::mutex> lock(mutex);
+        spaceAvailable.wait(lock, [this] { return queue.size() < maxQueued; });
+        queue.push_back(std::move(frame));
+        frameAvailable.notify_one();
+    }
+
+    // Espera a que se escriban todos los fotogramas encolados.
+    void finish() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (done)
+                return;
+            done = true;
+        }
+        frameAvailable.notify_one();
+        if (worker.joinable())
+            worker.join();
+    }
+
+    int framesWritten() const { return written; }
+
+private:
+    void run() {
+        std::ofstream y4m;
+        bool y4mOk = false; // Tras un error el video queda truncado: no se escribe nada más
+        if (format == FrameFormat::Y4M) {
+            y4m.open(pattern, std::ios::binary);
+            y4m << "YUV4MPEG2 W" << width << " H" << height << " F" << fps << ":1 Ip A1:1 C444\n";
+            y4mOk = static_cast<bool>(y4m);
+            if (!y4mOk)
+                std::cerr << "No se pudo escribir el video: " << pattern << std::endl;
+        }
+        std::vector<uint8_t> scratch;
+        for (;;) {
+            CapturedFrame frame;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                frameAvailable.wait(lock, [this] { return done || !queue.empty(); });
+                if (queue.empty())
+                    break;
+                frame = std::move(queue.front());
+                queue.pop_front();
+                spaceAvailable.notify_one();
+            }
+
+            if (format == FrameFormat::PNG) {
+                char filename[512];
+                std::snprintf(filename, sizeof(filename), pattern.c_str(), frame.index);
+                if (writePng(filename, frame.rgba, scratch))
+                    ++written;
+            } else if (y4mOk) {
+                y4mOk = writeY4mFrame(y4m, frame.rgba, scratch);
+                if (y4mOk)
+                    ++written;
+                else
+                    std::cerr << "No se pudo escribir el fotograma " << frame.index << " en " << pattern << std::endl;
+            }
+
+            std::lock_guard<std::mutex> lock(mutex);
+            freeList.push_back(std::move(frame));
+        }
+    }
+
+    // PNG RGB de 8 bits con bloques deflate sin compresión: no depende de zlib y el costo es
+    // prácticamente el de copiar la memoria, así el escritor no limita el ritmo del render.
+    // Devuelve false si el archivo no quedó completo en disco.
+    bool writePng(const char* filename, const std::vector<uint8_t>& rgba, std::vector<uint8_t>& raw) {
+        size_t rowBytes = static_cast<size_t>(width) * 3 + 1;
+        raw.resize(rowBytes * height);
+        for (int y = 0; y < height; ++y) {
+            const uint8_t* src = &rgba[static_cast<size_t>(height - 1 - y) * width * 4]; // Invertir filas
+            uint8_t* dst = &raw[y * rowBytes];
+            *dst++ = 0; // Filtro "None"
+            for (int x = 0; x < width; ++x) {
+                *dst++ = src[x * 4 + 0];
+                *dst++ = src[x * 4 + 1];
+                *dst++ = src[x * 4 + 2];
+            }
+        }
+
+        std::vector<uint8_t> idat;
+        idat.reserve(raw.size() + raw.size() / 65535 * 5 + 16);
+        idat.push_back(0x78); // Cabecera zlib (deflate, ventana de 32 KB)
+        idat.push_back(0x01);
+        size_t offset = 0;
+        do {
+            size_t block = std::min<size_t>(65535, raw.size() - offset);
+            bool last = offset + block == raw.size();
+            idat.push_back(last ? 1 : 0);
+            idat.push_back(block & 0xFF);
+            idat.push_back((block >> 8) & 0xFF);
+            idat.push_back(~block & 0xFF);
+            idat.push_back((~block >> 8) & 0xFF);
+            idat.insert(idat.end(), raw.begin() + offset, raw.begin() + offset + block);
+            offset += block;
+        } while (offset < raw.size());
+        uint32_t adler = adler32(raw.data(), raw.size());
+        for (int shift = 24; shift >= 0; shift -= 8)
+            idat.push_back((adler >> shift) & 0xFF);
+
+        std::ofstream file(filename, std::ios::binary);
+        if (!file) {
+            std::cerr << "No se pudo escribir el fotograma: " << filename << std::endl;
+            return false;
+        }
+        static const uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+        file.write(reinterpret_cast<const char*>(signature), 8);
+
+        uint8_t ihdr[13];
+        putBigEndian(ihdr, width);
+        putBigEndian(ihdr + 4, height);
+        ihdr[8] = 8;  // Bits por canal
+        ihdr[9] = 2;  // Color RGB
+        ihdr[10] = 0; // Compresión deflate
+        ihdr[11] = 0; // Filtro estándar
+        ihdr[12] = 0; // Sin entrelazado
+        writeChunk(file, "IHDR", ihdr, sizeof(ihdr));
+        writeChunk(file, "IDAT", idat.data(), idat.size());
+        writeChunk(file, "IEND", nullptr, 0);
+        file.close();
+        if (!file) {
+            std::cerr << "No se pudo escribir el fotograma: " << filename << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    // Y4M con submuestreo 4:4:4 (coeficientes BT.601 de rango limitado). Vacía el buffer en cada
+    // fotograma para que un error de disco se detecte en el fotograma que lo sufrió.
+    bool writeY4mFrame(std::ofstream& file, const std::vector<uint8_t>& rgba, std::vector<uint8_t>& planes) {
+        size_t pixels = static_cast<size_t>(width) * height;
+        planes.resize(pixels * 3);
+        uint8_t* yPlane = planes.data();
+        uint8_t* uPlane = yPlane + pixels;
+        uint8_t* vPlane = uPlane + pixels;
+        for (int y = 0; y < height; ++y) {
+            const uint8_t* src = &rgba[static_cast<size_t>(height - 1 - y) * width * 4];
+            size_t row = static_cast<size_t>(y) * width;
+            for (int x = 0; x < width; ++x) {
+                int r = src[x * 4 + 0], g = src[x * 4 + 1], b = src[x * 4 + 2];
+                yPlane[row + x] = static_cast<uint8_t>(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+                uPlane[row + x] = static_cast<uint8_t>(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+                vPlane[row + x] = static_cast<uint8_t>(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+            }
+        }
+        file << "FRAME\n";
+        file.write(reinterpret_cast<const char*>(planes.data()), planes.size());
+        file.flush();
+        return static_cast<bool>(file);
+    }
+
+    static void putBigEndian(uint8_t* dst, uint32_t value) {
+        dst[0] = (value >> 24) & 0xFF;
+        dst[1] = (value >> 16) & 0xFF;
+        dst[2] = (value >> 8) & 0xFF;
+        dst[3] = value & 0xFF;
+    }
+
+    static void writeChunk(std::ofstream& file, const char* type, const uint8_t* data, size_t length) {
+        uint8_t header[8];
+        putBigEndian(header, static_cast<uint32_t>(length));
+        std::memcpy(header + 4, type, 4);
+        file.write(reinterpret_cast<const char*>(header), 8);
+        if (length)
+            file.write(reinterpret_cast<const char*>(data), length);
+        uint32_t crc = crc32(0xFFFFFFFFu, header + 4, 4);
+        if (length)
+            crc = crc32(crc, data, length);
+        uint8_t footer[4];
+        putBigEndian(footer, crc ^ 0xFFFFFFFFu);
+        file.write(reinterpret_cast<const char*>(footer), 4);
+    }
+
+    static uint32_t crc32(uint32_t crc, const uint8_t* data, size_t length) {
+        static uint32_t table[256];
+        static bool initialized = false;
+        if (!initialized) {
+            for (uint32_t n = 0; n < 256; ++n) {
+                uint32_t c = n;
+                for (int k = 0; k < 8; ++k)
+                    c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                table[n] = c;
+            }
+            initialized = true;
+        }
+        for (size_t i = 0; i < length; ++i)
+            crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+        return crc;
+    }
+
+    static uint32_t adler32(const uint8_t* data, size_t length) {
+        uint32_t a = 1, b = 0;
+        while (length > 0) {
+            size_t chunk = std::min<size_t>(length, 5552); // Máximo sin desbordar antes del módulo
+            length -= chunk;
+            while (chunk--) {
+                a += *data++;
+                b += a;
+            }
+            a %= 65521;
+            b %= 65521;
+        }
+        return (b << 16) | a;
+    }
+
+    FrameFormat format;
+    std::string pattern;
+    int width, height, fps;
+    size_t maxQueued;
+
+    std::thread worker;
+    std::mutex mutex;
+    std::condition_variable frameAvailable, spaceAvailable;
+    std::deque<CapturedFrame> queue;
+    std::vector<CapturedFrame> freeList;
+    bool done = false;
+    int written = 0; // Fotogramas completos en disco. Solo lo modifica el hilo escritor; se lee después de finish()
+};
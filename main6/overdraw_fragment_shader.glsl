@@ -0,0 +1,10 @@
+#version 330 core
+
+out vec4 FragColor;
+
+// Color del nivel de sobredibujo que se está pintando (el stencil decide qué píxeles)
+uniform vec3 levelColor;
+
+void main() {
+    FragColor = vec4(levelColor, 1.0);
+}
@@ -0,0 +1,25 @@
+#version 430 core
+
+// Paso de simulación con compute shader (OpenGL 4.3): un hilo por partícula, del buffer de
+// origen al de destino del par (ping-pong).
+
+layout(local_size_x = 256) in;
+
+struct Particle {
+    vec4 position; // Posición y edad
+    vec4 velocity; // Velocidad y vida
+};
+
+layout(std430, binding = 0) readonly buffer SourceParticles { Particle source[]; };
+layout(std430, binding = 1) writeonly buffer TargetParticles { Particle target[]; };
+
+uniform int particleCount;
+
+void main() {
+    uint index = gl_GlobalInvocationID.x;
+    if (index >= uint(particleCount))
+        return;
+    Particle particle = source[index];
+    updateParticle(particle.position, particle.velocity, index);
+    target[index] = particle;
+}
@@ -0,0 +1,18 @@
+#version 330 core
+
+// Paso de simulación con transform feedback: un vértice por partícula, sin rasterizar. El
+// resultado se escribe en el otro buffer del par (ping-pong).
+
+layout(location = 0) in vec4 inPosition; // Posición y edad
+layout(location = 1) in vec4 inVelocity; // Velocidad y vida
+
+out vec4 outPosition;
+out vec4 outVelocity;
+
+void main() {
+    vec4 position = inPosition;
+    vec4 velocity = inVelocity;
+    updateParticle(position, velocity, uint(gl_VertexID));
+    outPosition = position;
+    outVelocity = velocity;
+}
@@ -0,0 +1,49 @@
+#version 330 core
+
+// Cada billboard se sombrea como una esfera pequeña con el mismo modelo de Phong de la escena
+// (luz puntual, luz direccional y especular).
+
+in vec3 FragPos;
+in vec2 Corner;
+in vec3 vertexColor;
+
+out vec4 FragColor;
+
+uniform mat4 view;
+
+// Variables uniformes de luz y cámara (las mismas que phong_fragment_shader.glsl)
+uniform vec3 lightPos;
+uniform vec3 viewPos;
+uniform vec3 lightColor;
+uniform float ambientStrength;
+uniform float diffuseStrength;
+uniform float specularStrength;
+uniform vec3 lightDir;
+uniform vec3 pointLightPos;
+
+void main() {
+    float r2 = dot(Corner, Corner);
+    if (r2 > 1.0)
+        discard; // Fuera del disco
+
+    // Normal de la esfera en los ejes de la cámara, llevada al mundo
+    vec3 cameraRight = vec3(view[0][0], view[1][0], view[2][0]);
+    vec3 cameraUp = vec3(view[0][1], view[1][1], view[2][1]);
+    vec3 cameraBack = vec3(view[0][2], view[1][2], view[2][2]);
+    vec3 norm = normalize(cameraRight * Corner.x + cameraUp * Corner.y + cameraBack * sqrt(1.0 - r2));
+
+    vec3 ambient = ambientStrength * lightColor;
+
+    vec3 lightDirPoint = normalize(lightPos - FragPos);
+    vec3 diffusePoint = diffuseStrength * max(dot(norm, lightDirPoint), 0.0) * lightColor;
+
+    vec3 dirLightDir = normalize(-lightDir);
+    vec3 diffuseDir = max(dot(norm, dirLightDir), 0.0) * lightColor;
+
+    vec3 viewDir = normalize(viewPos - FragPos);
+    float specPoint = pow(max(dot(viewDir, reflect(-lightDirPoint, norm)), 0.0), 64.0);
+    float specDir = pow(max(dot(viewDir, reflect(-dirLightDir, norm)), 0.0), 32.0);
+    vec3 specular = specularStrength * (specPoint + specDir) * lightColor;
+
+    FragColor = vec4((ambient + diffusePoint + diffuseDir + specular) * vertexColor, 1.0);
+}
@@ -0,0 +1,61 @@
+// Simulación de una partícula, compartida por la versión con transform feedback (GLSL 3.30) y la
+// de compute shader (GLSL 4.30). No lleva #version: el cargador la inserta detrás de la línea
+// #version del shader que la usa.
+//
+// Estado: position = (posición, edad) y velocity = (velocidad, vida). Una edad negativa indica
+// que la partícula todavía no nació; al superar su vida renace en el emisor.
+
+uniform float deltaTime;
+uniform int frameSeed;        // Cambia en cada paso para que los renacimientos no se repitan
+uniform vec3 emitterPos;      // Centro del emisor
+uniform float emitterRadius;  // Radio de la esfera de emisión
+uniform vec3 gravity;
+uniform float launchSpeed;    // Velocidad inicial media
+uniform float minLifetime;
+uniform float maxLifetime;
+uniform float groundHeight;   // Altura del plano base, donde las partículas rebotan
+
+// Hash entero (PCG) a [0, 1): números aleatorios sin estado por partícula
+float random01(inout uint state) {
+    state = state * 747796405u + 2891336453u;
+    uint word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+    word = (word >> 22u) ^ word;
+    return float(word >> 8u) * (1.0 / 16777216.0);
+}
+
+void spawnParticle(inout vec4 position, inout vec4 velocity, inout uint state) {
+    // Punto uniforme en la esfera del emisor
+    vec3 offset = vec3(random01(state), random01(state), random01(state)) * 2.0 - 1.0;
+    position.xyz = emitterPos + normalize(offset + vec3(1e-4)) * emitterRadius * pow(random01(state), 1.0 / 3.0);
+    // Fuente: un cono hacia arriba con algo de dispersión en la velocidad
+    float angle = random01(state) * 6.2831853;
+    float spread = 0.35 * sqrt(random01(state));
+    vec3 direction = normalize(vec3(cos(angle) * spread, 1.0, sin(angle) * spread));
+    velocity.xyz = direction * launchSpeed * mix(0.7, 1.3, random01(state));
+    velocity.w = mix(minLifetime, maxLifetime, random01(state));
+    position.w = 0.0;
+}
+
+void updateParticle(inout vec4 position, inout vec4 velocity, uint index) {
+    uint state = index * 9781u + uint(frameSeed) * 6271u + 1u;
+    if (velocity.w <= 0.0) {
+        // Buffer recién creado (todo en cero): nacimientos escalonados para una emisión continua
+        velocity.w = maxLifetime;
+        position.w = -random01(state) * maxLifetime;
+        return;
+    }
+    bool unborn = position.w < 0.0;
+    position.w += deltaTime;
+    if (position.w < 0.0)
+        return;
+    if (unborn || position.w >= velocity.w) {
+        spawnParticle(position, velocity, state);
+        return;
+    }
+    velocity.xyz += gravity * deltaTime;
+    position.xyz += velocity.xyz * deltaTime;
+    if (position.y < groundHeight) {
+        position.y = groundHeight;
+        velocity.xyz *= vec3(0.7, -0.45, 0.7);
+    }
+}
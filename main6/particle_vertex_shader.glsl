@@ -0,0 +1,40 @@
+#version 330 core
+
+// Billboard instanciado: cuatro vértices (tira de triángulos) por partícula, con el estado de la
+// partícula como atributo por instancia. Las esquinas salen de gl_VertexID.
+
+layout(location = 0) in vec4 particlePosition; // Posición y edad
+layout(location = 1) in vec4 particleVelocity; // Velocidad y vida
+
+out vec3 FragPos;      // Posición del fragmento en el espacio del mundo
+out vec2 Corner;       // Coordenada dentro del billboard, de -1 a 1
+out vec3 vertexColor;  // Color según la edad
+
+uniform mat4 view;
+uniform mat4 projection;
+uniform float particleSize;
+
+void main() {
+    float age = particlePosition.w;
+    float life = particleVelocity.w;
+    if (age < 0.0 || age >= life) {
+        // Sin nacer: fuera del volumen de recorte, no genera fragmentos
+        gl_Position = vec4(2.0, 2.0, 2.0, 1.0);
+        FragPos = vec3(0.0);
+        Corner = vec2(0.0);
+        vertexColor = vec3(0.0);
+        return;
+    }
+    Corner = vec2(gl_VertexID & 1, gl_VertexID >> 1) * 2.0 - 1.0;
+
+    // Ejes de la cámara en el mundo: filas de la parte 3x3 de la vista
+    vec3 cameraRight = vec3(view[0][0], view[1][0], view[2][0]);
+    vec3 cameraUp = vec3(view[0][1], view[1][1], view[2][1]);
+    float t = age / life;
+    float size = particleSize * (1.0 - 0.6 * t);
+    FragPos = particlePosition.xyz + (cameraRight * Corner.x + cameraUp * Corner.y) * size;
+
+    // De amarillo al nacer a rojo oscuro al morir
+    vertexColor = mix(vec3(1.0, 0.85, 0.3), vec3(0.6, 0.1, 0.05), t);
+    gl_Position = projection * view * vec4(FragPos, 1.0);
+}
@@ -0,0 +1,203 @@
+#pragma once
+// Sistema de partículas simulado por completo en la GPU.
+//  - El estado vive en dos buffers (ping-pong): cada paso lee uno y escribe el otro. La CPU solo
+//    cambia uniforms; nunca lee ni escribe partículas después de crear los buffers.
+//  - Con OpenGL 4.3 la simulación es un compute shader; si no, un vertex shader con transform
+//    feedback y GL_RASTERIZER_DISCARD. Ambos usan la misma función (particle_update.glsl).
+//  - El dibujo es un billboard instanciado por partícula que lee el buffer recién escrito como
+//    atributo por instancia, sombreado con las luces de Phong de la escena.
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include "frame_memory.h"
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Carga y compilación de shaders (main6.cpp). prefix se inserta después de la línea #version.
+std::string loadShaderSource(const char* filepath);
+unsigned int compileShader(unsigned int type, const char* path, const std::string& prefix);
+
+struct ParticleSettings {
+    size_t count = 100000;
+    glm::vec3 emitter = glm::vec3(0.0f, -0.9f, -3.0f);
+    float emitterRadius = 0.15f;
+    glm::vec3 gravity = glm::vec3(0.0f, -4.0f, 0.0f);
+    float launchSpeed = 4.5f;
+    float minLifetime = 1.5f, maxLifetime = 3.0f;
+    float groundHeight = -1.0f;
+    float size = 0.02f;
+    bool transformFeedback = false; // Forzar transform feedback aunque haya compute shaders
+};
+
+class ParticleSystem {
+public:
+    bool create(const ParticleSettings& particleSettings) {
+        settings = particleSettings;
+        useCompute = !settings.transformFeedback && GLEW_VERSION_4_3;
+
+        // Estado inicial en cero: el primer paso escalona los nacimientos en la GPU
+        std::vector<glm::vec4> zeros(settings.count * 2, glm::vec4(0.0f));
+        for (int i = 0; i < 2; ++i) {
+            buffers[i] = trackedGenBuffer("partículas");
+            trackedBufferData(GL_ARRAY_BUFFER, buffers[i], zeros.size() * sizeof(glm::vec4), zeros.data(), GL_DYNAMIC_COPY);
+            drawVAOs[i] = trackedGenVertexArray("partículas (dibujo)");
+            bindParticleAttributes(drawVAOs[i], buffers[i], 1);
+            if (!useCompute) {
+                simulationVAOs[i] = trackedGenVertexArray("partículas (simulación)");
+                bindParticleAttributes(simulationVAOs[i], buffers[i], 0);
+            }
+        }
+        glBindVertexArray(0);
+
+        if (useCompute)
+            simulationProgram = linkProgram({ { GL_COMPUTE_SHADER, "particle_compute_shader.glsl", true } }, false);
+        else
+            simulationProgram = linkProgram({ { GL_VERTEX_SHADER, "particle_feedback_shader.glsl", true } }, true);
+        renderProgram = linkProgram({ { GL_VERTEX_SHADER, "particle_vertex_shader.glsl", false },
+                                      { GL_FRAGMENT_SHADER, "particle_fragment_shader.glsl", false } }, false);
+        if (!simulationProgram || !renderProgram) {
+            destroy();
+            return false;
+        }
+        std::cout << "Partículas: " << settings.count << " simuladas con "
+                  << (useCompute ? "compute shader" : "transform feedback") << std::endl;
+        return true;
+    }
+
+    void destroy() {
+        for (int i = 0; i < 2; ++i) {
+            trackedDeleteVertexArray(drawVAOs[i]);
+            trackedDeleteVertexArray(simulationVAOs[i]);
+            trackedDeleteBuffer(buffers[i]);
+        }
+        trackedDeleteProgram(simulationProgram);
+        trackedDeleteProgram(renderProgram);
+    }
+
+    // Un paso de simulación en la GPU: lee el buffer actual y escribe el otro.
+    void update(float deltaTime) {
+        unsigned int source = current, target = 1 - current;
+        glUseProgram(simulationProgram);
+        setSimulationUniforms(deltaTime);
+        if (useCompute) {
+            glUniform1i(glGetUniformLocation(simulationProgram, "particleCount"), static_cast<int>(settings.count));
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, buffers[source]);
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, buffers[target]);
+            glDispatchCompute(static_cast<unsigned int>((settings.count + 255) / 256), 1, 1);
+            // El dibujo y el paso siguiente leen lo escrito por el compute shader
+            glMemoryBarrier(GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+        } else {
+            glEnable(GL_RASTERIZER_DISCARD);
+            glBindVertexArray(simulationVAOs[source]);
+            glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, buffers[target]);
+            glBeginTransformFeedback(GL_POINTS);
+            glDrawArrays(GL_POINTS, 0, static_cast<int>(settings.count));
+            glEndTransformFeedback();
+            glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+            glDisable(GL_RASTERIZER_DISCARD);
+        }
+        current = target;
+        ++steps;
+    }
+
+    // Enlaza el programa de dibujo con las matrices de la cámara. Las luces las pone el llamador
+    // con los mismos uniforms que el programa de Phong.
+    unsigned int useRenderProgram(const glm::mat4& view, const glm::mat4& projection) const {
+        glUseProgram(renderProgram);
+        glUniformMatrix4fv(glGetUniformLocation(renderProgram, "view"), 1, GL_FALSE, glm::value_ptr(view));
+        glUniformMatrix4fv(glGetUniformLocation(renderProgram, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
+        glUniform1f(glGetUniformLocation(renderProgram, "particleSize"), settings.size);
+        return renderProgram;
+    }
+
+    // Un billboard (tira de 4 vértices) por partícula, sin atributos por vértice.
+    void draw() const {
+        glBindVertexArray(drawVAOs[current]);
+        glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, static_cast<int>(settings.count));
+        glBindVertexArray(0);
+    }
+
+    size_t count() const { return settings.count; }
+    bool computeShader() const { return useCompute; }
+
+private:
+    struct ShaderFile {
+        GLenum type;
+        const char* path;
+        bool simulation; // Recibe particle_update.glsl
+    };
+
+    // Posición y edad en el atributo 0, velocidad y vida en el 1 (32 bytes por partícula).
+    static void bindParticleAttributes(unsigned int vao, unsigned int buffer, unsigned int divisor) {
+        glBindVertexArray(vao);
+        glBindBuffer(GL_ARRAY_BUFFER, buffer);
+        for (unsigned int attribute = 0; attribute < 2; ++attribute) {
+            glVertexAttribPointer(attribute, 4, GL_FLOAT, GL_FALSE, 2 * sizeof(glm::vec4),
+                                  (void*)(attribute * sizeof(glm::vec4)));
+            glEnableVertexAttribArray(attribute);
+            glVertexAttribDivisor(attribute, divisor);
+        }
+    }
+
+    void setSimulationUniforms(float deltaTime) const {
+        unsigned int program = simulationProgram;
+        glUniform1f(glGetUniformLocation(program, "deltaTime"), deltaTime);
+        glUniform1i(glGetUniformLocation(program, "frameSeed"), static_cast<int>(steps));
+        glUniform3fv(glGetUniformLocation(program, "emitterPos"), 1, glm::value_ptr(settings.emitter));
+        glUniform1f(glGetUniformLocation(program, "emitterRadius"), settings.emitterRadius);
+        glUniform3fv(glGetUniformLocation(program, "gravity"), 1, glm::value_ptr(settings.gravity));
+        glUniform1f(glGetUniformLocation(program, "launchSpeed"), settings.launchSpeed);
+        glUniform1f(glGetUniformLocation(program, "minLifetime"), settings.minLifetime);
+        glUniform1f(glGetUniformLocation(program, "maxLifetime"), settings.maxLifetime);
+        glUniform1f(glGetUniformLocation(program, "groundHeight"), settings.groundHeight);
+    }
+
+    // Los shaders de simulación reciben particle_update.glsl justo después de su #version
+    // (GLSL no tiene #include).
+    static unsigned int linkProgram(const std::vector<ShaderFile>& files, bool feedback) {
+        unsigned int program = glCreateProgram();
+        std::vector<unsigned int> shaders;
+        bool ok = true;
+        for (const ShaderFile& file : files) {
+            std::string update = file.simulation ? loadShaderSource("particle_update.glsl") : std::string();
+            unsigned int shader = compileShader(file.type, file.path, update);
+            if (!shader) {
+                ok = false;
+                continue;
+            }
+            glAttachShader(program, shader);
+            shaders.push_back(shader);
+        }
+        if (feedback) {
+            const char* varyings[] = { "outPosition", "outVelocity" };
+            glTransformFeedbackVaryings(program, 2, varyings, GL_INTERLEAVED_ATTRIBS);
+        }
+        glLinkProgram(program);
+        int success;
+        glGetProgramiv(program, GL_LINK_STATUS, &success);
+        if (!success) {
+            char infoLog[1024];
+            glGetProgramInfoLog(program, sizeof(infoLog), nullptr, infoLog);
+            std::cerr << "Error al enlazar " << files[0].path << ": " << infoLog << std::endl;
+            ok = false;
+        }
+        for (unsigned int shader : shaders)
+            glDeleteShader(shader);
+        if (!ok) {
+            glDeleteProgram(program);
+            return 0;
+        }
+        trackProgram(program, files[0].path);
+        return program;
+    }
+
+    ParticleSettings settings;
+    bool useCompute = false;
+    unsigned int buffers[2] = { 0, 0 };
+    unsigned int drawVAOs[2] = { 0, 0 }, simulationVAOs[2] = { 0, 0 };
+    unsigned int simulationProgram = 0, renderProgram = 0;
+    unsigned int current = 0;
+    size_t steps = 0;
+};
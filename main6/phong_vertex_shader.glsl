@@ -8,17 +8,26 @@ out vec3 FragPos;    // Posición del fragmento en el espacio del mundo.
 out vec3 Normal;     // Normal del vértice en el espacio del mundo.
 out vec3 vertexColor; // Color del vértice
 
+// Datos por objeto: un rango del buffer de uniforms que se enlaza antes de cada dibujo
+layout(std140) uniform ObjectBlock {
+    mat4 model;
+    mat4 normalMatrix; // transpose(inverse(model)), calculada en la CPU al grabar
+};
+
 // Matrices uniformes para transformar los vértices
-uniform mat4 model;
 uniform mat4 view;
 uniform mat4 projection;
 
+// Necesario para el pre-pase de profundidad: la profundidad debe coincidir con la de
+// depth_vertex_shader.glsl para que GL_EQUAL acepte los fragmentos
+invariant gl_Position;
+
 void main() {
     // Calcular la posición del fragmento en el espacio del mundo
     FragPos = vec3(model * vec4(aPos, 1.0));
     
     // Transformar la normal al espacio del mundo, evitando deformaciones por escala no uniforme
-    Normal = normalize(mat3(transpose(inverse(model))) * aNormal);
+    Normal = normalize(mat3(normalMatrix) * aNormal);
 
     // Pasar el color del vértice al fragment shader
     vertexColor = aColor;
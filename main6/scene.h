@@ -0,0 +1,233 @@
+#pragma once
+// Almacén de escena orientado a datos: entidades con componentes guardados como estructuras
+// de arreglos (SoA). Las transformaciones forman una jerarquía padre/hijo guardada en
+// preorden, de modo que cada padre precede a sus hijos y el subárbol de una entidad ocupa un
+// rango contiguo. Solo los subárboles marcados como sucios recalculan su matriz de mundo.
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+using Entity = uint32_t;
+const Entity kNoEntity = 0xFFFFFFFFu;
+
+// Componente de transformación. Los arreglos están indexados por posición densa (preorden),
+// no por entidad; el almacén mantiene la correspondencia entre ambas.
+struct TransformPool {
+    std::vector<glm::vec3> localPosition;
+    std::vector<glm::quat> localRotation;
+    std::vector<glm::vec3> localScale;
+    std::vector<uint32_t> parent;      // Índice denso del padre (siempre menor) o kNoEntity
+    std::vector<uint32_t> subtreeEnd;  // El subárbol de i ocupa el rango [i, subtreeEnd[i])
+    std::vector<glm::mat4> world;
+    std::vector<uint8_t> dirty;
+    std::vector<Entity> owner;         // Entidad dueña de cada posición densa
+
+    size_t size() const { return owner.size(); }
+};
+
+// Componente de malla: qué rango de qué VAO dibuja la entidad y su caja envolvente local.
+struct MeshPool {
+    std::vector<Entity> owner;
+    std::vector<unsigned int> vao;
+    std::vector<int> first;
+    std::vector<int> count;
+    std::vector<glm::vec3> boundsMin;
+    std::vector<glm::vec3> boundsMax;
+
+    size_t size() const { return owner.size(); }
+};
+
+class SceneStore {
+public:
+    // Crea una entidad con transformación identidad como hija de parent (o raíz).
+    Entity createEntity(Entity parentEntity = kNoEntity) {
+        Entity entity = static_cast<Entity>(denseOf.size());
+        denseOf.push_back(static_cast<uint32_t>(transforms.size()));
+        parentOf.push_back(parentEntity);
+
+        transforms.localPosition.push_back(glm::vec3(0.0f));
+        transforms.localRotation.push_back(glm::quat(1.0f, 0.0f, 0.0f, 0.0f));
+        transforms.localScale.push_back(glm::vec3(1.0f));
+        transforms.parent.push_back(kNoEntity);
+        transforms.subtreeEnd.push_back(0);
+        transforms.world.push_back(glm::mat4(1.0f));
+        transforms.dirty.push_back(1);
+        transforms.owner.push_back(entity);
+
+        // Un hijo nuevo rompe el preorden; se reordena en la próxima actualización
+        layoutDirty = true;
+        return entity;
+    }
+
+    void addMesh(Entity entity, unsigned int vao, int first, int count, const glm::vec3& boundsMin, const glm::vec3& boundsMax) {
+        meshes.owner.push_back(entity);
+        meshes.vao.push_back(vao);
+        meshes.first.push_back(first);
+        meshes.count.push_back(count);
+        meshes.boundsMin.push_back(boundsMin);
+        meshes.boundsMax.push_back(boundsMax);
+    }
+
+    void setLocalPosition(Entity entity, const glm::vec3& position) {
+        uint32_t i = denseOf[entity];
+        transforms.localPosition[i] = position;
+        markDirty(i);
+    }
+
+    void setLocalRotation(Entity entity, const glm::quat& rotation) {
+        uint32_t i = denseOf[entity];
+        transforms.localRotation[i] = rotation;
+        markDirty(i);
+    }
+
+    void setLocalScale(Entity entity, const glm::vec3& scale) {
+        uint32_t i = denseOf[entity];
+        transforms.localScale[i] = scale;
+        markDirty(i);
+    }
+
+    const glm::vec3& localPosition(Entity entity) const { return transforms.localPosition[denseOf[entity]]; }
+    const glm::mat4& worldMatrix(Entity entity) const { return transforms.world[denseOf[entity]]; }
+
+    // Recalcula las matrices de mundo de los subárboles sucios. Devuelve cuántas matrices
+    // se recalcularon.
+    size_t updateTransforms() {
+        if (layoutDirty)
+            rebuildLayout();
+        if (dirtyList.empty())
+            return 0;
+
+        // Orden ascendente = orden topológico: un ancestro siempre aparece antes que sus
+        // descendientes, así que su rango cubre a los descendientes sucios que le siguen.
+        std::sort(dirtyList.begin(), dirtyList.end());
+        size_t recomputed = 0;
+        uint32_t coveredEnd = 0;
+        for (uint32_t root : dirtyList) {
+            if (root < coveredEnd)
+                continue;
+            uint32_t end = transforms.subtreeEnd[root];
+            for (uint32_t i = root; i < end; ++i) {
+                glm::mat4 local = composeLocal(i);
+                uint32_t p = transforms.parent[i];
+                transforms.world[i] = p == kNoEntity ? local : transforms.world[p] * local;
+                transforms.dirty[i] = 0;
+            }
+            recomputed += end - root;
+            coveredEnd = end;
+        }
+        dirtyList.clear();
+        return recomputed;
+    }
+
+    // Marca todas las entidades como sucias (útil para comparar con el recálculo completo).
+    void markAllDirty() {
+        for (uint32_t i = 0; i < transforms.size(); ++i)
+            markDirty(i);
+    }
+
+    const TransformPool& transformPool() const { return transforms; }
+    const MeshPool& meshPool() const { return meshes; }
+    uint32_t denseIndex(Entity entity) const { return denseOf[entity]; }
+    size_t entityCount() const { return denseOf.size(); }
+
+private:
+    void markDirty(uint32_t i) {
+        if (!transforms.dirty[i]) {
+            transforms.dirty[i] = 1;
+            dirtyList.push_back(i);
+        }
+    }
+
+    glm::mat4 composeLocal(uint32_t i) const {
+        // T * R * S sin multiplicar matrices completas
+        glm::mat4 m = glm::mat4_cast(transforms.localRotation[i]);
+        const glm::vec3& s = transforms.localScale[i];
+        m[0] *= s.x;
+        m[1] *= s.y;
+        m[2] *= s.z;
+        m[3] = glm::vec4(transforms.localPosition[i], 1.0f);
+        return m;
+    }
+
+    // Reordena los arreglos en preorden a partir de la relación padre/hijo por entidad.
+    void rebuildLayout() {
+        size_t count = denseOf.size();
+        std::vector<uint32_t> childStart(count + 1, 0), children(count);
+        std::vector<Entity> roots;
+        for (Entity e = 0; e < count; ++e) {
+            if (parentOf[e] == kNoEntity)
+                roots.push_back(e);
+            else
+                ++childStart[parentOf[e] + 1];
+        }
+        for (size_t e = 0; e < count; ++e)
+            childStart[e + 1] += childStart[e];
+        std::vector<uint32_t> fill(childStart.begin(), childStart.end() - 1);
+        for (Entity e = 0; e < count; ++e)
+            if (parentOf[e] != kNoEntity)
+                children[fill[parentOf[e]]++] = e;
+
+        // Recorrido en profundidad iterativo para obtener el nuevo orden
+        std::vector<Entity> order;
+        order.reserve(count);
+        std::vector<Entity> stack;
+        for (auto root = roots.rbegin(); root != roots.rend(); ++root)
+            stack.push_back(*root);
+        while (!stack.empty()) {
+            Entity e = stack.back();
+            stack.pop_back();
+            order.push_back(e);
+            for (uint32_t c = childStart[e + 1]; c > childStart[e]; --c)
+                stack.push_back(children[c - 1]);
+        }
+
+        TransformPool sorted;
+        sorted.localPosition.resize(count);
+        sorted.localRotation.resize(count);
+        sorted.localScale.resize(count);
+        sorted.parent.resize(count);
+        sorted.subtreeEnd.resize(count);
+        sorted.world.resize(count);
+        sorted.dirty.assign(count, 1);
+        sorted.owner.resize(count);
+        for (uint32_t i = 0; i < count; ++i) {
+            uint32_t old = denseOf[order[i]];
+            sorted.localPosition[i] = transforms.localPosition[old];
+            sorted.localRotation[i] = transforms.localRotation[old];
+            sorted.localScale[i] = transforms.localScale[old];
+            sorted.world[i] = transforms.world[old];
+            sorted.owner[i] = order[i];
+        }
+        for (uint32_t i = 0; i < count; ++i)
+            denseOf[order[i]] = i;
+        for (uint32_t i = 0; i < count; ++i) {
+            Entity parentEntity = parentOf[order[i]];
+            sorted.parent[i] = parentEntity == kNoEntity ? kNoEntity : denseOf[parentEntity];
+        }
+        // Fin de cada subárbol: recorrer de atrás hacia adelante propagando el máximo al padre
+        for (uint32_t i = 0; i < count; ++i)
+            sorted.subtreeEnd[i] = i + 1;
+        for (uint32_t i = static_cast<uint32_t>(count); i-- > 0;) {
+            uint32_t p = sorted.parent[i];
+            if (p != kNoEntity)
+                sorted.subtreeEnd[p] = std::max(sorted.subtreeEnd[p], sorted.subtreeEnd[i]);
+        }
+        transforms = std::move(sorted);
+
+        // Todo queda sucio: las raíces cubren la escena entera
+        dirtyList.clear();
+        for (Entity root : roots)
+            dirtyList.push_back(denseOf[root]);
+        layoutDirty = false;
+    }
+
+    TransformPool transforms;
+    MeshPool meshes;
+    std::vector<uint32_t> denseOf;  // Entidad -> posición densa en TransformPool
+    std::vector<Entity> parentOf;   // Jerarquía por entidad, estable ante reordenamientos
+    std::vector<uint32_t> dirtyList;
+    bool layoutDirty = false;
+};
@@ -0,0 +1,480 @@
+#pragma once
+// Recarga de shaders en caliente.
+//  - ShaderFileWatcher: hilo en segundo plano que vigila los archivos de shaders (inotify en
+//    Linux; en otras plataformas compara la fecha de modificación cada 250 ms), lee el archivo
+//    modificado y deja el código nuevo en una cola. El hilo de render nunca toca el disco.
+//  - ShaderReloader: máquina de estados que avanza un paso por fotograma en el hilo de render.
+//    Solo recompila la etapa cuyo código cambió y reutiliza el objeto compilado de las demás.
+//    Con KHR_parallel_shader_compile la compilación y el enlace corren en hilos del driver y se
+//    consulta GL_COMPLETION_STATUS sin bloquear; sin la extensión, el estado se consulta en el
+//    fotograma siguiente, lo que da al driver un fotograma para compilar en paralelo.
+//    Si algo falla se informa el error y el programa anterior sigue en uso. El cambio al
+//    programa nuevo ocurre entre fotogramas, escribiendo el nombre en la variable del dueño.
+//    Un programa puede tener geometry shader y un prefijo de defines por etapa, como los que
+//    arma compileShader.
+
+#include <GL/glew.h>
+#include "frame_memory.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+using ReloadClock = std::chrono::steady_clock;
+
+// Etapa de un programa recargable. prefix se inserta después de la línea #version.
+struct ShaderStageFile {
+    GLenum type;
+    std::string path;
+    std::string prefix;
+};
+
+// Código nuevo de un archivo vigilado.
+struct ShaderFileChange {
+    std::string path;
+    std::string source;
+    ReloadClock::time_point detected; // Cuando el vigilante vio el cambio
+};
+
+class ShaderFileWatcher {
+public:
+    ShaderFileWatcher() = default;
+    ShaderFileWatcher(const ShaderFileWatcher&) = delete;
+    ShaderFileWatcher& operator=(const ShaderFileWatcher&) = delete;
+
+    ~ShaderFileWatcher() { stop(); }
+
+    // Los archivos se registran antes de start().
+    void addFile(const std::string& path) {
+        for (const WatchedFile& file : files)
+            if (file.path == path)
+                return;
+        std::filesystem::path full = std::filesystem::absolute(path);
+        files.push_back({ path, full.parent_path().string(), full.filename().string(), lastWrite(path) });
+    }
+
+    bool start() {
+        if (files.empty() || worker.joinable())
+            return false;
+        running = true;
+#ifdef __linux__
+        inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (inotifyFd < 0) {
+            std::cerr << "No se pudo iniciar inotify; se vigilarán las fechas de modificación" << std::endl;
+        } else {
+            // Se vigila el directorio y no el archivo: muchos editores guardan escribiendo un
+            // archivo temporal y renombrándolo, lo que rompe una vigilancia sobre el archivo
+            for (const WatchedFile& file : files) {
+                int wd = inotify_add_watch(inotifyFd, file.directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+                if (wd >= 0)
+                    directories.push_back({ wd, file.directory });
+            }
+        }
+#endif
+        worker = std::thread([this] { run(); });
+        return true;
+    }
+
+    void stop() {
+        running = false;
+        if (worker.joinable())
+            worker.join();
+#ifdef __linux__
+        if (inotifyFd >= 0)
+            close(inotifyFd);
+        inotifyFd = -1;
+#endif
+    }
+
+    // Entrega los cambios acumulados desde la última llamada.
+    std::vector<ShaderFileChange> takeChanges() {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::vector<ShaderFileChange> taken;
+        taken.swap(pending);
+        return taken;
+    }
+
+private:
+    struct WatchedFile {
+        std::string path, directory, name;
+        std::filesystem::file_time_type modified;
+    };
+
+    static std::filesystem::file_time_type lastWrite(const std::string& path) {
+        std::error_code error;
+        auto time = std::filesystem::last_write_time(path, error);
+        return error ? std::filesystem::file_time_type() : time;
+    }
+
+    void run() {
+        while (running) {
+#ifdef __linux__
+            if (inotifyFd >= 0) {
+                waitForEvents();
+                continue;
+            }
+#endif
+            std::this_thread::sleep_for(std::chrono::milliseconds(250));
+            for (WatchedFile& file : files) {
+                auto modified = lastWrite(file.path);
+                if (modified != file.modified) {
+                    file.modified = modified;
+                    publish(file.path);
+                }
+            }
+        }
+    }
+
+#ifdef __linux__
+    // Espera eventos con un tiempo límite para poder revisar la señal de salida.
+    void waitForEvents() {
+        pollfd descriptor = { inotifyFd, POLLIN, 0 };
+        if (poll(&descriptor, 1, 100) <= 0)
+            return;
+        alignas(inotify_event) char buffer[4096];
+        ssize_t length;
+        std::vector<std::string> changed;
+        while ((length = read(inotifyFd, buffer, sizeof(buffer))) > 0) {
+            for (char* cursor = buffer; cursor < buffer + length;) {
+                const inotify_event* event = reinterpret_cast<const inotify_event*>(cursor);
+                cursor += sizeof(inotify_event) + event->len;
+                if (event->len == 0)
+                    continue;
+                const std::string* directory = nullptr;
+                for (const auto& watched : directories)
+                    if (watched.first == event->wd)
+                        directory = &watched.second;
+                for (const WatchedFile& file : files)
+                    if (directory && file.directory == *directory && file.name == event->name)
+                        changed.push_back(file.path);
+            }
+        }
+        // Un guardado suele producir varios eventos seguidos; se publica una vez por archivo
+        std::sort(changed.begin(), changed.end());
+        changed.erase(std::unique(changed.begin(), changed.end()), changed.end());
+        for (const std::string& path : changed)
+            publish(path);
+    }
+#endif
+
+    void publish(const std::string& path) {
+        ShaderFileChange change = { path, std::string(), ReloadClock::now() };
+        std::ifstream file(path);
+        if (!file)
+            return; // Renombrado a medias: llegará otro evento cuando el archivo exista
+        std::stringstream buffer;
+        buffer << file.rdbuf();
+        change.source = buffer.str();
+        std::lock_guard<std::mutex> lock(mutex);
+        pending.push_back(std::move(change));
+    }
+
+    std::vector<WatchedFile> files;
+    std::thread worker;
+    std::atomic<bool> running{ false };
+    std::mutex mutex;
+    std::vector<ShaderFileChange> pending;
+#ifdef __linux__
+    int inotifyFd = -1;
+    std::vector<std::pair<int, std::string>> directories;
+#endif
+};
+
+class ShaderReloader {
+public:
+    // Se llama con cada programa nuevo antes de usarlo (enlace de bloques de uniforms, etc.).
+    using LinkHook = std::function<void(unsigned int)>;
+
+    explicit ShaderReloader(LinkHook onLinked) : onLinked(std::move(onLinked)) {}
+
+    ShaderReloader(const ShaderReloader&) = delete;
+    ShaderReloader& operator=(const ShaderReloader&) = delete;
+
+    ~ShaderReloader() { destroy(); }
+
+    // Toma a cargo un programa ya creado a partir de estos archivos. programSlot es la variable
+    // del dueño; al recargar se escribe ahí el programa nuevo y se libera el anterior. Las etapas
+    // se compilan una vez aquí para que ya la primera recarga reutilice la que no cambió.
+    void adopt(unsigned int& programSlot, const std::string& vertexPath, const std::string& fragmentPath) {
+        adopt(programSlot, { { GL_VERTEX_SHADER, vertexPath, "" }, { GL_FRAGMENT_SHADER, fragmentPath, "" } });
+    }
+
+    // Igual, con cualquier conjunto de etapas. onProgramLinked completa la preparación propia de
+    // este programa (otros bloques de uniforms) después del enlace común.
+    void adopt(unsigned int& programSlot, const std::vector<ShaderStageFile>& files, LinkHook onProgramLinked = nullptr) {
+        Program program;
+        program.slot = &programSlot;
+        program.onLinked = std::move(onProgramLinked);
+        for (const ShaderStageFile& file : files) {
+            Stage stage;
+            stage.type = file.type;
+            stage.path = file.path;
+            stage.prefix = file.prefix;
+            program.stages.push_back(std::move(stage));
+        }
+        for (Stage& stage : program.stages) {
+            std::ifstream file(stage.path);
+            std::stringstream buffer;
+            buffer << file.rdbuf();
+            stage.wanted = buffer.str();
+            stage.shader = compileStage(stage);
+            if (stage.shader)
+                stage.source = stage.wanted;
+            watcher.addFile(stage.path);
+        }
+        programs.push_back(std::move(program));
+    }
+
+    // Empieza a vigilar. Con la extensión, el driver puede usar todos los hilos que quiera.
+    void start() {
+        parallelCompile = GLEW_KHR_parallel_shader_compile || GLEW_ARB_parallel_shader_compile;
+        if (GLEW_KHR_parallel_shader_compile)
+            glMaxShaderCompilerThreadsKHR(0xFFFFFFFFu);
+        else if (GLEW_ARB_parallel_shader_compile)
+            glMaxShaderCompilerThreadsARB(0xFFFFFFFFu);
+        watcher.start();
+        std::cout << "Recarga de shaders activa" << (parallelCompile ? " (compilación en paralelo del driver)" : "")
+                  << std::endl;
+    }
+
+    // Avanza las recargas pendientes. Se llama una vez por fotograma, antes de dibujar.
+    void update() {
+        auto start = ReloadClock::now();
+        for (ShaderFileChange& change : watcher.takeChanges())
+            for (Program& program : programs)
+                for (Stage& stage : program.stages)
+                    if (stage.path == change.path && stage.wanted != change.source) {
+                        // Guardar sin cambios no recompila nada
+                        stage.wanted = change.source;
+                        if (!program.dirty)
+                            program.detected = change.detected;
+                        program.dirty = true;
+                    }
+
+        bool inFlight = false;
+        for (Program& program : programs) {
+            if (program.phase == Phase::Idle)
+                begin(program);
+            else if (program.phase == Phase::Compiling)
+                finishCompile(program);
+            else
+                finishLink(program);
+            inFlight = inFlight || program.phase != Phase::Idle;
+        }
+
+        // Costo en el hilo de render mientras hay trabajo en vuelo: no debe producir tirones
+        if (inFlight) {
+            double seconds = std::chrono::duration<double>(ReloadClock::now() - start).count();
+            worstUpdateSeconds = std::max(worstUpdateSeconds, seconds);
+        }
+    }
+
+    void destroy() {
+        watcher.stop();
+        for (Program& program : programs) {
+            discardPending(program);
+            for (Stage& stage : program.stages)
+                if (stage.shader)
+                    glDeleteShader(stage.shader);
+        }
+        programs.clear();
+        if (reloads + failures > 0)
+            std::cout << "Recargas de shaders: " << reloads << " aplicadas, " << failures << " fallidas" << std::endl;
+        reloads = failures = 0;
+    }
+
+private:
+    enum class Phase { Idle, Compiling, Linking };
+
+    struct Stage {
+        GLenum type = 0;
+        std::string path;
+        std::string prefix;       // Defines que se insertan después de #version
+        std::string wanted;       // Último contenido visto del archivo
+        unsigned int shader = 0;  // Objeto compilado en uso (0 si el código adoptado no compiló)
+        std::string source;       // Código con el que se compiló shader
+        unsigned int pending = 0; // Objeto en compilación
+    };
+
+    struct Program {
+        unsigned int* slot = nullptr;
+        std::vector<Stage> stages;
+        LinkHook onLinked;        // Preparación propia del programa, después de la común
+        Phase phase = Phase::Idle;
+        bool dirty = false;
+        unsigned int pendingProgram = 0;
+        ReloadClock::time_point detected;       // Primer cambio aún sin compilar
+        ReloadClock::time_point issuedDetected; // Primer cambio de lo que está en vuelo
+        ReloadClock::time_point compileStart;
+    };
+
+    // Código de la etapa con su prefijo después de la línea #version, como en compileShader.
+    static void setSource(unsigned int shader, const Stage& stage) {
+        size_t versionEnd = stage.wanted.find('\n') + 1;
+        std::string header = stage.wanted.substr(0, versionEnd), body = stage.wanted.substr(versionEnd);
+        const char* strings[] = { header.c_str(), stage.prefix.c_str(), body.c_str() };
+        glShaderSource(shader, 3, strings, nullptr);
+    }
+
+    // Compilación bloqueante del código adoptado; 0 si falla (el error ya lo informó el dueño).
+    static unsigned int compileStage(const Stage& stage) {
+        unsigned int shader = glCreateShader(stage.type);
+        setSource(shader, stage);
+        glCompileShader(shader);
+        GLint success = GL_FALSE;
+        glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+        if (!success) {
+            glDeleteShader(shader);
+            return 0;
+        }
+        return shader;
+    }
+
+    bool complete(unsigned int object, bool isProgram) const {
+        if (!parallelCompile)
+            return true; // Se consulta un fotograma después de emitir el trabajo
+        GLint done = GL_FALSE;
+        if (isProgram)
+            glGetProgramiv(object, GL_COMPLETION_STATUS_KHR, &done);
+        else
+            glGetShaderiv(object, GL_COMPLETION_STATUS_KHR, &done);
+        return done == GL_TRUE;
+    }
+
+    // Emite la compilación de las etapas cuyo código difiere del compilado. Una etapa sin objeto
+    // propio (su código no compilaba al adoptarla) se compila siempre.
+    void begin(Program& program) {
+        if (!program.dirty)
+            return;
+        program.dirty = false;
+        program.issuedDetected = program.detected;
+        bool changed = false;
+        for (const Stage& stage : program.stages)
+            changed = changed || !stage.shader || stage.source != stage.wanted;
+        if (!changed)
+            return; // Se volvió al código del programa en uso
+        for (Stage& stage : program.stages) {
+            if (stage.shader && stage.source == stage.wanted)
+                continue;
+            stage.pending = glCreateShader(stage.type);
+            setSource(stage.pending, stage);
+            glCompileShader(stage.pending);
+        }
+        program.compileStart = ReloadClock::now();
+        worstUpdateSeconds = 0.0;
+        program.phase = Phase::Compiling;
+    }
+
+    void finishCompile(Program& program) {
+        for (const Stage& stage : program.stages)
+            if (stage.pending && !complete(stage.pending, false))
+                return;
+        bool ok = true;
+        for (const Stage& stage : program.stages) {
+            if (!stage.pending)
+                continue;
+            GLint success = GL_FALSE;
+            glGetShaderiv(stage.pending, GL_COMPILE_STATUS, &success);
+            if (!success) {
+                char infoLog[1024];
+                glGetShaderInfoLog(stage.pending, sizeof(infoLog), nullptr, infoLog);
+                std::cerr << "Recarga de " << stage.path << " fallida, se mantiene el programa anterior:\n"
+                          << infoLog << std::endl;
+                ok = false;
+            }
+        }
+        if (!ok) {
+            fail(program);
+            return;
+        }
+        program.pendingProgram = glCreateProgram();
+        for (const Stage& stage : program.stages)
+            glAttachShader(program.pendingProgram, stage.pending ? stage.pending : stage.shader);
+        glLinkProgram(program.pendingProgram);
+        program.phase = Phase::Linking;
+    }
+
+    void finishLink(Program& program) {
+        if (!complete(program.pendingProgram, true))
+            return;
+        GLint success = GL_FALSE;
+        glGetProgramiv(program.pendingProgram, GL_LINK_STATUS, &success);
+        if (!success) {
+            char infoLog[1024];
+            glGetProgramInfoLog(program.pendingProgram, sizeof(infoLog), nullptr, infoLog);
+            std::string paths;
+            for (const Stage& stage : program.stages)
+                paths += (paths.empty() ? "" : " + ") + stage.path;
+            std::cerr << "Enlace fallido de " << paths << ", se mantiene el programa anterior:\n" << infoLog << std::endl;
+            fail(program);
+            return;
+        }
+
+        // Cambio entre fotogramas: el siguiente dibujo ya usa el programa nuevo
+        onLinked(program.pendingProgram);
+        if (program.onLinked)
+            program.onLinked(program.pendingProgram);
+        trackProgram(program.pendingProgram, program.stages[0].path.c_str());
+        trackedDeleteProgram(*program.slot);
+        *program.slot = program.pendingProgram;
+        program.pendingProgram = 0;
+        std::string changed;
+        for (Stage& stage : program.stages) {
+            if (!stage.pending)
+                continue;
+            if (stage.shader)
+                glDeleteShader(stage.shader);
+            stage.shader = stage.pending;
+            stage.source = stage.wanted;
+            stage.pending = 0;
+            changed += (changed.empty() ? "" : ", ") + stage.path;
+        }
+        program.phase = Phase::Idle;
+        ++reloads;
+
+        auto now = ReloadClock::now();
+        std::cout << "Shader recargado (" << changed << "): "
+                  << std::chrono::duration<double, std::milli>(now - program.issuedDetected).count() << " ms desde el cambio, "
+                  << std::chrono::duration<double, std::milli>(now - program.compileStart).count()
+                  << " ms de compilación y enlace, paso más largo en el hilo de render " << worstUpdateSeconds * 1e3
+                  << " ms" << std::endl;
+    }
+
+    // Descarta el trabajo en vuelo; el programa anterior sigue en uso hasta el próximo cambio.
+    void fail(Program& program) {
+        ++failures;
+        discardPending(program);
+    }
+
+    void discardPending(Program& program) {
+        for (Stage& stage : program.stages) {
+            if (stage.pending)
+                glDeleteShader(stage.pending);
+            stage.pending = 0;
+        }
+        if (program.pendingProgram)
+            glDeleteProgram(program.pendingProgram);
+        program.pendingProgram = 0;
+        program.phase = Phase::Idle;
+    }
+
+    ShaderFileWatcher watcher;
+    std::vector<Program> programs;
+    LinkHook onLinked;
+    bool parallelCompile = false;
+    double worstUpdateSeconds = 0.0;
+    size_t reloads = 0, failures = 0;
+};
@@ -0,0 +1,598 @@
+#pragma once
+// Terreno por baldosas con LOD continuo (CDLOD) que reemplaza al plano base.
+//  - El mapa de alturas está partido en baldosas de kTerrainTileSize unidades, una por archivo
+//    (tile_X_Z.ter). Un hilo en segundo plano las lee alrededor de la cámara, de la más cercana a
+//    la más lejana, y calcula el mínimo y el máximo de cada nodo del quadtree de la baldosa.
+//  - Cada baldosa residente ocupa una textura R16 de un grupo con tope de memoria; cuando el
+//    grupo está lleno se desaloja la baldosa más lejana que ya no hace falta.
+//  - Cada fotograma se recorre el quadtree de las baldosas residentes: un nodo se dibuja entero
+//    si cae fuera del rango del nivel más fino, y si no, se baja a sus hijos. Todos los parches
+//    reutilizan la misma malla de rejilla; el vertex shader la desplaza con la altura de la
+//    textura y acerca los vértices a los del nivel siguiente cerca del borde de su rango
+//    (morphing), así no hay grietas ni saltos entre niveles.
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include "frame_memory.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <filesystem>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+const int kTerrainTileSamples = 129;     // Muestras por lado; las baldosas vecinas comparten el borde
+const float kTerrainTileSize = 64.0f;    // Unidades de mundo por lado de baldosa
+const int kTerrainLevels = 4;            // Niveles del quadtree: nodos de 8, 16, 32 y 64 unidades
+const float kTerrainLeafSize = kTerrainTileSize / (1 << (kTerrainLevels - 1));
+const int kTerrainGridSize = 16;         // Celdas por lado de la malla compartida
+const float kTerrainLodRange = 12.0f;    // Rango del nivel más fino; cada nivel dobla el anterior
+const float kTerrainMorphStart = 0.8f;   // Fracción del rango donde empieza el morphing
+
+// Cabecera de un archivo de baldosa, seguida de kTerrainTileSamples^2 alturas uint16 por filas
+// (x crece dentro de la fila, z entre filas). altura = heightMin + valor / 65535 * heightScale.
+struct TerrainTileHeader {
+    char magic[4];
+    uint32_t samples;
+    float heightMin, heightScale;
+};
+
+inline std::string terrainTilePath(const std::string& directory, int x, int z) {
+    return directory + "/tile_" + std::to_string(x) + "_" + std::to_string(z) + ".ter";
+}
+
+// Ruido de valor con fBm para generar un conjunto de baldosas de prueba.
+inline float terrainHashNoise(int x, int z) {
+    uint32_t h = static_cast<uint32_t>(x) * 374761393u + static_cast<uint32_t>(z) * 668265263u;
+    h = (h ^ (h >> 13)) * 1274126177u;
+    return static_cast<float>((h ^ (h >> 16)) & 0xFFFF) / 65535.0f * 2.0f - 1.0f;
+}
+
+inline float terrainValueNoise(float x, float z) {
+    int ix = static_cast<int>(std::floor(x)), iz = static_cast<int>(std::floor(z));
+    float fx = x - ix, fz = z - iz;
+    fx = fx * fx * (3.0f - 2.0f * fx);
+    fz = fz * fz * (3.0f - 2.0f * fz);
+    float a = terrainHashNoise(ix, iz), b = terrainHashNoise(ix + 1, iz);
+    float c = terrainHashNoise(ix, iz + 1), d = terrainHashNoise(ix + 1, iz + 1);
+    return glm::mix(glm::mix(a, b, fx), glm::mix(c, d, fx), fz);
+}
+
+// Colinas que crecen lejos de la escena: alrededor del origen el terreno queda plano a la altura
+// del antiguo plano base (y = -1) para que los triángulos sigan apoyados igual.
+inline float terrainGeneratedHeight(float x, float z) {
+    float sum = 0.0f, amplitude = 0.5f, frequency = 1.0f / 48.0f;
+    for (int octave = 0; octave < 6; ++octave) {
+        sum += amplitude * terrainValueNoise(x * frequency, z * frequency);
+        amplitude *= 0.5f;
+        frequency *= 2.0f;
+    }
+    float distance = std::sqrt(x * x + (z + 3.0f) * (z + 3.0f));
+    float t = glm::clamp((distance - 12.0f) / 30.0f, 0.0f, 1.0f);
+    float mask = t * t * (3.0f - 2.0f * t);
+    return -1.0f + mask * 14.0f * (0.5f + sum);
+}
+
+// Escribe tilesPerSide x tilesPerSide baldosas centradas en el origen.
+inline bool writeTerrainTiles(const std::string& directory, int tilesPerSide) {
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+    const float heightMin = -2.0f, heightScale = 18.0f;
+    const float spacing = kTerrainTileSize / (kTerrainTileSamples - 1);
+    std::vector<uint16_t> samples(kTerrainTileSamples * kTerrainTileSamples);
+    int first = -tilesPerSide / 2;
+    for (int tz = first; tz < first + tilesPerSide; ++tz) {
+        for (int tx = first; tx < first + tilesPerSide; ++tx) {
+            for (int j = 0; j < kTerrainTileSamples; ++j) {
+                for (int i = 0; i < kTerrainTileSamples; ++i) {
+                    float height = terrainGeneratedHeight(tx * kTerrainTileSize + i * spacing, tz * kTerrainTileSize + j * spacing);
+                    float value = glm::clamp((height - heightMin) / heightScale, 0.0f, 1.0f);
+                    samples[j * kTerrainTileSamples + i] = static_cast<uint16_t>(value * 65535.0f + 0.5f);
+                }
+            }
+            std::string path = terrainTilePath(directory, tx, tz);
+            FILE* file = std::fopen(path.c_str(), "wb");
+            if (!file) {
+                std::cerr << "No se pudo escribir la baldosa: " << path << std::endl;
+                return false;
+            }
+            TerrainTileHeader header = { { 'T', 'E', 'R', 'R' }, kTerrainTileSamples, heightMin, heightScale };
+            std::fwrite(&header, sizeof(header), 1, file);
+            std::fwrite(samples.data(), sizeof(uint16_t), samples.size(), file);
+            std::fclose(file);
+        }
+    }
+    std::cout << "Terreno: " << tilesPerSide * tilesPerSide << " baldosas de " << kTerrainTileSize << " unidades en "
+              << directory << std::endl;
+    return true;
+}
+
+struct TerrainSettings {
+    std::string directory;
+    size_t memoryCap = 8 << 20;  // Bytes de textura para baldosas residentes
+    float streamRadius = kTerrainLodRange * (1 << (kTerrainLevels - 1)) * 1.25f;
+};
+
+class TerrainSystem {
+public:
+    bool create(const TerrainSettings& terrainSettings, unsigned int terrainProgram) {
+        settings = terrainSettings;
+        program = terrainProgram;
+        if (!program)
+            return false;
+        maxSlots = std::max<size_t>(1, settings.memoryCap / tileBytes());
+
+        // Rejilla compartida como lista de triángulos, ordenada por cuadrantes: un nodo que solo
+        // dibuja algunos de sus hijos usa el tramo de cada cuadrante
+        std::vector<glm::vec2> grid;
+        grid.reserve(kTerrainGridSize * kTerrainGridSize * 6);
+        const int half = kTerrainGridSize / 2;
+        for (int quadrant = 0; quadrant < 4; ++quadrant) {
+            int x0 = (quadrant & 1) * half, z0 = (quadrant >> 1) * half;
+            for (int z = z0; z < z0 + half; ++z) {
+                for (int x = x0; x < x0 + half; ++x) {
+                    glm::vec2 a(x, z), b(x + 1, z), c(x, z + 1), d(x + 1, z + 1);
+                    grid.insert(grid.end(), { a, c, b, b, c, d });
+                }
+            }
+        }
+        gridVAO = trackedGenVertexArray("terreno (rejilla)");
+        gridVBO = trackedGenBuffer("terreno (rejilla)");
+        glBindVertexArray(gridVAO);
+        trackedBufferData(GL_ARRAY_BUFFER, gridVBO, grid.size() * sizeof(glm::vec2), grid.data(), GL_STATIC_DRAW);
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(glm::vec2), (void*)0);
+        glEnableVertexAttribArray(0);
+        glBindVertexArray(0);
+
+        loader = std::thread(&TerrainSystem::loadTiles, this);
+        std::cout << "Terreno: baldosas de " << settings.directory << ", hasta " << maxSlots << " residentes ("
+                  << maxSlots * tileBytes() / (1024.0 * 1024.0) << " MB)" << std::endl;
+        return true;
+    }
+
+    void destroy() {
+        if (loader.joinable()) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stopping = true;
+                requests.clear();
+            }
+            wake.notify_all();
+            loader.join();
+        }
+        for (Slot& slot : slots)
+            trackedDeleteTexture(slot.texture);
+        slots.clear();
+        resident.clear();
+        trackedDeleteVertexArray(gridVAO);
+        trackedDeleteBuffer(gridVBO);
+        trackedDeleteProgram(program);
+    }
+
+    // Sube las baldosas que terminó de leer el hilo y pide las que faltan alrededor de la cámara.
+    // Con waitForTiles espera hasta tener todas las necesarias (render offline reproducible).
+    void update(const glm::vec3& cameraPosition, bool waitForTiles = false) {
+        camera = cameraPosition;
+        collectWanted();
+        std::vector<LoadedTile> loaded;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            requests.clear();
+            for (const TileCoord& tile : wanted)
+                if (!resident.count(tile.key()) && !missing.count(tile.key()) && !completedKeys.count(tile.key()) &&
+                    !(loading && loadingTile == tile))
+                    requests.push_back(tile);
+            wake.notify_one();
+            if (waitForTiles)
+                tileLoaded.wait(lock, [this] { return requests.empty() && !loading; });
+            loaded.swap(completed);
+            completedKeys.clear();
+        }
+        for (LoadedTile& tile : loaded)
+            makeResident(tile);
+    }
+
+    // Enlaza el programa del terreno con las matrices de la cámara. Las luces las pone el llamador
+    // con los mismos uniforms que el programa de Phong.
+    unsigned int useProgram(const glm::mat4& view, const glm::mat4& projection) {
+        glUseProgram(program);
+        glUniformMatrix4fv(glGetUniformLocation(program, "view"), 1, GL_FALSE, glm::value_ptr(view));
+        glUniformMatrix4fv(glGetUniformLocation(program, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
+        viewProjection = projection * view;
+        return program;
+    }
+
+    // Selecciona los parches de las baldosas residentes y los dibuja con la rejilla compartida.
+    void draw() {
+        extractFrustum();
+        glActiveTexture(GL_TEXTURE0);
+        glUniform1i(glGetUniformLocation(program, "heightmap"), 0);
+        glUniform1f(glGetUniformLocation(program, "gridSize"), static_cast<float>(kTerrainGridSize));
+        glUniform1f(glGetUniformLocation(program, "tileSize"), kTerrainTileSize);
+        glUniform1f(glGetUniformLocation(program, "lodRangeFactor"), kTerrainLodRange / kTerrainLeafSize);
+        glUniform1f(glGetUniformLocation(program, "morphStart"), kTerrainMorphStart);
+        int tileLoc = glGetUniformLocation(program, "tileInfo");
+        int heightScaleLoc = glGetUniformLocation(program, "heightScale");
+        int patchLoc = glGetUniformLocation(program, "patchRect");
+        glBindVertexArray(gridVAO);
+
+        size_t vertices = 0, patchCount = 0;
+        const int quadrantVertices = kTerrainGridSize * kTerrainGridSize * 6 / 4;
+        for (auto& entry : resident) {
+            Slot& slot = slots[entry.second];
+            patches.clear();
+            glm::vec2 origin = slot.tile.origin();
+            if (!selectNode(slot, origin, kTerrainLevels - 1) && nodeVisible(slot, origin, kTerrainLevels - 1))
+                patches.push_back({ origin, kTerrainLevels - 1, 0xF }); // Más allá del último rango
+            if (patches.empty())
+                continue;
+            glBindTexture(GL_TEXTURE_2D, slot.texture);
+            glm::vec3 tileInfo(origin.x, origin.y, slot.heightMin);
+            glUniform3fv(tileLoc, 1, glm::value_ptr(tileInfo));
+            glUniform1f(heightScaleLoc, slot.heightScale);
+            for (const Patch& patch : patches) {
+                glm::vec3 rect(patch.origin.x, patch.origin.y, kTerrainLeafSize * (1 << patch.level));
+                glUniform3fv(patchLoc, 1, glm::value_ptr(rect));
+                // Un dibujo por tramo de cuadrantes consecutivos
+                for (int q = 0; q < 4;) {
+                    if (!(patch.quadrants & (1 << q))) {
+                        ++q;
+                        continue;
+                    }
+                    int first = q;
+                    while (q < 4 && (patch.quadrants & (1 << q)))
+                        ++q;
+                    glDrawArrays(GL_TRIANGLES, first * quadrantVertices, (q - first) * quadrantVertices);
+                    vertices += (q - first) * quadrantVertices;
+                }
+                ++patchCount;
+            }
+        }
+        glBindVertexArray(0);
+
+        lastVertices = vertices;
+        lastPatches = patchCount;
+        vertexSum += vertices;
+        maxVertices = std::max(maxVertices, vertices);
+        ++frames;
+    }
+
+    size_t residentTiles() const { return resident.size(); }
+    size_t residentBytes() const { return resident.size() * tileBytes(); }
+    size_t frameVertices() const { return lastVertices; }
+    size_t framePatches() const { return lastPatches; }
+
+    void report(std::ostream& out) const {
+        if (frames == 0)
+            return;
+        std::lock_guard<std::mutex> lock(mutex);
+        out << "Terreno: " << residentTiles() << " baldosas residentes (" << residentBytes() / (1024.0 * 1024.0)
+            << " de " << maxSlots * tileBytes() / (1024.0 * 1024.0) << " MB), " << loads << " cargadas en "
+            << (loads ? loadSeconds / loads * 1e3 : 0.0) << " ms en promedio, " << evictions << " desalojadas" << std::endl;
+        out << "Terreno: " << vertexSum / frames << " vértices por fotograma en promedio (máximo " << maxVertices
+            << ", último " << lastVertices << " en " << lastPatches << " parches)" << std::endl;
+    }
+
+private:
+    struct TileCoord {
+        int x, z;
+        uint64_t key() const { return (static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32) | static_cast<uint32_t>(z); }
+        glm::vec2 origin() const { return glm::vec2(x, z) * kTerrainTileSize; }
+        bool operator==(const TileCoord& other) const { return x == other.x && z == other.z; }
+    };
+
+    // Mínimo y máximo de altura de cada nodo, por nivel (nivel 0 = hojas), en unidades de mundo
+    struct NodeBounds {
+        std::vector<glm::vec2> levels[kTerrainLevels];
+    };
+
+    struct LoadedTile {
+        TileCoord tile;
+        float heightMin, heightScale;
+        std::vector<uint16_t> samples;
+        NodeBounds bounds;
+    };
+
+    struct Slot {
+        unsigned int texture = 0;
+        TileCoord tile = { 0, 0 };
+        float heightMin = 0.0f, heightScale = 0.0f;
+        NodeBounds bounds;
+        bool used = false;
+    };
+
+    struct Patch {
+        glm::vec2 origin;
+        int level;
+        unsigned quadrants; // Bit q: el cuadrante q (x = q & 1, z = q >> 1) se dibuja con este nodo
+    };
+
+    static size_t tileBytes() { return static_cast<size_t>(kTerrainTileSamples) * kTerrainTileSamples * sizeof(uint16_t); }
+
+    static float lodRange(int level) { return kTerrainLodRange * static_cast<float>(1 << level); }
+
+    // Baldosas cuyo rectángulo queda dentro del radio de carga, de la más cercana a la más lejana.
+    // No se piden más de las que caben en el tope de memoria.
+    void collectWanted() {
+        wanted.clear();
+        int reach = static_cast<int>(std::ceil(settings.streamRadius / kTerrainTileSize));
+        int cx = static_cast<int>(std::floor(camera.x / kTerrainTileSize));
+        int cz = static_cast<int>(std::floor(camera.z / kTerrainTileSize));
+        std::vector<std::pair<float, TileCoord>> candidates;
+        for (int z = cz - reach; z <= cz + reach; ++z) {
+            for (int x = cx - reach; x <= cx + reach; ++x) {
+                float distance = tileDistance({ x, z });
+                if (distance <= settings.streamRadius)
+                    candidates.push_back({ distance, { x, z } });
+            }
+        }
+        std::sort(candidates.begin(), candidates.end(),
+                  [](const std::pair<float, TileCoord>& a, const std::pair<float, TileCoord>& b) { return a.first < b.first; });
+        for (size_t i = 0; i < candidates.size() && i < maxSlots; ++i)
+            wanted.push_back(candidates[i].second);
+    }
+
+    float tileDistance(const TileCoord& tile) const {
+        glm::vec2 origin = tile.origin();
+        glm::vec2 point(camera.x, camera.z);
+        glm::vec2 nearest = glm::clamp(point, origin, origin + glm::vec2(kTerrainTileSize));
+        return glm::length(point - nearest);
+    }
+
+    // Copia la baldosa a un slot libre o al de la baldosa residente más lejana que ya no se pide.
+    void makeResident(LoadedTile& tile) {
+        if (resident.count(tile.tile.key()))
+            return;
+        bool isWanted = std::find(wanted.begin(), wanted.end(), tile.tile) != wanted.end();
+        int slotIndex = -1;
+        for (size_t i = 0; i < slots.size() && slotIndex < 0; ++i)
+            if (!slots[i].used)
+                slotIndex = static_cast<int>(i);
+        if (slotIndex < 0 && slots.size() < maxSlots) {
+            Slot slot;
+            slot.texture = trackedGenTexture("terreno (baldosa)");
+            glBindTexture(GL_TEXTURE_2D, slot.texture);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_R16, kTerrainTileSamples, kTerrainTileSamples, 0, GL_RED, GL_UNSIGNED_SHORT, nullptr);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            glResources.resize(GlResourceKind::Texture, slot.texture, tileBytes());
+            slots.push_back(std::move(slot));
+            slotIndex = static_cast<int>(slots.size() - 1);
+        }
+        if (slotIndex < 0 && isWanted) {
+            float farthest = -1.0f;
+            for (size_t i = 0; i < slots.size(); ++i) {
+                bool stillWanted = std::find(wanted.begin(), wanted.end(), slots[i].tile) != wanted.end();
+                float distance = tileDistance(slots[i].tile);
+                if (!stillWanted && distance > farthest) {
+                    farthest = distance;
+                    slotIndex = static_cast<int>(i);
+                }
+            }
+            if (slotIndex >= 0) {
+                resident.erase(slots[slotIndex].tile.key());
+                ++evictions;
+            }
+        }
+        if (slotIndex < 0)
+            return; // Llegó tarde: ya no se pide y no hay lugar libre
+
+        Slot& slot = slots[slotIndex];
+        slot.tile = tile.tile;
+        slot.heightMin = tile.heightMin;
+        slot.heightScale = tile.heightScale;
+        slot.bounds = std::move(tile.bounds);
+        slot.used = true;
+        glBindTexture(GL_TEXTURE_2D, slot.texture);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 2); // Filas de 129 muestras de 16 bits
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, kTerrainTileSamples, kTerrainTileSamples, GL_RED, GL_UNSIGNED_SHORT,
+                        tile.samples.data());
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        resident[tile.tile.key()] = slotIndex;
+    }
+
+    // Hilo de carga: toma la baldosa pedida más cercana, la lee y calcula los límites del quadtree.
+    void loadTiles() {
+        for (;;) {
+            TileCoord tile;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [this] { return stopping || !requests.empty(); });
+                if (stopping)
+                    return;
+                tile = requests.front();
+                requests.pop_front();
+                loadingTile = tile;
+                loading = true;
+            }
+            auto start = std::chrono::steady_clock::now();
+            LoadedTile loaded;
+            loaded.tile = tile;
+            bool ok = readTile(terrainTilePath(settings.directory, tile.x, tile.z), loaded);
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                loading = false;
+                if (ok) {
+                    completedKeys.insert(tile.key());
+                    completed.push_back(std::move(loaded));
+                    ++loads;
+                    loadSeconds += seconds;
+                } else {
+                    missing.insert(tile.key()); // Fuera del conjunto de datos: no se vuelve a pedir
+                }
+            }
+            tileLoaded.notify_all();
+        }
+    }
+
+    static bool readTile(const std::string& path, LoadedTile& tile) {
+        FILE* file = std::fopen(path.c_str(), "rb");
+        if (!file)
+            return false;
+        TerrainTileHeader header;
+        bool ok = std::fread(&header, sizeof(header), 1, file) == 1 && std::equal(header.magic, header.magic + 4, "TERR") &&
+                  header.samples == static_cast<uint32_t>(kTerrainTileSamples);
+        if (ok) {
+            tile.samples.resize(static_cast<size_t>(kTerrainTileSamples) * kTerrainTileSamples);
+            ok = std::fread(tile.samples.data(), sizeof(uint16_t), tile.samples.size(), file) == tile.samples.size();
+        }
+        std::fclose(file);
+        if (!ok) {
+            std::cerr << "Baldosa de terreno inválida: " << path << std::endl;
+            return false;
+        }
+        tile.heightMin = header.heightMin;
+        tile.heightScale = header.heightScale;
+
+        // Las hojas cubren sus muestras con los bordes incluidos; cada nivel combina sus 4 hijos
+        const int leaves = 1 << (kTerrainLevels - 1);
+        const int step = (kTerrainTileSamples - 1) / leaves;
+        std::vector<glm::vec2>& leafBounds = tile.bounds.levels[0];
+        leafBounds.resize(leaves * leaves);
+        for (int nz = 0; nz < leaves; ++nz) {
+            for (int nx = 0; nx < leaves; ++nx) {
+                uint16_t low = 0xFFFF, high = 0;
+                for (int j = nz * step; j <= (nz + 1) * step; ++j) {
+                    for (int i = nx * step; i <= (nx + 1) * step; ++i) {
+                        uint16_t value = tile.samples[j * kTerrainTileSamples + i];
+                        low = std::min(low, value);
+                        high = std::max(high, value);
+                    }
+                }
+                leafBounds[nz * leaves + nx] = glm::vec2(low, high) / 65535.0f * tile.heightScale + tile.heightMin;
+            }
+        }
+        for (int level = 1; level < kTerrainLevels; ++level) {
+            int side = leaves >> level, childSide = side * 2;
+            const std::vector<glm::vec2>& children = tile.bounds.levels[level - 1];
+            std::vector<glm::vec2>& nodes = tile.bounds.levels[level];
+            nodes.resize(side * side);
+            for (int nz = 0; nz < side; ++nz) {
+                for (int nx = 0; nx < side; ++nx) {
+                    glm::vec2 bounds(1e30f, -1e30f);
+                    for (int q = 0; q < 4; ++q) {
+                        glm::vec2 child = children[(nz * 2 + (q >> 1)) * childSide + nx * 2 + (q & 1)];
+                        bounds = glm::vec2(std::min(bounds.x, child.x), std::max(bounds.y, child.y));
+                    }
+                    nodes[nz * side + nx] = bounds;
+                }
+            }
+        }
+        return true;
+    }
+
+    void nodeBox(const Slot& slot, const glm::vec2& origin, int level, int index, glm::vec3& boxMin, glm::vec3& boxMax) const {
+        float size = kTerrainLeafSize * (1 << level);
+        glm::vec2 heights = slot.bounds.levels[level][index];
+        boxMin = glm::vec3(origin.x, heights.x, origin.y);
+        boxMax = glm::vec3(origin.x + size, heights.y, origin.y + size);
+    }
+
+    // Índice del nodo del nivel que empieza en origin dentro de la baldosa del slot
+    int nodeIndex(const Slot& slot, const glm::vec2& origin, int level) const {
+        float size = kTerrainLeafSize * (1 << level);
+        int side = 1 << (kTerrainLevels - 1 - level);
+        glm::vec2 local = (origin - slot.tile.origin()) / size;
+        return static_cast<int>(local.y + 0.5f) * side + static_cast<int>(local.x + 0.5f);
+    }
+
+    bool nodeVisible(const Slot& slot, const glm::vec2& origin, int level) const {
+        glm::vec3 boxMin, boxMax;
+        nodeBox(slot, origin, level, nodeIndex(slot, origin, level), boxMin, boxMax);
+        return boxInFrustum(boxMin, boxMax);
+    }
+
+    bool sphereTouchesBox(const glm::vec3& boxMin, const glm::vec3& boxMax, float radius) const {
+        glm::vec3 nearest = glm::clamp(camera, boxMin, boxMax);
+        glm::vec3 offset = camera - nearest;
+        return glm::dot(offset, offset) <= radius * radius;
+    }
+
+    // Selección de CDLOD. Devuelve false si el nodo queda fuera del rango de su nivel: entonces
+    // lo cubre su padre con la resolución del padre.
+    bool selectNode(const Slot& slot, const glm::vec2& origin, int level) {
+        glm::vec3 boxMin, boxMax;
+        nodeBox(slot, origin, level, nodeIndex(slot, origin, level), boxMin, boxMax);
+        if (!sphereTouchesBox(boxMin, boxMax, lodRange(level)))
+            return false;
+        if (!boxInFrustum(boxMin, boxMax))
+            return true; // Fuera de la vista: nadie lo dibuja
+        if (level == 0 || !sphereTouchesBox(boxMin, boxMax, lodRange(level - 1))) {
+            patches.push_back({ origin, level, 0xF });
+            return true;
+        }
+        float half = kTerrainLeafSize * (1 << (level - 1));
+        unsigned quadrants = 0;
+        for (int q = 0; q < 4; ++q) {
+            glm::vec2 child = origin + glm::vec2((q & 1) * half, (q >> 1) * half);
+            if (!selectNode(slot, child, level - 1))
+                quadrants |= 1u << q;
+        }
+        if (quadrants)
+            patches.push_back({ origin, level, quadrants });
+        return true;
+    }
+
+    // Planos del frustum (normal hacia adentro) a partir de la matriz de vista y proyección
+    void extractFrustum() {
+        const glm::mat4& m = viewProjection;
+        glm::vec4 rows[4];
+        for (int r = 0; r < 4; ++r)
+            rows[r] = glm::vec4(m[0][r], m[1][r], m[2][r], m[3][r]);
+        for (int i = 0; i < 3; ++i) {
+            frustum[i * 2] = rows[3] + rows[i];
+            frustum[i * 2 + 1] = rows[3] - rows[i];
+        }
+    }
+
+    bool boxInFrustum(const glm::vec3& boxMin, const glm::vec3& boxMax) const {
+        for (const glm::vec4& plane : frustum) {
+            glm::vec3 positive(plane.x >= 0.0f ? boxMax.x : boxMin.x, plane.y >= 0.0f ? boxMax.y : boxMin.y,
+                               plane.z >= 0.0f ? boxMax.z : boxMin.z);
+            if (glm::dot(glm::vec3(plane), positive) + plane.w < 0.0f)
+                return false;
+        }
+        return true;
+    }
+
+    TerrainSettings settings;
+    unsigned int program = 0;
+    unsigned int gridVAO = 0, gridVBO = 0;
+    size_t maxSlots = 0;
+    std::vector<Slot> slots;
+    std::unordered_map<uint64_t, int> resident; // Baldosa -> slot
+    std::vector<TileCoord> wanted;
+    std::vector<Patch> patches;
+    glm::vec3 camera = glm::vec3(0.0f);
+    glm::mat4 viewProjection = glm::mat4(1.0f);
+    glm::vec4 frustum[6];
+
+    // Compartido con el hilo de carga
+    std::thread loader;
+    mutable std::mutex mutex;
+    std::condition_variable wake, tileLoaded;
+    std::deque<TileCoord> requests;
+    TileCoord loadingTile = { 0, 0 }; // La que se está leyendo ahora
+    bool loading = false;
+    std::vector<LoadedTile> completed;
+    std::unordered_set<uint64_t> completedKeys; // Las de completed: leídas pero sin subir, no se vuelven a pedir
+    std::unordered_set<uint64_t> missing;
+    bool stopping = false;
+    size_t loads = 0;
+    double loadSeconds = 0.0;
+
+    size_t frames = 0, lastVertices = 0, lastPatches = 0, vertexSum = 0, maxVertices = 0, evictions = 0;
+};
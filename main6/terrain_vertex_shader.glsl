@@ -0,0 +1,60 @@
+#version 330 core
+
+// Parche de terreno (CDLOD): la rejilla compartida se coloca sobre el nodo, se desplaza con el
+// mapa de alturas de la baldosa y, cerca del borde del rango de su nivel, sus vértices impares se
+// acercan a los del nivel siguiente para que el cambio de nivel no deje grietas ni saltos.
+// Se combina con phong_fragment_shader.glsl.
+
+layout(location = 0) in vec2 aGrid; // Vértice de la rejilla, de 0 a gridSize
+
+out vec3 FragPos;
+out vec3 Normal;
+out vec3 vertexColor;
+
+uniform mat4 view;
+uniform mat4 projection;
+uniform vec3 viewPos;         // Cámara (la misma que usa la iluminación)
+
+uniform sampler2D heightmap;  // Alturas de la baldosa (R16 normalizado)
+uniform vec3 tileInfo;        // Origen x, z de la baldosa y altura mínima
+uniform float heightScale;    // Rango de alturas de la baldosa
+uniform float tileSize;
+uniform vec3 patchRect;       // Origen x, z del nodo y su tamaño
+uniform float gridSize;       // Celdas por lado de la rejilla
+uniform float lodRangeFactor; // Rango del nivel / tamaño del nodo
+uniform float morphStart;     // Fracción del rango donde empieza el morphing
+
+float heightAt(vec2 world) {
+    vec2 uv = (world - tileInfo.xy) / tileSize;
+    vec2 texels = vec2(textureSize(heightmap, 0));
+    uv = uv * (texels - 1.0) / texels + 0.5 / texels; // Centros de las muestras de los bordes
+    return tileInfo.z + texture(heightmap, uv).r * heightScale;
+}
+
+void main() {
+    float cellSize = patchRect.z / gridSize;
+    vec2 world = patchRect.xy + aGrid * cellSize;
+
+    // Morphing según la distancia a la cámara; el nodo de la baldosa entera no tiene nivel siguiente
+    float morphEnd = patchRect.z * lodRangeFactor;
+    float distanceToCamera = distance(viewPos, vec3(world.x, heightAt(world), world.y));
+    float morph = patchRect.z < tileSize ? clamp((distanceToCamera - morphEnd * morphStart) / (morphEnd * (1.0 - morphStart)), 0.0, 1.0) : 0.0;
+    vec2 grid = aGrid - fract(aGrid * 0.5) * 2.0 * morph;
+    world = patchRect.xy + grid * cellSize;
+
+    float height = heightAt(world);
+    FragPos = vec3(world.x, height, world.y);
+
+    // Normal por diferencias centrales sobre la separación entre muestras
+    float spacing = tileSize / (float(textureSize(heightmap, 0).x) - 1.0);
+    float left = heightAt(world - vec2(spacing, 0.0)), right = heightAt(world + vec2(spacing, 0.0));
+    float back = heightAt(world - vec2(0.0, spacing)), front = heightAt(world + vec2(0.0, spacing));
+    Normal = normalize(vec3(left - right, 2.0 * spacing, back - front));
+
+    // Pasto en lo plano y roca en las pendientes; nieve en lo alto
+    vec3 grass = vec3(0.32, 0.45, 0.22), rock = vec3(0.45, 0.42, 0.38), snow = vec3(0.9, 0.9, 0.92);
+    vertexColor = mix(grass, rock, smoothstep(0.75, 0.55, Normal.y));
+    vertexColor = mix(vertexColor, snow, smoothstep(8.0, 11.0, height) * smoothstep(0.6, 0.8, Normal.y));
+
+    gl_Position = projection * view * vec4(FragPos, 1.0);
+}